@@ -203,8 +203,7 @@ void AccelerationTestWidget::display(double speed)
             m_carMoving = false; /* Turn this off to prevent going into previous if block */
 
             m_accelerationTime = m_time->elapsed(); /* Capture the elapsed time */
-            m_kernel->stopMonitoring();             /* Stop the serial thread and ELM327 reading the speed from ECU */
-            removeSensor();                         /* Remove the speed sensor, 010D */
+            removeSensor();                         /* Unsubscribe from the speed sensor, 010D */
 
             /*
                 Display the elapsed time. Remember speed in milliseconds, so convert to seconds.
@@ -239,8 +238,7 @@ void AccelerationTestWidget::startTest()
     {
         /* If in here, the test was running so stop the test and do some cleaning up */
 
-        m_kernel->stopMonitoring(); /* Stop the serial I/O thread */
-        removeSensor();             /* Remove sensor from serial thread */
+        removeSensor();             /* Unsubscribe from the speed sensor */
 
         /* Do some status updates and change text of start/stop button */
         emit changeStatus(tr("Acceleration Test Cancelled!"));
@@ -257,16 +255,10 @@ void AccelerationTestWidget::startTest()
     else
     {
         /*
-           If in here, we are starting the test. First of all ensure that some other widget is not
-           already using the serial thread. If so abort starting this test letting the user know in the status
+           If in here, we are starting the test. Other widgets may be polling at the same time, the speed
+           sensor is shared with them
         */
 
-        if (m_kernel->isMonitoring())
-        {
-            emit changeStatus(tr("Automon is currently busy with another task. Stop this first"));
-            return;
-        }
-
         /* If we done test before, the time would be green. Reset to 0 */
         m_accelerationTimeDisplay->setStyleSheet("color: beige");
 
@@ -274,8 +266,12 @@ void AccelerationTestWidget::startTest()
         m_testFinished = false;
         m_testStarted = false;
 
-        /* Add the sensor to the serial I/O thread */
-        setUpSensor();
+        /* Subscribe to the speed sensor. This starts the polling if nobody else is */
+        if (!setUpSensor())
+        {
+            emit changeStatus(tr("Speed sensor could not be added. Exiting!"));
+            return;
+        }
 
         /* If we done a test before, the m_time would be further on than 0. Reset */
         m_time->restart();
@@ -285,14 +281,6 @@ void AccelerationTestWidget::startTest()
         m_accelerationTime = 0.0;
         m_speed->display(0);
 
-        /* Start the serial I/O thread */
-        if (!m_kernel->startMonitoring())
-        {
-            /* We should not get in here since the check was done above. Just incase however */
-            emit changeStatus(tr("Failed to start serial thread. This is an exception! Restart the device."));
-            return;
-        }
-
         /* Disable the spinbox */
         m_destinationSpeed->setEnabled(false);
 
@@ -309,30 +297,23 @@ void AccelerationTestWidget::startTest()
 void AccelerationTestWidget::removeSensor()
 {
     /*
-      This method is responsible for removing the Speed sensor from the serial I/O thread
+      This method is responsible for unsubscribing from the Speed sensor. It stays polled if someone else uses it
     */
-    if (m_kernel->disconnectSensorFromSlot(m_kernel->getActiveSensorByCommand("010D"),this))
-    {
-        m_kernel->removeActiveSensorByCommand("010D");
-    }
-    else
+    if (!m_kernel->unsubscribe(this, "010D"))
         qDebug() << "Sensor not present";
 
 }
 
-void AccelerationTestWidget::setUpSensor()
+bool AccelerationTestWidget::setUpSensor()
 {
     /*
-      This method is responsible for adding the speed sensor to the serial I/O thread
+      This method is responsible for subscribing our display(double) slot to the speed sensor.
+      Rate 0 so it gets updated ASAP, and a high priority since the timing depends on it
     */
 
-    if(m_kernel->addActiveSensorByCommand("010D"))
-    {
-        /* Connect the sensor to the slot in this method, display(double) */
-        m_kernel->connectSensorToSlot(m_kernel->getActiveSensorByCommand("010D"),this);
-        /* Set frequency so gets updated ASAP */
-        m_kernel->setSensorFrequency(m_kernel->getActiveSensorByCommand("010D"), 1);
-    }
-    else
-        qDebug() << "Command not supported by ECU";
+    if (m_kernel->subscribe(this, "010D", 0, 10))
+        return true;
+
+    qDebug() << "Command not supported by ECU";
+    return false;
 }
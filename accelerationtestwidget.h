@@ -63,7 +63,7 @@ signals:
     void changeStatus(const QString & status);
 
 private:
-    void setUpSensor();
+    bool setUpSensor();
     void removeSensor();
     QLabel * m_header;
     QHBoxLayout * m_mainLayout;
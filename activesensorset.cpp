@@ -30,34 +30,71 @@
     
 */
 
+
 #include "automon.h"
 
 using namespace AutomonKernel;
 
-FuelPressure::FuelPressure(QString command, QString englishMeaning)
+ActiveSensorSet::ActiveSensorSet()
 {
-    m_command = command;
-    m_englishMeaning = englishMeaning;
 }
 
-FuelPressure::FuelPressure()
+bool ActiveSensorSet::add(Sensor * sensor)
 {
-    m_command = "010A";
-    m_englishMeaning = "Fuel Pressure";
-    setUnits(KPA);
-    setExpectedBytes(1);
-    setMin(0);
-    setMax(765);
+    /* Publish a new list with the sensor added. A sensor is only ever in the set once */
+
+    QMutexLocker locker(&m_lock);
+
+    if (sensor == NULL || m_sensors.contains(sensor))
+        return false;
+
+    /* Copy, change the copy, then swap it in. Snapshots already taken keep the old list */
+    QList<Sensor*> sensors = m_sensors;
+    sensors.append(sensor);
+    m_sensors = sensors;
+
+    return true;
 }
 
-double FuelPressure::convertResult()
+bool ActiveSensorSet::removeByCommand(QString command)
 {
-    /* This is the conversion formula. It basically returns the value from the bytes retrieved from the ECU */
+    /* Publish a new list without the sensor whose command/pid matches */
 
-    QList<int> bytes = Automon::getBytes(*this);
+    QMutexLocker locker(&m_lock);
 
-    double value = (bytes[2]*3);
+    for (int i = 0; i < m_sensors.size(); i++)
+    {
+        if (command.compare(m_sensors.at(i)->getCommand()) == 0)
+        {
+            QList<Sensor*> sensors = m_sensors;
+            sensors.removeAt(i);
+            m_sensors = sensors;
+            return true;
+        }
+    }
 
-    return value;
+    return false;
+}
 
+void ActiveSensorSet::clear()
+{
+    /* Publish an empty list */
+    QMutexLocker locker(&m_lock);
+    m_sensors = QList<Sensor*>();
+}
+
+QList<Sensor*> ActiveSensorSet::snapshot() const
+{
+    /*
+        Return the current list. The caller gets its own shallow copy which stays the same no matter what
+        is added or removed afterwards
+    */
+    QMutexLocker locker(&m_lock);
+    return m_sensors;
+}
+
+bool ActiveSensorSet::isEmpty() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_sensors.isEmpty();
 }
@@ -0,0 +1,69 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef ACTIVESENSORSET_H
+#define ACTIVESENSORSET_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include "sensor.h"
+
+namespace AutomonKernel
+{
+    /*
+        The ActiveSensorSet holds the sensors the serial thread polls. It works copy on write: a change builds
+        a new list and publishes it in one go, and the serial thread takes a snapshot of the published list
+        once per polling round. QList is implicitly shared, so a snapshot only costs a reference count and the
+        serial thread never sees a list half way through a change. The mutex is only held for the swap or
+        the copy of the list header, never while a round is polled.
+    */
+
+    class ActiveSensorSet
+    {
+    public:
+        ActiveSensorSet();
+        bool add(Sensor * sensor);
+        bool removeByCommand(QString command);
+        void clear();
+        QList<Sensor*> snapshot() const;
+        bool isEmpty() const;
+
+    private:
+        QList<Sensor*> m_sensors;
+        mutable QMutex m_lock;
+    };
+}
+
+#endif // ACTIVESENSORSET_H
@@ -0,0 +1,244 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+#include <QSettings>
+#include <QThread>
+#ifndef Q_OS_ANDROID // [LA] Cross-compile to get this up and running
+#include <QSerialPortInfo>
+#endif
+
+using namespace AutomonKernel;
+
+/*
+    Baud rates to probe, most likely first. Nearly every adapter ships at 38400. The ones SerialHelper::negotiateBaudRate()
+    raises the link to are in here too, for an adapter left there when Automon lost power
+*/
+static const int probeBaudRates[] = { 38400, 115200, 500000, 230400, 9600, 57600 };
+
+QString AdapterDiscovery::findAdapter(QString preferredPort)
+{
+    /* Use the adapter from last time if it still answers, otherwise search every port for one */
+
+    QSettings settings("Automon", "Automon");
+    QString cached = settings.value("Discovery/LastAdapter").toString();
+
+    if (!cached.isEmpty() && probe(cached))
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "Using cached adapter" << cached;
+#endif
+        return cached;
+    }
+
+    QString found = discover(candidatePorts(preferredPort));
+
+    if (found.isEmpty())
+    {
+        /* Nothing answered. The adapter may still be asleep, so leave it to the normal open and init */
+        forget();
+        return fallbackPort(preferredPort);
+    }
+
+    settings.setValue("Discovery/LastAdapter", found);
+    return found;
+}
+
+QString AdapterDiscovery::discover(QStringList ports)
+{
+    /*
+        Open every port and send ATI to all of them, then collect whatever comes back until a port answers
+        or the probe times out. Try again at the next baud rate with the ports that are left.
+    */
+
+    QList<SerialTransport*> transports;
+
+    foreach (QString port, ports)
+    {
+        SerialTransport * transport = new SerialTransport(port);
+
+        if (transport->open())
+            transports.append(transport);
+        else
+            delete transport;
+    }
+
+    QString found;
+
+    for (unsigned int i = 0; i < sizeof(probeBaudRates) / sizeof(probeBaudRates[0]) && found.isEmpty(); i++)
+    {
+        QList<QByteArray> responses;
+
+        foreach (SerialTransport * transport, transports)
+        {
+            transport->setBaudRate(probeBaudRates[i]);
+            transport->discardInput();
+            transport->write("ATI\r", 4);
+            responses.append(QByteArray());
+        }
+
+        QTime timer;
+        timer.start();
+
+        while (found.isEmpty() && timer.elapsed() < PROBETIMEOUT)
+        {
+            for (int t = 0; t < transports.count() && found.isEmpty(); t++)
+            {
+                char buffer[64];
+                qint64 bytes;
+
+                while ((bytes = transports[t]->read(buffer, sizeof(buffer))) > 0)
+                    responses[t].append(buffer, bytes);
+
+                if (answersLikeElm(responses[t]))
+                    found = transports[t]->getUri();
+            }
+
+            QThread::msleep(1);
+        }
+    }
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Probed" << transports.count() << "port(s) in parallel, found" << (found.isEmpty() ? "nothing" : found);
+#endif
+
+    qDeleteAll(transports);
+    return found;
+}
+
+bool AdapterDiscovery::probe(QString uri)
+{
+    /* One quick ATI on a single port, so a cached adapter is checked without searching */
+
+    if (!uri.startsWith("serial://"))
+        return false;
+
+    Transport * transport = Transport::create(uri);
+    bool answered = false;
+
+    if (transport->open())
+    {
+        transport->discardInput();
+        transport->write("ATI\r", 4);
+
+        QByteArray response;
+        QTime timer;
+        timer.start();
+
+        while (!answered && timer.elapsed() < PROBETIMEOUT)
+        {
+            char buffer[64];
+            qint64 bytes;
+
+            while ((bytes = transport->read(buffer, sizeof(buffer))) > 0)
+                response.append(buffer, bytes);
+
+            answered = answersLikeElm(response);
+            QThread::msleep(1);
+        }
+    }
+
+    delete transport;
+    return answered;
+}
+
+void AdapterDiscovery::forget()
+{
+    /* Drop the cached adapter, eg: when it was moved to another port */
+
+    QSettings settings("Automon", "Automon");
+    settings.remove("Discovery/LastAdapter");
+}
+
+void AdapterDiscovery::remember(QString uri)
+{
+    /* The cached adapter is now on this URI, eg: at the rate ATBRD moved it to. Other transports are left alone */
+
+    QSettings settings("Automon", "Automon");
+    QString cached = settings.value("Discovery/LastAdapter").toString();
+
+    if (cached.isEmpty() || cached.section('?', 0, 0) != uri.section('?', 0, 0))
+        return;
+
+    settings.setValue("Discovery/LastAdapter", uri);
+}
+
+QStringList AdapterDiscovery::candidatePorts(QString preferredPort)
+{
+    /* The preferred port goes first, then anything else the system has */
+
+    QStringList ports;
+    ports << (preferredPort.startsWith("/") ? preferredPort : "/dev/" + preferredPort);
+
+#ifndef Q_OS_ANDROID
+    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        if (!ports.contains(info.systemLocation()))
+            ports << info.systemLocation();
+    }
+#endif
+
+    return ports;
+}
+
+QString AdapterDiscovery::fallbackPort(QString preferredPort)
+{
+    /* What Automon always did: an FTDI adapter overrides the default port */
+
+    QString port = preferredPort;
+
+#ifndef Q_OS_ANDROID
+    // Override the default port, if it finds something connected to a different port [LA]
+    qDebug() << "**********Populating Serial Port(s)*************";
+
+    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        qDebug() << "Name        : " << info.portName();
+        qDebug() << "Description : " << info.description();
+        qDebug() << "Product ID : "  << info.productIdentifier();
+        qDebug() << "Manufacturer: " << info.manufacturer();
+
+        if( info.manufacturer() == "FTDI")
+            port = info.systemLocation();
+    }
+#endif
+
+    return "serial://" + port;
+}
+
+bool AdapterDiscovery::answersLikeElm(const QByteArray & response)
+{
+    /* Clones all say ELM327 somewhere in the ATI reply, and only a finished reply has the prompt */
+    return response.contains("ELM") && response.contains('>');
+}
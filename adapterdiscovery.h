@@ -0,0 +1,72 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef ADAPTERDISCOVERY_H
+#define ADAPTERDISCOVERY_H
+
+#include <QString>
+#include <QStringList>
+
+namespace AutomonKernel
+{
+    /*
+        AdapterDiscovery finds the port the ELM327 is on. Every candidate port is opened at once and sent ATI
+        at each baud rate an adapter is likely to use, the first port to answer like an ELM wins. The ports are
+        all probed together with non-blocking reads, so a dead port costs the same as a live one instead of a
+        timeout each.
+
+        The winner is stored as a transport URI, so the next start only has to check that adapter still
+        answers instead of searching again. The URI carries the baud rate, and is updated when the rate is
+        negotiated up, so an adapter left on a raised rate is checked at that rate.
+    */
+
+    class AdapterDiscovery
+    {
+    public:
+        static QString findAdapter(QString preferredPort);
+        static QString discover(QStringList ports);
+        static bool probe(QString uri);
+        static void forget();
+        static void remember(QString uri);
+
+        enum { PROBETIMEOUT = 300 }; /* An ELM327 answers ATI in well under this at any speed */
+
+    private:
+        static QStringList candidatePorts(QString preferredPort);
+        static QString fallbackPort(QString preferredPort);
+        static bool answersLikeElm(const QByteArray & response);
+    };
+}
+
+#endif // ADAPTERDISCOVERY_H
@@ -36,20 +36,39 @@ using namespace AutomonKernel;
 
 
 /*
-    This is a quick class definition of a Thread that is used for sleep purposes.
-    It has a static method, msleep. This allows us to sleep the main thread when we want,
-    by classing SleeperThread::msleep(ms);
+    The steps of bringing up the ELM327 and the OBD bus. Each step moves on as soon as the ELM327 prints its
+    prompt, to the next state if the response held what was expected, otherwise to the failure state.
+    A warm adapter that still answers ATI only gets its defaults restored, which is much quicker than ATZ.
+    The protocol of the vehicle profile is forced once the resets are done, since ATZ and ATD undo it. If
+    the forced protocol doesn't connect, the ELM327 goes back to searching for one.
 */
 
-class SleeperThread : public QThread
+enum InitState { ProbeAdapter, ResetAdapter, SetDefaults, EchoOff, AdaptiveTiming, SetProtocol, SearchProtocol, ConnectBus,
+                 InitDone, InitFailed };
+
+struct InitStep
 {
-public:
-    static void msleep(unsigned long msecs)
-    {
-        QThread::msleep(msecs);
-    }
+    InitState state;
+    const char * command;
+    const char * expect;    /* Text the response must hold, spaces removed */
+    int timeout;            /* ms to wait for the prompt */
+    int attempts;
+    InitState next;
+    InitState onFailure;
+    const char * description;
 };
 
+static const InitStep initSteps[] =
+{
+    { ProbeAdapter,   "ATI",   "ELM",  300,   1, SetDefaults,    ResetAdapter, "Checking adapter" },
+    { ResetAdapter,   "ATZ",   "ELM",  3000,  2, EchoOff,        InitFailed,   "Resetting adapter" },
+    { SetDefaults,    "ATD",   "OK",   500,   1, EchoOff,        ResetAdapter, "Restoring adapter defaults" },
+    { EchoOff,        "ATE0",  "OK",   500,   2, AdaptiveTiming, InitFailed,   "Turning off echo" },
+    { AdaptiveTiming, "ATAT2", "OK",   500,   1, SetProtocol,    SetProtocol,  "Setting adaptive timing" },
+    { SetProtocol,    "ATSP",  "OK",   500,   1, ConnectBus,     ConnectBus,   "Setting vehicle protocol" },
+    { SearchProtocol, "ATSP0", "OK",   500,   1, ConnectBus,     ConnectBus,   "Searching for protocol" },
+    { ConnectBus,     "0100",  "4100", 10000, 2, InitDone,       InitFailed,   "Connecting to ECU" }
+};
 
 Automon::Automon(QString port)
 {
@@ -57,106 +76,378 @@ Automon::Automon(QString port)
         The Automon interface constructor. Here we set up the DTC helper and Serial helper classes.
         We also initialise important variables.
 
-        The seiral helper is passed the port address. This defaults to /dev/ttyUSB0 if not specified
+        The seiral helper is passed the port address. This defaults to /dev/ttyUSB0 if not specified.
+        The port can also be a transport URI, eg: tcp://192.168.0.10:35000 for a WiFi ELM327
     */
 
     m_serialHelper = new SerialHelper(port);
+    setUpHelpers();
+}
+
+Automon::Automon(Transport * transport)
+{
+    /* Same as above, but talks to the ELM327 over a transport created by the caller. Automon takes ownership */
+
+    m_serialHelper = new SerialHelper(transport);
+    setUpHelpers();
+}
+
+void Automon::setUpHelpers()
+{
+    /* Set up the helpers that sit on top of the serial helper. Shared by both constructors */
+
     m_dtcHelper = new DTCHelper(m_serialHelper);
 
+    /* Several consumers can subscribe to sensors at the same time. The polling runs while anyone is subscribed */
+    m_subscriptions = new SubscriptionManager(m_serialHelper, this);
+    connect(m_subscriptions, SIGNAL(pollSetChanged()), this, SLOT(updateMonitoringState()));
+
+    /* A sensor nobody subscribes to any more may still have been added with addActiveSensor() */
+    connect(m_subscriptions, SIGNAL(sourceReleased(Sensor*)), this, SLOT(releaseSource(Sensor*)));
+
+    /* All active rules are evaluated by the one engine */
+    m_ruleEngine = new RuleEngine(this);
+
+    /* Sensor values can be recorded to backtest rules on */
+    m_sessionRecorder = new SessionRecorder(this);
+
     m_isMonitoring = false; /* Used to determine if Automon in monitoring state */
     m_milOn = false;        /* Default to Malfunction Indicator Lamp off */
+    m_busInitTime = -1;
+    m_profileChecks = 0;
 }
 
 bool Automon::isMonitoring() const
 {
     /*
         This method is called outside of the Automon Kernel to determine if the Serial I/O
-        thread is currently active, in which case, it must be stopped before another task can use it
+        thread is currently polling sensors, either started with startMonitoring() or for subscribers
     */
 
-    return m_isMonitoring;
+    return m_isMonitoring || m_subscriptions->hasSubscriptions();
 }
 
-QList<int> Automon::getBytes(Command & command)
+void Automon::updateMonitoringState()
+{
+    /* Poll sensors while monitoring was started or while anyone is subscribed to a sensor */
+    m_serialHelper->setMonitoring(isMonitoring());
+}
+
+bool Automon::subscribe(QObject * subscriber, QString pid, double rate, int priority)
 {
     /*
-        This method is used to grab an array of Integer bytes from the command executed by
-        the serial I/O thread. The serial I/O thread will populate the command's buffer with
-        hexidecimal ASCII. This has to be converted to integers so that sensors
-        can do the neccessary formula conversions in order to obtain the result.
+        This method subscribes the receiver's display(double) slot to a sensor. Many receivers can subscribe to
+        the same sensor. The sensor is polled once at the highest rate asked for and every subscriber gets the
+        values. Polling starts with the first subscription, no need to call startMonitoring().
+        A rate of 0 means as fast as possible. Higher priority sensors keep their rate when the bus is full.
     */
 
-    QList<int> result;
+    Sensor * sensor = getSensorByCommand(pid);
 
-    /* First grab the buffer the was populated by the Serial I/O thread and the ELM327 chip */
-    QString bufferResponse = command.getBuffer();
+    if (sensor == NULL)
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "Could not subscribe to" << pid << "since no such sensor exists";
+#endif
+        return false;
+    }
 
-    /* Remove any spaces in the response using a regular expression */
-    QRegExp removeSpaces( " " );
-    bufferResponse.replace(removeSpaces, "");
+    return m_subscriptions->subscribe(subscriber, sensor, rate, priority);
+}
 
-    /* Remove the line break at the end that is sent back by the ELM327 */
-    QRegExp removeLineBreak( "\x0D" );
-    bufferResponse.replace(removeLineBreak, "");
+bool Automon::unsubscribe(QObject * subscriber, QString pid)
+{
+    /* Take the receiver off the sensor. Polling stops with the last subscription */
+    return m_subscriptions->unsubscribe(subscriber, getSensorByCommand(pid));
+}
+
+void Automon::unsubscribeAll(QObject * subscriber)
+{
+    /* Take the receiver off every sensor it subscribed to */
+    m_subscriptions->unsubscribeAll(subscriber);
+}
 
-    /* Create a list of String bytes. */
-    QList<QString> bytes;
+bool Automon::isSubscribed(QObject * subscriber, QString pid) const
+{
+    /* True if the receiver is subscribed to the sensor */
+    return m_subscriptions->isSubscribed(subscriber, getSensorByCommand(pid));
+}
 
-    /* Ensure that the > character is at the end of the response. This is always sent by the ELM327 */
-    if (bufferResponse.at(bufferResponse.size()-1) != '>')
+int Automon::activateRule(int ruleId)
+{
+    /*
+        This method activates a rule of the catalogue by its id, named by its English label. The rule was
+        compiled when the rules file was loaded, the engine takes a copy of it. Returns -1 if there's no such
+        rule, it doesn't compile, or one of its sensors doesn't exist.
+    */
+
+    const RuleProgram * program = m_ruleCatalogue.getProgram(ruleId);
+
+    if (program == NULL)
+        return -1;
+
+    QStringList sensorsInRule = m_ruleCatalogue.getSensors(ruleId);
+    QList<Sensor*> sensors;
+
+    for (int i = 0; i < sensorsInRule.size(); i++)
+        sensors.append(getSensorByCommand(sensorsInRule.at(i)));
+
+    return m_ruleEngine->addRule(*program, m_ruleCatalogue.getEnglishName(ruleId), sensors);
+}
+
+int Automon::activateRule(QString rule, QString ruleName)
+{
+    /*
+        This method starts evaluating the rule against the values of its sensors. The sensors aren't polled for
+        the rule, subscribe to them first. When the rule becomes satisfied the slots connected with
+        connectRulesToSlot() get its name. Returns an id for deactivateRule(), or -1 if the rule has an error.
+    */
+
+    QStringList sensorsInRule = extractSensorsFromRule(rule);
+    QList<Sensor*> sensors;
+
+    for (int i = 0; i < sensorsInRule.size(); i++)
+        sensors.append(getSensorByCommand(sensorsInRule.at(i)));
+
+    return m_ruleEngine->addRule(rule, ruleName, sensors);
+}
+
+bool Automon::deactivateRule(int id)
+{
+    /* Stop evaluating a rule started with activateRule() */
+    return m_ruleEngine->removeRule(id);
+}
+
+QString Automon::getActiveRule(int id) const
+{
+    /* The rule string of an active rule, ie: s010C > 4000 */
+    return m_ruleEngine->getRule(id);
+}
+
+bool Automon::connectRulesToSlot(QObject * receiver)
+{
+    /* This method allows an outside object to connect it's ruleHandler(QString) slot to the alerts of the active rules */
+
+    if (connect(m_ruleEngine, SIGNAL(sendAlert(QString)), receiver, SLOT(ruleHandler(QString))))
+        return true;
+
+    return false;
+}
+
+bool Automon::setIOMode(SerialHelper::IOMode mode)
+{
+    /*
+        This method selects the I/O engine of the serial I/O thread, either the original polling loop
+        or the event driven reactor. It can only be changed while monitoring is stopped
+    */
+
+    if (isMonitoring())
+        return false;
+
+    return m_serialHelper->setIOMode(mode);
+}
+
+double Automon::getReadsPerSecond() const
+{
+    /* Return the number of ELM327 responses per second achieved by the serial I/O thread */
+    return m_serialHelper->getReadsPerSecond();
+}
+
+double Automon::getAllocatedRate(QString pid) const
+{
+    /*
+        Return the rate the serial thread is aiming for with the sensor. Lower than the rate asked for when the bus
+        can't keep up with every sensor. 0 if it is read as fast as possible or isn't polled
+    */
+
+    Sensor * sensor = getSensorByCommand(pid);
+
+    if (sensor == NULL)
+        return 0;
+
+    /* Channels come with their source sensor, which is the one that is scheduled */
+    return m_serialHelper->getAllocatedRate(sensor->getSource());
+}
+
+const ResponseClassifier & Automon::getResponseStatistics() const
+{
+    /* Return the number of polled responses of each status, eg: to show how many errors the link has */
+    return m_serialHelper->getResponseStatistics();
+}
+
+bool Automon::optimiseLink()
+{
+    /*
+        This method gets more out of the link to the ELM327. The baud rate is raised as far as the adapter goes,
+        then spaces and linefeeds are turned off so each response is shorter. The throughput is measured before
+        and after so the gain on each adapter can be seen, see getLinkReport().
+        Called at the end of initialiseBus(), since ATZ and ATD turn spaces and linefeeds back on.
+    */
+
+    double bytesBefore = 0.0;
+    double bytesAfter = 0.0;
+    int baudBefore = m_serialHelper->getBaudRate();
+
+    double payloadBefore = measureThroughput(bytesBefore);
+
+    if (bytesBefore == 0.0)
     {
 #ifdef DEBUGAUTOMON
-        qDebug() << "No prompt character found!";
+        qDebug("The ELM327 didn't answer, not optimising the link");
 #endif
+        return false;
     }
-    else
-    {
-        /* We have the prompt character, so all is good. Now remove it */
-        bufferResponse = bufferResponse.section("",0,bufferResponse.size()-1);
 
-        /*
-            The response back from the ELM327 will always be a even number of bytes.
-            Do a check for this before procedding
-        */
+    int baudAfter = m_serialHelper->negotiateBaudRate();
 
+    /* Turn off spaces and linefeeds. All the parsers take the compact format */
+    QStringList commands;
+    commands << "ATS0" << "ATL0";
+
+    CommandFuture future = m_serialHelper->queueCommands(commands);
+    future.waitForFinished();
+
+    double payloadAfter = measureThroughput(bytesAfter);
+
+    m_linkReport = QString("%1 baud, %2 B/s (%3 B/s of data) before, %4 baud, %5 B/s (%6 B/s of data) after")
+                   .arg(baudBefore).arg(bytesBefore, 0, 'f', 0).arg(payloadBefore, 0, 'f', 0)
+                   .arg(baudAfter).arg(bytesAfter, 0, 'f', 0).arg(payloadAfter, 0, 'f', 0);
 
-        if ((bufferResponse.size() % 2) != 0)
-        {
 #ifdef DEBUGAUTOMON
-            qDebug() << "Uneven number of bytes, error!";
+    qDebug() << "Link optimised:" << m_linkReport;
 #endif
-        }
-        else
-        {
-            /* All is well now. Response can be assumed valid */
-            for (int i = 0; i < bufferResponse.size(); i+=2)
-            {
-                /* For every second byte (ie, every Hexidecimal byte (2 ASCII bytes, ie: FF = 2 Bytes ASCII = 1 Byte int */
-                bytes.append(bufferResponse.section("",i+1,i+2));
-            }
-        }
+
+    return future.isComplete();
+}
+
+double Automon::measureThroughput(double & bytesPerSecond)
+{
+    /*
+        Time a burst of 0100 requests and return the number of data bytes per second they carried. bytesPerSecond
+        is set to everything that went over the link, requests, echo, formatting and prompts included. Both are 0
+        if the ELM327 didn't answer. The repeat shortcut is off meanwhile, so every request goes out in full
+    */
+
+    QStringList commands;
+
+    for (int i = 0; i < 10; i++)
+        commands << "0100";
+
+    bool repeat = m_serialHelper->isRepeatEnabled();
+    m_serialHelper->setRepeatEnabled(false);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    CommandFuture future = m_serialHelper->queueCommands(commands, 1000);
+    future.waitForFinished();
+
+    qint64 elapsed = qMax(timer.elapsed(), (qint64)1);
+
+    m_serialHelper->setRepeatEnabled(repeat);
+
+    bytesPerSecond = 0.0;
+
+    if (!future.isComplete())
+        return 0.0;
+
+    qint64 wireBytes = 0;
+    qint64 dataBytes = 0;
+    QStringList responses = future.getResponses();
+
+    for (int i = 0; i < responses.size(); i++)
+    {
+        wireBytes += commands[i].size() + 1 + responses[i].size();
+
+        /* An echo of the request went over the link, but it isn't data */
+        QString response = responses[i];
+
+        if (response.startsWith(commands[i]))
+            response = response.section('\x0D', 1);
+
+        dataBytes += HexDecoder(response).size();
     }
 
-    /* This check is used in the toInt method of QString to check if it is a valid integer */
-    bool check;
+    bytesPerSecond = wireBytes * 1000.0 / elapsed;
+
+    return dataBytes * 1000.0 / elapsed;
+}
+
+QString Automon::getLinkReport() const
+{
+    /* The throughput of the link before and after optimiseLink(), empty if it didn't run */
+    return m_linkReport;
+}
+
+int Automon::getBusInitTime() const
+{
+    /* How long the bus initialisation in init() took in ms, from the first ATI to the ECU answering 0100 */
+    return m_busInitTime;
+}
+
+QString Automon::getTransportUri() const
+{
+    /* Return the URI of the transport used to talk to the ELM327, eg: tcp://192.168.0.10:35000 */
+    return m_serialHelper->getTransportUri();
+}
+
+bool Automon::setRecordFile(QString fileName)
+{
+    /*
+        Record all traffic with the ELM327 to a file. The recording can be played back later by creating
+        Automon with replay://fileName. Pass an empty name to stop recording
+    */
+
+    return m_serialHelper->setRecordFile(fileName);
+}
 
-    for (int i = 0; i < bytes.size(); i++)
+bool Automon::setSessionFile(QString fileName)
+{
+    /*
+        Record the values of all sensors to the file, to backtest rules on later with a RuleBacktest. The file is
+        written to while recording, the rest is written when the recording stops, which is when this is called
+        again, or with an empty name to only stop. Returns false if the last recording couldn't be written, or
+        the new file can't be.
+    */
+
+    bool saved = true;
+
+    if (m_sessionRecorder->isRecording())
     {
-        /* For each Byte string, eg: "FF" = 15base10, convert into an Integer and push onto the result list */
+        saved = m_sessionRecorder->stop();
 
-        QByteArray temp(bytes[i].toLatin1());
-        result.append(temp.toInt(&check, 16));
+#ifdef DEBUGAUTOMON
+        qDebug() << "Recorded" << m_sessionRecorder->getRowCount() << "rows of sensor values to" << m_sessionFile;
+#endif
     }
 
+    m_sessionFile = fileName;
+
+    if (!fileName.isEmpty() && !m_sessionRecorder->start(m_sensors, fileName))
+        saved = false;
+
+    return saved;
+}
+
+QList<int> Automon::getBytes(Command & command)
+{
     /*
-        Now we have all the ASCII Hexidecimal strings converted into bytes.
-        EG: 10FF11
-            = "10", "FF", "11"
-            = 10 = 0001010 = integer 10, FF = 11111111 = integer 15, 11 = 0001011 = Integer 11
+        This method is used to grab an array of Integer bytes from the command executed by
+        the serial I/O thread. The serial I/O thread will populate the command's buffer with
+        hexidecimal ASCII. This has to be converted to integers so that sensors
+        can do the neccessary formula conversions in order to obtain the result.
+
+        The decoding is done by the HexDecoder. Sensors use it directly, as it doesn't need the list
     */
 
-    /* Return the list to the calling method */
-    return result;
+    HexDecoder bytes(command.getBuffer());
+
+#ifdef DEBUGAUTOMON
+    if (bytes.isEmpty())
+        qDebug() << "No bytes in response, prompt missing or not whole hex bytes";
+#endif
+
+    return bytes.toList();
 }
 
 bool Automon::saveRuleList()
@@ -212,6 +503,9 @@ bool Automon::loadRuleList()
     /* Close the file again */
     file.close();
 
+    /* Parse the rules once, so they aren't converted again every time they are shown or used */
+    buildRuleCatalogue();
+
     return true;
 }
 
@@ -249,16 +543,11 @@ void Automon::removeRuleEnglishMeaningString(QString rule)
 {
     /* This method is similar to the above, but using the human friendly rule instead of sensor codes */
 
-    /*
-        For each rule, convert it to human readable rule and conpare to inputted human readable rule and
-        if found, remove it and return
-    */
-    for (int i = 0; i < m_ruleList.size(); i++)
-        if (convertRuleToEnglish(m_ruleList.at(i)).compare(rule) == 0)
-        {
-            m_ruleList.removeAt(i);
-            return;
-        }
+    /* Look the human readable rule up in the catalogue, and if found, remove the rule it belongs to */
+    int id = m_ruleCatalogue.findEnglishName(rule);
+
+    if (id != -1)
+        removeRuleString(m_ruleCatalogue.getRule(id));
 }
 
 
@@ -268,13 +557,32 @@ QStringList Automon::getRuleList()
     return m_ruleList;
 }
 
+const RuleCatalogue & Automon::getRuleCatalogue() const
+{
+    /* The rules of the rules file as it was last loaded, parsed, with their ids */
+    return m_ruleCatalogue;
+}
+
+void Automon::buildRuleCatalogue()
+{
+    /*
+        Parse each rule of the rule list into the catalogue with its English label. The labels come from the
+        sensors, so this is done again once the sensors are loaded. The rules keep their ids.
+    */
+
+    m_ruleCatalogue.clear();
+
+    for (int i = 0; i < m_ruleList.size(); i++)
+        m_ruleCatalogue.add(m_ruleList.at(i), renderRuleInEnglish(m_ruleList.at(i)));
+}
+
 void Automon::loadSensors()
 {
     /*
         This method is used when setting up the Automon kernel. It is responsible
         for adding new sensors to the kernel for monitoring.
-        If more sensors are created, and inherited from the sensor class,
-        they need to be added in the list here.
+        Every PID in the PidTable becomes a sensor. To add one, add a line to the table in pidtable.cpp.
+        Sensors that need more than a table entry can still inherit from the sensor class and be added here.
     */
     
 
@@ -283,21 +591,26 @@ void Automon::loadSensors()
     m_activeSensors.clear();
 
 
-    /* Create an instance of each sensor and append it to the main sensor list */
-    m_sensors.append(new CoolantTempSensor);
-    m_sensors.append(new VehicleSpeed);
-    m_sensors.append(new EngineRPM); 
-    m_sensors.append(new EngineRunTime);
-    m_sensors.append(new ThrottlePosition);
-    m_sensors.append(new FuelPressure);
-    m_sensors.append(new FuelLevelInput);
-    m_sensors.append(new MafAirFlowRate);
-    m_sensors.append(new CommandedEgr);
-    m_sensors.append(new O2Voltage);
+    /* Create a sensor for each PID in the table and append it to the main sensor list, followed by its channels */
+    for (int i = 0; i < PidTable::size(); i++)
+    {
+        TableSensor * sensor = new TableSensor(PidTable::at(i));
+        m_sensors.append(sensor);
+        m_sensors += sensor->getChannels();
+    }
 
     /* Update the sensor support for the current car */
 
     updateSensorSupport();
+
+    /* Find out how many ECUs answer each sensor so the ELM327 doesn't wait for answers that never come */
+    learnResponseCounts();
+
+    /* Keep what was learned, so the next start with this vehicle can skip asking for it */
+    storeVehicleProfile();
+
+    /* The English labels of the rules name the sensors, which exist now */
+    buildRuleCatalogue();
     
     /*
         Sensors have boundary values, a low value and a high.
@@ -338,145 +651,157 @@ void Automon::updateSensorSupport()
         OBD II does not state that manufacturers have to implement all sensor types
     */
 
-    if (m_sensors.size() > 0)
+    /* The supported PIDs come from the vehicle profile if it has them, otherwise ask the ECU */
+    m_supportedPids = m_profile.getSupportedPids();
+
+    if (!m_supportedPids.isKnown())
     {
-        /* Only if there are sensors to update */
+        discoverSupportedPids();
+        m_profile.setSupportedPids(m_supportedPids);
+    }
 
-        /*
-            The OBD II protocol has a PID that is bitwise encoded to represent what sensors
-            are supported by the vehicle's ECU. All cars must support the 0100 PID that defines
-            what sensors in the range of 1 - 20, and another PID for the next range
-        */
+    applySensorSupport();
+}
 
+void Automon::applySensorSupport()
+{
+    /* Now all we have to do is go through each sensor and look up its PID */
+    for (int i = 0; i < m_sensors.size(); i++)
+        m_sensors.at(i)->setSupported(m_supportedPids.isSupported(m_sensors.at(i)->getCommand()));
+}
 
-        /* We will only be concerned with first two ranges. These QStrings will hold the response in ASCII format */
-        QString binaryEncodedString1;
-        QString binaryEncodedString2;
+void Automon::discoverSupportedPids()
+{
+    /*
+        Ask the ECU which PIDs it supports. The OBD II protocol has range PIDs that are bitwise encoded to
+        represent what sensors are supported by the vehicle's ECU. All cars must support 0100 which covers
+        PIDs 01 to 20, its last bit says if 0120 is supported, and so on up to 01E0.
 
-        /* First we must query OBD to get the OBD Supported bit encoded string */
+        CAN ECUs answer several range PIDs in one request, so all of them are asked for in one go first.
+        Whatever that didn't answer, eg: on the older protocols that only take one PID per request, is then
+        asked for one range at a time, following the chain for as long as the vehicle supports the next range
+    */
 
-        Command supportCommand1;
-        supportCommand1.setCommand("0100");
+    m_supportedPids.clear();
 
-        m_serialHelper->sendCommand(supportCommand1);
+    if (m_serialHelper->isBatchingEnabled())
+    {
+        CommandFuture future = m_serialHelper->queueCommands(SupportedPids::batchedRangeCommands());
+        future.waitForFinished();
 
-        /* Get all the bytes back. Each byte will be a binary encoded byte */
-        QList<int> bytes1 = Automon::getBytes(supportCommand1);
+        QStringList responses = future.getResponses();
 
+        for (int i = 0; i < responses.size(); i++)
+            m_supportedPids.applyResponse(responses[i]);
+    }
 
-        for (int i = 2 /* Skip command echo */; i < 6; i++)
-        {
-            /*
-                Get current byte. Convert base 2, binary to ASCII representation.
-                ie: Integer: 10 = 00001010base2. Convert this to string "00001010"
-            */
-            QString thisByte = QString::number(bytes1[i],2);
+    /* A range missing from the batch can't be trusted to be unsupported, so the chain asks for it on its own */
+    QString command;
 
-            if (thisByte.size() < 8)
-            {
-                /*
-                    If the size of the current byte is < 8, we must pad the front with 0's.
-                    For example, 10 = "1010", we want "00001010"
-                */
+    while (!(command = m_supportedPids.nextRangeCommand()).isEmpty())
+    {
+        Command rangeCommand;
+        rangeCommand.setCommand(command);
 
-                int size = thisByte.size();
+        m_serialHelper->sendCommand(rangeCommand);
 
-                /* Prepend with current number of 0's */
-                for (int j=0; j < 8-size; j++)
-                    thisByte.prepend("0");
-            }
+        if (m_supportedPids.applyResponse(rangeCommand.getBuffer()) == 0)
+            m_supportedPids.markUnanswered(command);
+    }
 
-            /* Now append this byte to the binary encoded string list for first range */
-            binaryEncodedString1.append(thisByte);
-        }
+#ifdef DEBUGAUTOMON
+    qDebug() << "Supported PIDs:" << m_supportedPids.toString();
+#endif
+}
 
-        /*
-            The last bit of the last byte determines if Pids over 20 are supported. Check this bit
-            and if set, run the next command to get the next bit encoded string
-        */
+bool Automon::isPidSupported(int mode, int pid) const
+{
+    /* Check a PID against what the vehicle said it supports. Cheap enough to call for every PID on screen */
+    return m_supportedPids.isSupported(mode, pid);
+}
+
+SupportedPids Automon::getSupportedPids() const
+{
+    return m_supportedPids;
+}
 
-        bool checkPidsOver20 = (QChar('1') == binaryEncodedString1.at(31));
+void Automon::learnResponseCounts()
+{
+    /*
+        This method sets the number of ECU responses each supported sensor gets. The counts are stored per vehicle,
+        so they only have to be learned the first time a vehicle is seen. To learn them, each PID is requested once
+        with headers on, where every ECU's answer is a line of its own, and the lines are counted.
+    */
 
-        if (checkPidsOver20)
-        {
-            /* Pids over 20 are supported by the current vehicle so continue like we did above for first range */
+    /* The counts are only kept if we know which vehicle they belong to. getVin() leaves m_vinNumber empty if not */
+    getVin();
 
-            Command supportCommand2;
-            supportCommand2.setCommand("0120");
+    if (!m_responseCounts.load(m_vinNumber))
+    {
+        QStringList commands = responseCountCommands();
 
-            m_serialHelper->sendCommand(supportCommand2);
+        CommandFuture future = m_serialHelper->queueCommands(commands);
+        future.waitForFinished();
 
-            /* Get all the bytes back. Each byte will be a binary encoded byte */
-            QList<int> bytes2 = Automon::getBytes(supportCommand2);
+        storeResponseCounts(commands, future.getResponses());
+    }
 
-            for (int i = 2 /* Skip command echo */; i < 6; i++)
-            {
-                QString thisByte = QString::number(bytes2[i],2);
-                if (thisByte.size() < 8)
-                {
-                    /*
-                        If the size of the current byte is < 8, we must pad the front with 0's.
-                        For example, 10 = "1010", we want "00001010"
-                    */
-
-                    int size = thisByte.size();
-
-                    /* Prepend with correct number of 0's */
-                    for (int j=0; j < 8-size; j++)
-                        thisByte.prepend("0");
-                }
-
-                /* Add the binary encoded string for current byte to the list */
-                binaryEncodedString2.append(thisByte);
-            }
-        }
+    applyResponseCounts();
+}
 
-        /* Now that we have our binary encoded strings all we have to do is go through each sensor and compare */
+QStringList Automon::responseCountCommands() const
+{
+    /*
+        The requests that learn the response counts, each supported sensor once between ATH1 and ATH0. They are
+        sent as one group so no other request gets in while the headers are on
+    */
 
-        for (int i = 0; i < m_sensors.size(); i++)
-        {
-            /* Get the PID of the current sensor. Example: Speed = 010D, so PID = 0D, position 3, 4 */
-            QString pid = m_sensors.at(i)->getCommand().section("",3,4);
+    QStringList commands;
 
-            /* Check used for integer conversion */
-            bool check;
+    for (int i = 0; i < m_sensors.size(); i++)
+    {
+        /* Channels are never requested, they get the count of their source, see applyResponseCounts() */
+        if (m_sensors[i]->isSupported() && m_sensors[i]->getSource() == m_sensors[i])
+            commands << m_sensors[i]->getCommand();
+    }
 
-            /* Convert the QString to integer, so "0D" becomes 13 in base 10 */
-            /* This becomes the position in the bit encoded strings then */
-            int position = pid.toInt(&check, 16);
+    commands.prepend("ATH1");
+    commands.append("ATH0");
 
-            if (position < 32)
-            {
-                /* In first range. Check if the bit encoded string at that position == 1*/
-                if (binaryEncodedString1.at(position-1) == QChar('1'))
-                    m_sensors.at(i)->setSupported(true); /* It is, so set to true, supported */
-                else
-                    m_sensors.at(i)->setSupported(false); /* It was 0, meaning not supported */
-            }
-            else if (checkPidsOver20 && (position > 32 && position < 64))
-            {
-                /* We are in the second range. Now we must offset the PID back 32, to get the position in the list */
-                position = position - 32;
+    return commands;
+}
 
-                if (binaryEncodedString2.at(position-1) == QChar('1'))
-                    m_sensors.at(i)->setSupported(true); /* Is supported, set to true */
-                else
-                    m_sensors.at(i)->setSupported(false); /* Not supported, set to false */
-            }
-            else
-                m_sensors.at(i)->setSupported(false); /* Sensor met none, so set to false incase vehicle doesn't support */
-        }
-    }
+void Automon::storeResponseCounts(const QStringList & commands, const QStringList & responses)
+{
+    /* Count the lines in the answers to responseCountCommands() and keep them for this vehicle */
 
+    for (int i = 1; i < commands.size() - 1 && i < responses.size(); i++)
+        m_responseCounts.setCount(commands[i], ResponseCounts::countResponses(commands[i], responses[i]));
+
+    m_responseCounts.save();
+}
+
+void Automon::applyResponseCounts()
+{
+    /* Give every sensor the count of the sensor it is read through */
+
+    for (int i = 0; i < m_sensors.size(); i++)
+    {
+        m_sensors[i]->setResponseCount(m_responseCounts.getCount(m_sensors[i]->getSource()->getCommand()));
+
+#ifdef DEBUGAUTOMON
+        qDebug() << m_sensors[i]->getCommand() << "is answered by" << m_sensors[i]->getResponseCount() << "ECUs";
+#endif
+    }
 }
 
-bool Automon::setSensorFrequency(Sensor * sensor, int frequency) const
+bool Automon::setSensorFrequency(Sensor * sensor, double frequency) const
 {
     /*
         This method is responsible for updating the sensor's frequency in the serial I/O thread.
-        The frequency determines how often it gets access to the ELM327 to contact the ECU.
+        The frequency is a real rate in Hz. The serial thread's scheduler gives the sensor a deadline from it.
         No point checking coolant temperature too often for example, as it changes slowly relative to
-        engine RPM.
+        engine RPM. A frequency of 0 means read the sensor as often as the bus allows.
     */
 
     if (sensor == NULL)
@@ -488,11 +813,28 @@ bool Automon::setSensorFrequency(Sensor * sensor, int frequency) const
     }
 
 #ifdef DEBUGAUTOMON
-    qDebug() << "Setting frequency for sensor \"" << sensor->getCommand() << "\" to " << QString::number(frequency);
+    qDebug() << "Setting frequency for sensor \"" << sensor->getCommand() << "\" to " << QString::number(frequency) << "Hz";
 #endif
 
-    /* Set the sensor's frequency to what was defined by calling method */
-    sensor->setFrequency(frequency);
+    /* Set the sensor's frequency to what was defined by calling method. A channel is read through its source */
+    sensor->setTargetRate(frequency);
+    sensor->getSource()->setTargetRate(frequency);
+
+    return true;
+}
+
+bool Automon::setSensorPriority(Sensor * sensor, int priority) const
+{
+    /*
+        This method sets the sensor's priority. When the bus can't keep up with all the requested
+        frequencies, the lower priority sensors are slowed down first.
+    */
+
+    if (sensor == NULL)
+        return false;
+
+    sensor->setPriority(priority);
+    sensor->getSource()->setPriority(priority);
 
     return true;
 }
@@ -518,9 +860,9 @@ bool Automon::addActiveSensor(Sensor * sensor)
     if (!sensor->isSupported())
         return false;
 
-    /* Append the sensor to the current active list locally and add it to the serial thread list */
+    /* Append the sensor to the current active list locally and add it to the serial thread list. For a channel that's its source */
     m_activeSensors.append(sensor);
-    m_serialHelper->addActiveSensor(m_activeSensors.at(m_activeSensors.size()-1));
+    m_serialHelper->addActiveSensor(sensor->getSource());
 
 #ifdef DEBUGAUTOMON
     qDebug() << "Added Sensors to Active List";
@@ -586,7 +928,7 @@ bool Automon::init()
     /*
         This method is called before anything is done with Automon.
         It is responsible for setting up a connection between the ELM327 and the ECU.
-        It has sleeps to prevent commands conflicting with each other
+        Every step waits only as long as the ELM327 takes to answer it
     */
 
     /* Update the status on the Splash Screen so user knows what is happening */
@@ -598,20 +940,28 @@ bool Automon::init()
 //        throw elmnotcontactable_exception();
 //    }
 
-//    emit updateStatus(tr("Initialising ECU to Automon OBDII Bus"), Qt::AlignCenter, Qt::white);
+    emit updateStatus(tr("Loading Vehicle Profile"), Qt::AlignCenter, Qt::white);
 
-//    if (!initialiseBus())
-//    {
-//        /*
-//            The bus could not be initialised. Communication breakdown between ECU and ELM327.
-//            Automon cannot continue at this point
-//        */
+    /* If this adapter was used with a vehicle before, start with what we know about it instead of asking again */
+    loadVehicleProfile();
 
-//        throw init_exception();
-//    }
+    emit updateStatus(tr("Initialising ECU to Automon OBDII Bus"), Qt::AlignCenter, Qt::white);
 
+    if (!initialiseBus())
+    {
+        /*
+            The bus could not be initialised. Communication breakdown between ECU and ELM327.
+            Automon cannot continue at this point
+        */
 
-//    emit updateStatus(tr("Bus Successfully Initialized"), Qt::AlignCenter, Qt::white);
+        throw init_exception();
+    }
+
+    /* Show how long it took, the bus init used to be a few seconds of fixed sleeps */
+    emit updateStatus(tr("Bus Successfully Initialized (%1ms)").arg(m_busInitTime), Qt::AlignCenter, Qt::white);
+
+    /* Make sure the profile belongs to this vehicle when the serial thread has nothing better to do */
+    checkVehicleProfile();
 
 //    emit updateStatus(tr("Loading DTC Codes"), Qt::AlignCenter, Qt::white);
 
@@ -642,16 +992,13 @@ bool Automon::startMonitoring()
         sensor values of the currently added active sensors
     */
 
-    if (!m_serialHelper->isRunning())
+    if (!m_isMonitoring)
     {
-        /* Only attempt to start if not already running */
-        /* Start the serial thread with TimeCriticalPriority */
-        m_serialHelper->start(QThread::TimeCriticalPriority);
-
-        /* A small 1/2 second sleep */
-        SleeperThread::msleep(500);
-
+        /* Only attempt to start if not already monitoring */
+        /* The serial thread is always running, it just starts reading the active sensors. No need to wait for it */
         m_isMonitoring = true;
+        updateMonitoringState();
+
         return true;
     }
 
@@ -694,10 +1041,9 @@ bool Automon::resetMilAndClearCodes()
 
 void Automon::stopMonitoring()
 {
-    /* Stop the serial I/O thread and update the m_isMonitoring state variable */
-    m_serialHelper->terminate();
-    m_serialHelper->setMonitoring(false);
+    /* Update the m_isMonitoring state variable. The polling goes on if anyone is still subscribed */
     m_isMonitoring = false;
+    updateMonitoringState();
 }
 
 
@@ -707,6 +1053,14 @@ Automon::~Automon()
         Automon Destructor. Delete any objects created
     */
 
+    /* The subscriptions go first, they use the serial helper. The rule engine is connected to the sensors */
+    delete (m_subscriptions);
+    delete (m_ruleEngine);
+
+    /* Write out a session still being recorded */
+    setSessionFile("");
+    delete (m_sessionRecorder);
+
     delete (m_serialHelper);
     delete (m_dtcHelper);
 
@@ -722,13 +1076,9 @@ QString Automon::getVoltage() const
 {
     /*
         Return the current voltage of the battery, known by the ELM327.
-        Only allow entry to this method if monitoring is off since it requires communication with ELM327
+        If monitoring, the command is slipped in between two polling rounds by the serial thread
     */
 
-    if (m_serialHelper->isMonitoring())
-        return QString("");
-
-
     /* Create command send send to ELM327 */
     Command requestVoltage;
     requestVoltage.setCommand("ATRV");
@@ -757,10 +1107,36 @@ QString Automon::cleanResponse(QString response)
     return response;
 }
 
-void Automon::removeAllActiveSensors() const
+void Automon::removeAllActiveSensors()
+{
+    /*
+        This is an interface method that removes all sensors added with addActiveSensor() from the serial helper
+        thread. Sensors that still have subscribers keep being polled for them.
+    */
+
+    QList<Sensor*> sensors = m_activeSensors;
+    m_activeSensors.clear();
+
+    for (int i = 0; i < sensors.size(); i++)
+        releaseSource(sensors[i]);
+}
+
+void Automon::releaseSource(Sensor * sensor)
 {
-    /* This is an interface method that calls the serial helper thread to remove all current active sensors */
-    m_serialHelper->removeAllActiveSensors();
+    /*
+        Take the sensor that is read for this one out of the serial thread, unless it is still needed. A source is
+        shared by its channels, so it stays while any of them is active or anyone subscribed to one of them.
+        Both owners come through here, the active sensor list and the subscription manager.
+    */
+
+    Sensor * source = sensor->getSource();
+
+    for (int i = 0; i < m_activeSensors.size(); i++)
+        if (m_activeSensors[i]->getSource() == source)
+            return;
+
+    if (!m_subscriptions->isPolled(source))
+        m_serialHelper->removeActiveSensorByCommand(source->getCommand());
 }
 
 QStringList Automon::extractSensorsFromRule(QString & rule) const
@@ -773,31 +1149,26 @@ QStringList Automon::extractSensorsFromRule(QString & rule) const
 
     QStringList sensorCommands; /* Our list of sensors to return */
 
-    /* Regular expression that finds a match for the sensors */
-    QRegExp checkExp("s[a-fA-F0-9][a-fA-F0-9][a-fA-F0-9][a-fA-F0-9]");
+    /* Rules of the rules file were parsed when it was loaded */
+    int id = m_ruleCatalogue.findRule(rule);
 
-    /* From pos is, the from position, where we search from basically */
-    int fromPos = 0;
+    if (id != -1)
+        return m_ruleCatalogue.getSensors(id);
+
+    /* Regular expression that finds a match for the sensors. A channel of a sensor has its number after it, ie: s0114_1 */
+    QRegExp checkExp("s([a-fA-F0-9]{4}(_[0-9])?)");
 
     /* This is a position of where the sensor was found in the rule string */
-    int occurencePos = rule.indexOf(checkExp,fromPos);
+    int occurencePos = checkExp.indexIn(rule);
 
     /* While we keep finding sensors */
     while (occurencePos != -1)
     {
-        /* Get the sensor name, ie: s010D */
-        QString sensorName = rule.section("", occurencePos+1, occurencePos+5);
-
-        /* Get the actual command, ie: remove the s proceeding it. Becomes 010D for eg. */
-        QString sensorCommand = sensorName.section("",2,5);
-
-        /* Only if it not empty will we append it */
-        if (sensorCommand != "")
-            sensorCommands.append(sensorCommand);
+        /* Get the actual command, ie: without the s proceeding it. 010D for eg. */
+        sensorCommands.append(checkExp.cap(1));
 
         /* Move to after sensor found so we search ahead */
-        fromPos = occurencePos + 5;
-        occurencePos = rule.indexOf(checkExp,fromPos);
+        occurencePos = checkExp.indexIn(rule, occurencePos + checkExp.matchedLength());
     }
 
     /* Return the sensors found in the rule */
@@ -806,51 +1177,55 @@ QStringList Automon::extractSensorsFromRule(QString & rule) const
 
 QString Automon::convertRuleToEnglish(QString rule) const
 {
-
     /*
         This method is responsible for accepting a rule and converting it to a human readable format
         ie: Rule: s010C < 5000 && s010D > 150 becomes: Engine RPM > 5000 AND Vehicle Speed > 150
+        Rules of the rules file were converted when it was loaded, so those are only looked up
     */
 
-    /* Create the regular expression that finds the match of a sensor */
-    QRegExp checkExp("s[a-fA-F0-9][a-fA-F0-9][a-fA-F0-9][a-fA-F0-9]");
+    int id = m_ruleCatalogue.findRule(rule);
+
+    if (id != -1)
+        return m_ruleCatalogue.getEnglishName(id);
+
+    return renderRuleInEnglish(rule);
+}
+
+QString Automon::renderRuleInEnglish(QString rule) const
+{
+    /* Convert the rule by replacing each sensor in it with its English meaning */
+
+    /* Create the regular expression that finds the match of a sensor, or of a channel of one, ie: s0114_1 */
+    QRegExp checkExp("s([a-fA-F0-9]{4}(_[0-9])?)");
 
     /* Position to search from in the rule string */
     int fromPos = 0;
 
     /* Where a match of a sensor is found */
-    int occurencePos = rule.indexOf(checkExp,fromPos);
+    int occurencePos = checkExp.indexIn(rule, fromPos);
 
     /* While we have found a match */
     while (occurencePos != -1)
     {
 
-        /* Get the sensor name. If at position 0, we go from 0 - 5, otherwise go from eg: 1 - 6 (5+1) */
-        QString sensorName = rule.section("", (occurencePos == 0 ? occurencePos : occurencePos+1), occurencePos+5);
+        /* Get the sensor name, ie: s010D */
+        QString sensorName = checkExp.cap(0);
 
         /* Extract command, removing the proceeding s */
-        QString sensorCommand = sensorName.section("",2,5);
+        QString sensorCommand = checkExp.cap(1);
 
-        /* Only if we have a none empty string */
-        if (sensorCommand != "")
-        {
-            /* Get a pointer to the string using the command found */
-            Sensor * sensor = getSensorByCommand(sensorCommand);
+        /* Get a pointer to the string using the command found */
+        Sensor * sensor = getSensorByCommand(sensorCommand);
 
-            if (sensor != NULL)
-            {
-                /*  Only if not null, get the english meaning and replace the s010D with the english meaning for eg */
-                QString englishMeaning = sensor->getEnglishMeaning();
+        /* Only if not null, get the english meaning. Else use UNKNOWN SENSOR, should never happen */
+        QString englishMeaning = (sensor != NULL ? sensor->getEnglishMeaning() : QString("UNKNOWN SENSOR: " + sensorCommand));
 
-                rule.replace(QRegExp(sensorName),englishMeaning);
-            }
-            else /* Else replace the sensor with UNKNOWN SENSOR. Should never happen */
-                rule.replace(QRegExp(sensorName), QString("UNKNOWN SENSOR: "+sensorCommand));
-        }
+        /* Replace only this occurrence, s0114 would also match the start of its channel s0114_1 */
+        rule.replace(occurencePos, sensorName.length(), englishMeaning);
 
-        /* Continue to after where we found last sensor */
-        fromPos += occurencePos;
-        occurencePos = rule.indexOf(checkExp,fromPos);
+        /* Continue to after the text we put in */
+        fromPos = occurencePos + englishMeaning.length();
+        occurencePos = checkExp.indexIn(rule, fromPos);
     }
 
     /* Replace the && with AND and the || with OR */
@@ -872,10 +1247,7 @@ QString Automon::getElmVersion()
     if(m_elmVersion.compare(""))
         return m_elmVersion;
 
-    /* If here, first time checking. If monitoring return empty string to signify */
-    if (m_serialHelper->isMonitoring())
-        return QString("");
-
+    /* If here, first time checking. This works while monitoring too, the serial thread fits it in */
 
     QString elmVersion;
 
@@ -902,10 +1274,7 @@ QString Automon::getOBDProtocol()
     if (m_protocol.compare(""))
         return m_protocol;
 
-    /* If here, first time checking. If monitoring return empty string to signify */
-    if (m_serialHelper->isMonitoring())
-        return QString("");
-
+    /* If here, first time checking. This works while monitoring too, the serial thread fits it in */
     /* Create the command send send it */
     Command requestProtocol;
     requestProtocol.setCommand("ATDP");
@@ -929,128 +1298,175 @@ QString Automon::getOBDStandardType()
     if (m_standardType.compare(""))
         return m_standardType;
 
-    /* If here, first time checking. If monitoring return empty string to signify */
-    if (m_serialHelper->isMonitoring())
-        return QString("");
+    /* If here, first time checking. This works while monitoring too, the serial thread fits it in */
+    /* Create the command send send it */
+    Command mode011C;
+    mode011C.setCommand("011C");
+
+
+    m_serialHelper->sendCommand(mode011C);
+
+    QString standard = standardFromResponse(mode011C.getBuffer());
+
+    /* Nothing to remember if the ECU didn't answer */
+    if (standard == "Request Could Not Determine Protocol")
+        return standard;
+
+    /* Return the standard type assigning the m_standardType at the same time */
+    return m_standardType = standard;
+}
+
+QString Automon::standardFromResponse(QString buffer)
+{
+    /* Name the OBD standard from the answer to 011C. Shared by getOBDStandardType() and requestVehicleDetails() */
 
-    /* Create the command send send it */
     Command mode011C;
-    mode011C.setCommand("011C");
-
-
-    m_serialHelper->sendCommand(mode011C);
+    mode011C.setBuffer(buffer);
 
     /* We must parse the returned bytes since it is bit encoded */
     QList<int> bytes = getBytes(mode011C);
 
-    QString standard; /* Will hold the standard name */
-
     /* Now byte A, (bytes[2]) is where the information is stored. */
-    if (bytes.size() < 2)
+    if (bytes.size() < 3)
         return QString("Request Could Not Determine Protocol");
-    else
-    {
-        if (bytes[2] == 1)
-            standard = "OBD-II as defined by the CARB";
-        else if (bytes[2] == 2)
-            standard = "OBD as defined by the EPA";
-        else if (bytes[2] == 3)
-            standard = "OBD and OBD-II";
-        else if (bytes[2] == 4)
-            standard = "OBD-I";
-        else if (bytes[2] == 5)
-            standard = "Not meant to comply with any OBD standard";
-        else if(bytes[2] == 6)
-            standard = "EOBD (European Protocol)";
-        else
-            standard = "Unknown Protocol Standard";
-    }
 
-    /* Return the standard type assigning the m_standardType at the same time */
-    return m_standardType = standard;
+    if (bytes[2] == 1)
+        return "OBD-II as defined by the CARB";
+    else if (bytes[2] == 2)
+        return "OBD as defined by the EPA";
+    else if (bytes[2] == 3)
+        return "OBD and OBD-II";
+    else if (bytes[2] == 4)
+        return "OBD-I";
+    else if (bytes[2] == 5)
+        return "Not meant to comply with any OBD standard";
+    else if(bytes[2] == 6)
+        return "EOBD (European Protocol)";
+
+    return "Unknown Protocol Standard";
 }
 
 bool Automon::initialiseBus()
 {
     /*
-        This method is used to restart the ELM327 and activate the ECU->ELM327 bus
+        This method is used to restart the ELM327 and activate the ECU->ELM327 bus. It walks through the
+        initSteps table above. There are no fixed sleeps, every step is over when its answer arrives, and
+        the time each step took is sent to the splash screen
     */
 
 #ifdef DEBUGAUTOMON
     qDebug() << "Initalizing Bus...";
 #endif
 
-    /* First we restart the interface. Create the command and send it */
+    QElapsedTimer total;
+    total.start();
 
-    Command resetInterface;
-    resetInterface.setCommand("atz");
+    InitState state = ProbeAdapter;
+    bool protocolForced = false;
 
-    m_serialHelper->sendCommand(resetInterface);
+    while (state != InitDone && state != InitFailed)
+    {
+        const InitStep & step = initSteps[state];
+        QString commandText = step.command;
 
-    /* Keep checking response until it gets to > meaning ELM327 up and running */
-    while(QString(resetInterface.getBuffer().replace(QRegExp("\x0D"),"").at(resetInterface.getBuffer().replace(QRegExp("\x0D"),"").size()-1)).compare(">"));
+        /* Only forced if the profile of the last vehicle is known, see loadVehicleProfile() */
+        if (state == SetProtocol)
+        {
+            if (!m_profile.isValid() || m_profile.getProtocolNumber().isEmpty())
+            {
+                state = step.next;
+                continue;
+            }
 
-    /* Sleep for a second to prevent conflicts with commands */
-    SleeperThread::msleep(1000);
+            commandText += m_profile.getProtocolNumber();
+        }
 
-#ifdef TURNOFFECHO
+        /* Only needed to undo a forced protocol */
+        if (state == SearchProtocol && !protocolForced)
+        {
+            state = step.next;
+            continue;
+        }
 
-    /* Turns off echos. This should always be set really */
+#ifndef TURNOFFECHO
+        /* Leave echo on. Warning, formulas rely on no echo */
+        if (state == EchoOff)
+        {
+            state = step.next;
+            continue;
+        }
+#endif
 
-    #ifdef DEBUGAUTOMON
-        qDebug() << "Turning Off Echo by sending ELM327 ATE0";
-    #endif
+#ifndef ADAPTIVETIMING
+        if (state == AdaptiveTiming)
+        {
+            state = step.next;
+            continue;
+        }
+#endif
 
-    /* Create command to turn off ELM327 echoing of commands entered. Useful for validating command sent but time wasting */
-    Command turnOffEchoCommand;
-    turnOffEchoCommand.setCommand("ATE0");
-    m_serialHelper->sendCommand(turnOffEchoCommand);
+        QElapsedTimer timer;
+        timer.start();
 
-#endif
+        bool passed = false;
 
+        for (int attempt = 0; attempt < step.attempts && !passed; attempt++)
+        {
+            Command command;
+            command.setCommand(commandText);
 
-#ifdef ADAPTIVETIMING
-    /*
-        Adaptive timing is an ELM327 feature that on the fly adapts to ECU response times.
-        It reduces time it waits for response from ECU resulting in faster response to the Serial I/O.
-    */
+            m_serialHelper->sendCommand(command, step.timeout);
 
-    /* Wait another second to prevent conflict with commands */
-    SleeperThread::msleep(1000);
+            /* Compare without spaces, so it doesn't matter if the ELM327 is sending them or not */
+            QString response = command.getBuffer();
+            response.remove(' ');
 
-#ifdef DEBUGAUTOMON
-    qDebug() << "Setting Adaptive Timing to excessive mode";
-#endif
+            passed = response.contains(QString(step.expect)) && !response.contains(QString("UNABLETOCONNECT"));
+        }
 
-    /* Send a command turn on excessive adaptive timing mode (ATAT2) */
-    Command turnOnAdaptiveTiming;
-    turnOnAdaptiveTiming.setCommand("ATAT2");
-    m_serialHelper->sendCommand(turnOnAdaptiveTiming);
+        int elapsed = timer.elapsed();
 
+        emit updateStatus(tr("%1 (%2ms)").arg(step.description).arg(elapsed), Qt::AlignCenter, Qt::white);
+
+#ifdef DEBUGAUTOMON
+        qDebug() << step.command << (passed ? "passed" : "failed") << "in" << elapsed << "ms";
 #endif
 
-    SleeperThread::msleep(1000);
+        if (state == SetProtocol)
+            protocolForced = passed;
 
-    /* Ok now that the ELM327 is initialized, time to wake up the OBD bus */
+        /* Maybe another vehicle on a different protocol. The background check of the profile finds that out */
+        if (state == ConnectBus && !passed && protocolForced)
+        {
+            protocolForced = false;
+            state = SearchProtocol;
+            continue;
+        }
 
-    Command initialiseBus;
-    initialiseBus.setCommand("0100");
+        state = passed ? step.next : step.onFailure;
+    }
 
-    SleeperThread::msleep(1000);
+    m_busInitTime = total.elapsed();
 
-    m_serialHelper->sendCommand(initialiseBus);
+#ifdef DEBUGAUTOMON
+    qDebug() << "Bus initialisation" << (state == InitDone ? "finished" : "failed") << "in" << m_busInitTime << "ms";
+#endif
 
-    QString returnedBytes = initialiseBus.getBuffer();
+    /* Initialization of bus failed if we didn't get to the end :( */
+    if (state != InitDone)
+        return false;
 
-    returnedBytes.replace(QRegExp("\x0D"), "");
-    returnedBytes.replace(QRegExp(" "), "");
+#ifdef OPTIMISELINK
+    emit updateStatus(tr("Optimising Adapter Link"), Qt::AlignCenter, Qt::white);
 
-    /* Do check to ensure correct response received */
-    if (!returnedBytes.contains(QRegExp("UNABLETOCONNECT")) && QString(returnedBytes.at(returnedBytes.size()-1)).compare(">") == 0)
-        return true;
+    /*
+        Only now that the adapter was reset and echo is off. Not being able to speed up the link is no reason
+        to stop. We just carry on at the speed we have
+    */
+    optimiseLink();
+#endif
 
-    /* Initialization of bus failed :( */
-    return false;
+    return true;
 }
 
 
@@ -1089,7 +1505,50 @@ QString Automon::getVin()
 
     m_serialHelper->sendCommand(vinCommand);
 
-    QString returnedBuffer = vinCommand.getBuffer();
+    bool valid;
+    QString vinNumber = vinFromResponse(vinCommand.getBuffer(), valid);
+
+    /* Only a valid VIN is remembered, otherwise vinNumber tells what went wrong */
+    if (valid)
+        m_vinNumber = vinNumber;
+
+    return vinNumber;
+}
+
+QString Automon::vinFromResponse(QString buffer, bool & valid)
+{
+    /* Decode and check the VIN in the answer to 0902. Returns the error to show instead if it isn't valid */
+
+    QString vinNumber = decodeVin(buffer);
+
+    valid = false;
+
+    /* The response should be even number so if not, return error */
+    if (vinNumber.isNull())
+    {
+
+#ifdef DEBUGAUTOMON
+        qDebug("The returned string for VIN was not of equal bytes. Error");
+#endif
+        return QString("The Returned Number of Bytes for VIN was not even. Read Error");
+    }
+
+    /* A VIN Number has to be 17 characters long by the standard! */
+    if (vinNumber.size() != 17)
+        return QString("Invalid VIN!");
+
+    valid = true;
+    return vinNumber;
+}
+
+QString Automon::decodeVin(QString buffer)
+{
+    /*
+        Decode the VIN from the answer to 0902, see getVin() above for the format. Returns a null string if the
+        answer doesn't have an even number of hex digits. The length isn't checked here
+    */
+
+    QString returnedBuffer = buffer;
 
     /* Remove spaces to make it easier to parse */
     QRegExp rx( " " );
@@ -1115,18 +1574,10 @@ QString Automon::getVin()
         fullLine += thisLine;
     }
 
-
-    /* The response should be even number so if not, return error */
     if (fullLine.size() % 2 !=0)
-    {
-
-#ifdef DEBUGAUTOMON
-        qDebug("The returned string for VIN was not of equal bytes. Error");
-#endif
-        return QString("The Returned Number of Bytes for VIN was not even. Read Error");
-    }
+        return QString();
 
-    QString vinNumber;
+    QString vinNumber("");
 
     /* Now go through the full line, catching each pair, "FF" as it is a single byte */
     for (int i=0; i < fullLine.size(); i += 2)
@@ -1135,11 +1586,273 @@ QString Automon::getVin()
         vinNumber += QByteArray::fromHex(hexByte.toLatin1());
     }
 
-    /* A VIN Number has to be 17 characters long by the standard! */
-    if (vinNumber.size() != 17)
-        return QString("Invalid VIN!");
+    return vinNumber;
+}
+
+void Automon::loadVehicleProfile()
+{
+    /*
+        Load the profile of the last vehicle used with this adapter. If there is one, its VIN, protocol and
+        support bitmaps are used straight away. Called before initialiseBus(), which forces the protocol with
+        ATSP so the ELM327 doesn't have to search for it. The profile is checked against the vehicle
+        afterwards, see checkVehicleProfile()
+    */
+
+    if (!m_profile.load(getTransportUri()))
+    {
+        /* Nothing known. The profile is filled in as the vehicle is queried, see storeVehicleProfile() */
+        m_profile.setAdapter(getTransportUri());
+        return;
+    }
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Using stored profile for" << m_profile.getVin() << "on protocol" << m_profile.getProtocolNumber();
+#endif
+
+    m_vinNumber = m_profile.getVin();
+    m_protocol = m_profile.getProtocol();
+    m_standardType = m_profile.getStandardType();
+    m_elmVersion = m_profile.getElmVersion();
+    m_profileChecks = 0;
+}
+
+void Automon::checkVehicleProfile()
+{
+    /* Check a loaded profile is still for the same vehicle, in the background. See receiveProfileCheck() */
+
+    if (!m_profile.isValid())
+        return;
+
+    QStringList commands;
+    commands << "0902" << "0100";
+
+    m_serialHelper->queueCommands(commands, 5000, CommandRequest::BackgroundLane, this, "receiveProfileCheck");
+}
+
+void Automon::storeVehicleProfile()
+{
+    /*
+        Fill in and store the profile of the current vehicle. Only done when it wasn't loaded, the support
+        bitmaps are already in it from updateSensorSupport()
+    */
+
+    if (m_profile.isValid() || m_vinNumber.isEmpty())
+        return;
+
+    Command protocolNumber;
+    protocolNumber.setCommand("ATDPN");
+
+    m_serialHelper->sendCommand(protocolNumber);
+
+    /* The getters leave what they found in the cache variables */
+    getOBDProtocol();
+    getOBDStandardType();
+    getElmVersion();
+
+    saveVehicleProfile(protocolNumber.getBuffer());
+}
+
+void Automon::saveVehicleProfile(QString protocolNumber)
+{
+    /* Fill in the profile from the cache variables and the answer to ATDPN, then store it */
+
+    m_profile.setVin(m_vinNumber);
+    m_profile.setProtocolNumber(VehicleProfile::parseProtocolNumber(protocolNumber));
+    m_profile.setProtocol(m_protocol);
+    m_profile.setStandardType(m_standardType);
+    m_profile.setElmVersion(m_elmVersion);
+    m_profile.save();
+}
+
+void Automon::receiveProfileCheck(QStringList responses)
+{
+    /*
+        Called in the GUI thread with the answers to 0902 and 0100, sent after a profile was loaded. The profile
+        is only dropped when the vehicle says it's another one: a valid VIN that isn't the profile's, or if the
+        VIN wasn't answered, a 0100 bitmap that isn't. If neither was answered, eg: the ignition was still off,
+        the check is tried again a bit later. A dropped profile is learned again, see relearnVehicle()
+    */
+
+    if (!m_profile.isValid())
+        return;
+
+    while (responses.size() < 2)
+        responses.append(QString(""));
+
+    bool vinValid;
+    QString vin = vinFromResponse(responses[0], vinValid);
+
+    SupportedPids check;
+    SupportedPids stored = m_profile.getSupportedPids();
+    bool bitmapValid = check.applyResponse(responses[1]) > 0 && check.hasRange(0x01, 0x00) && stored.hasRange(0x01, 0x00);
+
+    bool otherVehicle;
+
+    if (vinValid)
+        otherVehicle = vin != m_profile.getVin();
+    else if (bitmapValid)
+        otherVehicle = check.getRange(0x01, 0x00) != stored.getRange(0x01, 0x00);
     else
-        return m_vinNumber = vinNumber; /* We have the correct VIN number so return */
+    {
+        if (++m_profileChecks < PROFILECHECKATTEMPTS)
+            QTimer::singleShot(PROFILECHECKDELAY, this, SLOT(checkVehicleProfile()));
+
+        return;
+    }
+
+    if (!otherVehicle)
+        return;
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Stored profile for" << m_profile.getVin() << "doesn't match the vehicle, learning it again";
+#endif
+
+    relearnVehicle();
+}
+
+void Automon::relearnVehicle()
+{
+    /*
+        Drop the profile and learn the vehicle again, the same as updateSensorSupport(), learnResponseCounts()
+        and storeVehicleProfile() do but without blocking the GUI thread. Every step queues its requests in the
+        background lane and the slot getting the answers queues the next one:
+        receiveRelearnedVin(), receiveRangeResponse(), receiveResponseCounts() and receiveProfileDetails()
+    */
+
+    m_profile.forget();
+
+    m_vinNumber = "";
+    m_protocol = "";
+    m_standardType = "";
+    m_supportedPids.clear();
+
+    /* The ELM327 goes back to searching for the protocol, which the VIN request sets off */
+    QStringList commands;
+    commands << "ATSP0" << "0902";
+
+    if (m_serialHelper->isBatchingEnabled())
+        commands += SupportedPids::batchedRangeCommands();
+
+    m_serialHelper->queueCommands(commands, 10000, CommandRequest::BackgroundLane, this, "receiveRelearnedVin");
+}
+
+void Automon::receiveRelearnedVin(QStringList responses)
+{
+    /* The answers to ATSP0, 0902 and the batched range requests from relearnVehicle() */
+
+    while (responses.size() < 2)
+        responses.append(QString(""));
+
+    bool valid;
+    QString vin = vinFromResponse(responses[1], valid);
+
+    if (valid)
+        m_vinNumber = vin;
+
+    for (int i = 2; i < responses.size(); i++)
+        m_supportedPids.applyResponse(responses[i]);
+
+    requestNextRange();
+}
+
+void Automon::requestNextRange()
+{
+    /* Whatever the batch didn't answer is asked for one range at a time, as in discoverSupportedPids() */
+
+    QString command = m_supportedPids.nextRangeCommand();
+
+    if (!command.isEmpty())
+    {
+        QStringList commands;
+        commands << command;
+
+        m_serialHelper->queueCommands(commands, 5000, CommandRequest::BackgroundLane, this, "receiveRangeResponse");
+        return;
+    }
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Supported PIDs:" << m_supportedPids.toString();
+#endif
+
+    m_profile.setSupportedPids(m_supportedPids);
+    applySensorSupport();
+
+    requestResponseCounts();
+}
+
+void Automon::receiveRangeResponse(QStringList responses)
+{
+    /* The answer to the range request queued by requestNextRange(). Nothing was applied since, so it's still next */
+
+    QString command = m_supportedPids.nextRangeCommand();
+
+    if (command.isEmpty())
+        return;
+
+    if (responses.isEmpty() || m_supportedPids.applyResponse(responses[0]) == 0)
+        m_supportedPids.markUnanswered(command);
+
+    requestNextRange();
+}
+
+void Automon::requestResponseCounts()
+{
+    /* Learn the response counts as learnResponseCounts() does, unless they are known for this vehicle */
+
+    QStringList commands = responseCountCommands();
+
+    /* Nothing to count before the sensors are loaded, loadSensors() learns them then */
+    if (m_responseCounts.load(m_vinNumber) || commands.size() <= 2)
+    {
+        applyResponseCounts();
+        requestProfileDetails();
+        return;
+    }
+
+    m_serialHelper->queueCommands(commands, 5000, CommandRequest::BackgroundLane, this, "receiveResponseCounts");
+}
+
+void Automon::receiveResponseCounts(QStringList responses)
+{
+    /* The answers to the requests of requestResponseCounts(). The sensor support hasn't changed since */
+
+    storeResponseCounts(responseCountCommands(), responses);
+    applyResponseCounts();
+
+    requestProfileDetails();
+}
+
+void Automon::requestProfileDetails()
+{
+    /* Ask for the rest of the profile, as storeVehicleProfile() does. Without a VIN it can't be stored */
+
+    if (m_vinNumber.isEmpty())
+        return;
+
+    QStringList commands;
+    commands << "ATDPN" << "ATDP" << "011C" << "ATI";
+
+    m_serialHelper->queueCommands(commands, 5000, CommandRequest::BackgroundLane, this, "receiveProfileDetails");
+}
+
+void Automon::receiveProfileDetails(QStringList responses)
+{
+    /* The answers to requestProfileDetails(). The profile of the vehicle is stored with them */
+
+    while (responses.size() < 4)
+        responses.append(QString(""));
+
+    m_protocol = cleanResponse(responses[1]);
+
+    QString standard = standardFromResponse(responses[2]);
+
+    if (standard != "Request Could Not Determine Protocol")
+        m_standardType = standard;
+
+    if (m_elmVersion.isEmpty())
+        m_elmVersion = cleanResponse(responses[3]);
+
+    saveVehicleProfile(responses[0]);
 }
 
 QList<Sensor*> Automon::getFreezeFrame() const
@@ -1172,6 +1885,114 @@ bool Automon::sendCommand(Command & command)
     return true;
 }
 
+CommandFuture Automon::sendCommandAsync(QString command, QObject * receiver, const char * member)
+{
+    /*
+        This method queues a one off command, eg: ATRV, and returns straight away so the GUI doesn't freeze.
+        The response is in the returned future, and is also passed to the receiver's slot if one is given.
+    */
+
+    return m_serialHelper->queueCommands(QStringList(command), 5000, CommandRequest::PriorityLane, receiver, member);
+}
+
+void Automon::requestDTCInformation()
+{
+    /*
+        Refresh the DTC information without blocking. The dtcInformationReady() signal is emitted once the
+        serial thread has the answers. Works while monitoring.
+    */
+
+    m_serialHelper->queueCommands(DTCHelper::getRefreshCommands(), 5000, CommandRequest::PriorityLane,
+                                  this, "receiveDTCResponses");
+}
+
+void Automon::requestMilResetAndClearCodes()
+{
+    /*
+        Reset the MIL and clear the codes without blocking, then refresh the DTC information in the same group.
+        The dtcInformationReady() signal is emitted when done.
+    */
+
+    if (m_numberDTCs <= 0)
+        return;
+
+    QStringList commands;
+    commands << "04" << DTCHelper::getRefreshCommands();
+
+    m_serialHelper->queueCommands(commands, 5000, CommandRequest::PriorityLane, this, "receiveMilResetResponses");
+}
+
+void Automon::requestVehicleDetails()
+{
+    /*
+        Ask for the VIN, OBD standard, protocol, ELM327 version and battery voltage without blocking, eg: for the
+        car details widget. The vehicleDetailsReady() signal is emitted with them once the serial thread has the
+        answers. Works while monitoring.
+    */
+
+    QStringList commands;
+    commands << "0902" << "011C" << "ATDP" << "ATI" << "ATRV";
+
+    m_serialHelper->queueCommands(commands, 5000, CommandRequest::PriorityLane, this, "receiveVehicleDetails");
+}
+
+void Automon::receiveVehicleDetails(QStringList responses)
+{
+    /*
+        Called in the GUI thread with the answers to requestVehicleDetails(). What was already known, eg: from the
+        vehicle profile, is kept. The rest is remembered the same way the getters do
+    */
+
+    while (responses.size() < 5)
+        responses.append(QString(""));
+
+    QString vin = m_vinNumber;
+    QString standard = m_standardType;
+
+    if (vin.isEmpty())
+    {
+        bool valid;
+        vin = vinFromResponse(responses[0], valid);
+
+        if (valid)
+            m_vinNumber = vin;
+    }
+
+    if (standard.isEmpty())
+    {
+        standard = standardFromResponse(responses[1]);
+
+        if (standard != "Request Could Not Determine Protocol")
+            m_standardType = standard;
+    }
+
+    if (m_protocol.isEmpty())
+        m_protocol = cleanResponse(responses[2]);
+
+    if (m_elmVersion.isEmpty())
+        m_elmVersion = cleanResponse(responses[3]);
+
+    emit vehicleDetailsReady(vin, standard, m_protocol, m_elmVersion, cleanResponse(responses[4]));
+}
+
+void Automon::receiveDTCResponses(QStringList responses)
+{
+    /* Called in the GUI thread with the responses to the DTC refresh commands */
+    m_dtcHelper->applyRefreshResponses(responses);
+    m_numberDTCs = m_dtcHelper->getNumberOfCodes();
+
+    emit dtcInformationReady();
+}
+
+void Automon::receiveMilResetResponses(QStringList responses)
+{
+    /* The first response belongs to the mode 04 reset, the rest are the DTC refresh */
+    if (!responses.isEmpty())
+        responses.removeFirst();
+
+    receiveDTCResponses(responses);
+}
+
 bool Automon::connectSensorToSlot(Sensor * sender, QObject * receiver) const
 {
     /*
@@ -1259,7 +2080,7 @@ bool Automon::addActiveSensorByCommand(QString command)
             {
                 /* Only add to list if not already in there */
                 m_activeSensors.append(m_sensors[i]);
-                m_serialHelper->addActiveSensor(m_activeSensors.at(m_activeSensors.size()-1));
+                m_serialHelper->addActiveSensor(m_sensors[i]->getSource());
             }
 
             return true;
@@ -1291,8 +2112,11 @@ bool Automon::removeActiveSensorByCommand(QString command)
             /* Sensor match found so remove at this location in the local m_activeSensor list and remove from the serial I/O
                thread
             */
-            m_activeSensors.removeAt(i);
-            m_serialHelper->removeActiveSensorByCommand(command);
+            Sensor * sensor = m_activeSensors.takeAt(i);
+
+            /* Keep polling it if someone subscribed to it or another channel of it is active */
+            releaseSource(sensor);
+
             return true;
         }
     }
@@ -36,21 +36,32 @@
 #include <QLCDNumber>
 
 #include "command.h"
-#include "coolanttempsensor.h"
+#include "hexdecoder.h"
 #include "dtc.h"
 #include "dtchelper.h"
 #include "sensor.h"
 #include "serialhelper.h"
-#include "enginerpm.h"
-#include "engineruntime.h"
-#include "vehiclespeed.h"
-#include "fuelpressure.h"
-#include "throttleposition.h"
-#include "fuellevelinput.h"
-#include "mafairflowrate.h"
-#include "commandedegr.h"
-#include "o2voltage.h"
+#include "transport.h"
+#include "serialtransport.h"
+#include "ptytransport.h"
+#include "tcptransport.h"
+#include "replaytransport.h"
+#include "adapterdiscovery.h"
+#include "subscriptionmanager.h"
+#include "responsecounts.h"
+#include "pidtable.h"
+#include "tablesensor.h"
+#include "sensorchannel.h"
+#include "supportedpids.h"
+#include "vehicleprofile.h"
+#include "slidingwindow.h"
+#include "ruleprogram.h"
 #include "rule.h"
+#include "ruleengine.h"
+#include "rulecatalogue.h"
+#include "sensorhistory.h"
+#include "rulebacktest.h"
+#include "sessionrecorder.h"
 #ifdef Q_OS_MACX
 #include <err.h>
 #else
@@ -63,6 +74,9 @@
 
 #define TURNOFFECHO 1    /* Warning don't remove this. It will probably upset formulas that work on fact no echo */
 #define ADAPTIVETIMING 1 /* If set, adaptive timing will be set to speed up communication with ECU. Better to let enabled */
+#define REACTORIO 1      /* If set, the serial I/O thread waits on the port with epoll instead of polling it every 1ms */
+#define REPEATLAST 1     /* If set, a request identical to the previous one is sent as a bare carriage return */
+#define OPTIMISELINK 1   /* If set, init raises the baud rate with ATBRD and turns off spaces and linefeeds (ATS0, ATL0) */
 
 //#define RULEFILE "/home/eclipse/rules"
 //#define DTCCODEFILE "/home/eclipse/codes"
@@ -73,6 +87,7 @@
 // [LA]
 #define RULEFILE ":/files/rules"        /* Location of file for storing of user defined rules */
 #define DTCCODEFILE ":/files/codes"     /* Location of the DTC code description file */
+#define SESSIONFILE "session.csv"       /* Location of the sensor values recorded while monitoring. Rules are backtested on it */
 
 namespace AutomonKernel
 {
@@ -82,6 +97,7 @@ namespace AutomonKernel
 
     public:
         Automon(QString port = "/dev/ttyUSB0");
+        Automon(Transport * transport);
         ~Automon();
         QString getVin();
         QString getOBDStandardType();
@@ -92,6 +108,7 @@ namespace AutomonKernel
         QList<Sensor*> getAllSensors() const;
         QList<DTC*> getDTCs() const;
         bool sendCommand(Command & command);
+        CommandFuture sendCommandAsync(QString command, QObject * receiver = 0, const char * member = 0);
         void addSensor(Sensor * newSensor);
         bool addActiveSensorByCommand(QString command);
         bool removeActiveSensorByCommand(QString command);
@@ -102,7 +119,8 @@ namespace AutomonKernel
         bool connectSensorToSlot(Sensor * sender,QObject * receiver) const;
         bool disconnectSensorFromSlot(Sensor * sender, QObject * receiver) const;
         bool connectToErrorToSlot(QObject * receiver);
-        bool setSensorFrequency(Sensor * sensor, int frequency) const;
+        bool setSensorFrequency(Sensor * sensor, double frequency) const;
+        bool setSensorPriority(Sensor * sensor, int priority) const;
         bool addActiveSensor(Sensor * sensor);
         bool checkMil() const;
         int getNumCodes();
@@ -110,35 +128,104 @@ namespace AutomonKernel
         bool init();
         bool testElmConnectivity() const;
         bool refreshDTCInformation() const;
+        void requestDTCInformation();
+        void requestMilResetAndClearCodes();
+        void requestVehicleDetails();
         static QList<int> getBytes(Command & command);
         static QString cleanResponse(QString response);
         bool saveRuleList();
         bool loadRuleList();
         QStringList getRuleList();
+        const RuleCatalogue & getRuleCatalogue() const;
         void addRuleString(QString rule);
         void removeRuleString(QString rule);
         QString convertRuleToEnglish(QString rule) const;
         void removeRuleEnglishMeaningString(QString rule);
         QStringList extractSensorsFromRule(QString & rule) const;
-        void removeAllActiveSensors() const;
+        void removeAllActiveSensors();
         bool isMonitoring() const;
+        bool subscribe(QObject * subscriber, QString pid, double rate = 0, int priority = 0);
+        bool unsubscribe(QObject * subscriber, QString pid);
+        void unsubscribeAll(QObject * subscriber);
+        bool isSubscribed(QObject * subscriber, QString pid) const;
+        int activateRule(QString rule, QString ruleName);
+        int activateRule(int ruleId);
+        bool deactivateRule(int id);
+        QString getActiveRule(int id) const;
+        bool connectRulesToSlot(QObject * receiver);
+        bool setIOMode(SerialHelper::IOMode mode);
+        double getReadsPerSecond() const;
+        double getAllocatedRate(QString pid) const;
+        const ResponseClassifier & getResponseStatistics() const;
+        QString getTransportUri() const;
+        QString getLinkReport() const;
+        int getBusInitTime() const;
+        bool isPidSupported(int mode, int pid) const;
+        SupportedPids getSupportedPids() const;
+        bool setRecordFile(QString fileName);
+        bool setSessionFile(QString fileName);
 
     signals:
         void sendErrorMessage(QString); /* Used to send an error message to connected Slots */
         /* Used to send updates of progress during init stages to splash screen */
         void updateStatus(const QString & message, int alignment = Qt::AlignLeft, const QColor & color = Qt::black);
+        void dtcInformationReady(); /* Emitted when a requestDTCInformation() or requestMilResetAndClearCodes() finished */
+        /* Emitted when a requestVehicleDetails() finished */
+        void vehicleDetailsReady(QString vin, QString standard, QString protocol, QString elmVersion, QString voltage);
 
     public slots:
         void receiveErrorMessage(QString);
 
+    private slots:
+        void updateMonitoringState();
+        void receiveDTCResponses(QStringList responses);
+        void receiveMilResetResponses(QStringList responses);
+        void checkVehicleProfile();
+        void receiveProfileCheck(QStringList responses);
+        void receiveRelearnedVin(QStringList responses);
+        void receiveRangeResponse(QStringList responses);
+        void receiveResponseCounts(QStringList responses);
+        void receiveProfileDetails(QStringList responses);
+        void receiveVehicleDetails(QStringList responses);
+        void releaseSource(Sensor * sensor);
+
     private:
+        void setUpHelpers();
         bool initialiseBus();
+        bool optimiseLink();
+        double measureThroughput(double & bytesPerSecond);
         void loadSensors();
         void updateSensorSupport();
+        void applySensorSupport();
+        void learnResponseCounts();
+        QStringList responseCountCommands() const;
+        void storeResponseCounts(const QStringList & commands, const QStringList & responses);
+        void applyResponseCounts();
+        void buildRuleCatalogue();
+        QString renderRuleInEnglish(QString rule) const;
+        void loadVehicleProfile();
+        void storeVehicleProfile();
+        void saveVehicleProfile(QString protocolNumber);
+        void relearnVehicle();
+        void requestNextRange();
+        void requestResponseCounts();
+        void requestProfileDetails();
+        void discoverSupportedPids();
+        static QString decodeVin(QString buffer);
+        static QString vinFromResponse(QString buffer, bool & valid);
+        static QString standardFromResponse(QString buffer);
 
         QStringList m_ruleList;
+        RuleCatalogue m_ruleCatalogue;
+        SessionRecorder * m_sessionRecorder;
+        QString m_sessionFile;
         SerialHelper * m_serialHelper;
         DTCHelper * m_dtcHelper;
+        SubscriptionManager * m_subscriptions;
+        RuleEngine * m_ruleEngine;
+        ResponseCounts m_responseCounts;
+        VehicleProfile m_profile;
+        SupportedPids m_supportedPids;
         QList<Sensor*> m_sensors;
         QList<Sensor*> m_activeSensors;
         QList<Sensor*> freezeFrame;
@@ -155,10 +242,16 @@ namespace AutomonKernel
         QString m_protocol;
         QString m_standardType;
         QString m_elmVersion;
+        QString m_linkReport;
+        int m_busInitTime; /* How long initialiseBus() took in ms, -1 until it ran */
+        int m_profileChecks; /* Number of times the profile check got no answer, see receiveProfileCheck() */
+
+        /* A profile check nobody answered is tried again this much later, a few times */
+        enum { PROFILECHECKDELAY = 10000, PROFILECHECKATTEMPTS = 6 };
 
         /*
             This variable is used as a check if the serial I/O thread is monitoring.
-            Used for the main Automon application to prevent two tasks running together
+            Used for the main Automon application to know if sensors are being polled
         */
         bool m_isMonitoring;
 
@@ -169,8 +169,22 @@ void AutomonApp::init()
 
     try
     {
-        /* Create the AutomonKernel */
-        m_automonKernel = new Automon("/dev/ttyUSB0");
+        /*
+            Create the AutomonKernel. AUTOMON_TRANSPORT can point it at another adapter,
+            eg: tcp://192.168.0.10:35000 for a WiFi ELM327 or pty:///dev/pts/4 for the emulator
+        */
+        QString transport = QString::fromLocal8Bit(qgetenv("AUTOMON_TRANSPORT"));
+
+        if (transport.isEmpty())
+            transport = "/dev/ttyUSB0";
+
+        m_automonKernel = new Automon(transport);
+
+        /* AUTOMON_RECORD records the session so it can be replayed with replay://file */
+        QString recordFile = QString::fromLocal8Bit(qgetenv("AUTOMON_RECORD"));
+
+        if (!recordFile.isEmpty())
+            m_automonKernel->setRecordFile(recordFile);
 
         /* Connect the update status of the Kernel to the Splash screen so know what is happening in the kernel */
         connect(m_automonKernel, SIGNAL(updateStatus(QString,int,QColor)), m_splashScreen, SLOT(showMessage(QString,int,QColor)));
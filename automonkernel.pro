@@ -5,11 +5,12 @@ TEMPLATE = app
 DEPENDPATH += qtc-gdbmacros
 INCLUDEPATH += .
 QT += core gui widgets
-QT += script xml printsupport
+QT += xml printsupport
 !android: QT += serialport
 
 TARGET = automonkernel
 CONFIG -= app_bundle
+CONFIG += c++11
 #unix:OBJECTS_DIR = tmpobjects
 #TEMPL = appATE
 
@@ -21,20 +22,40 @@ CONFIG -= app_bundle
 # Input
 HEADERS += automon.h \
     command.h \
-    commandedegr.h \
-    coolanttempsensor.h \
     dtc.h \
     dtchelper.h \
-    enginerpm.h \
-    engineruntime.h \
-    fuellevelinput.h \
-    fuelpressure.h \
-    mafairflowrate.h \
-    o2voltage.h \
     sensor.h \
     serialhelper.h \
-    throttleposition.h \
-    vehiclespeed.h \
+    serialreactor.h \
+    pidbatcher.h \
+    pidscheduler.h \
+    commandfuture.h \
+    commandqueue.h \
+    activesensorset.h \
+    subscriptionmanager.h \
+    transport.h \
+    serialtransport.h \
+    ptytransport.h \
+    tcptransport.h \
+    replaytransport.h \
+    responsecounts.h \
+    vehicleprofile.h \
+    supportedpids.h \
+    hexdecoder.h \
+    responseclassifier.h \
+    pidtable.h \
+    tablesensor.h \
+    sensorchannel.h \
+    latencyhistogram.h \
+    timeouttuner.h \
+    adapterdiscovery.h \
+    slidingwindow.h \
+    ruleprogram.h \
+    ruleengine.h \
+    rulecatalogue.h \
+    sensorhistory.h \
+    rulebacktest.h \
+    sessionrecorder.h \
     errorhandler.h \
     rule.h \
     S5WDial.h \
@@ -53,21 +74,41 @@ HEADERS += automon.h \
     lib/QtSerialPort/qringbuffer_p.h
 SOURCES += automon.cpp \
     command.cpp \
-    commandedegr.cpp \
-    coolanttempsensor.cpp \
     dtc.cpp \
     dtchelper.cpp \
-    enginerpm.cpp \
-    engineruntime.cpp \
-    fuellevelinput.cpp \
-    fuelpressure.cpp \
-    mafairflowrate.cpp \
     main.cpp \
-    o2voltage.cpp \
     sensor.cpp \
     serialhelper.cpp \
-    throttleposition.cpp \
-    vehiclespeed.cpp \
+    serialreactor.cpp \
+    pidbatcher.cpp \
+    pidscheduler.cpp \
+    commandfuture.cpp \
+    commandqueue.cpp \
+    activesensorset.cpp \
+    subscriptionmanager.cpp \
+    transport.cpp \
+    serialtransport.cpp \
+    ptytransport.cpp \
+    tcptransport.cpp \
+    replaytransport.cpp \
+    responsecounts.cpp \
+    vehicleprofile.cpp \
+    supportedpids.cpp \
+    hexdecoder.cpp \
+    responseclassifier.cpp \
+    pidtable.cpp \
+    tablesensor.cpp \
+    sensorchannel.cpp \
+    latencyhistogram.cpp \
+    timeouttuner.cpp \
+    adapterdiscovery.cpp \
+    slidingwindow.cpp \
+    ruleprogram.cpp \
+    ruleengine.cpp \
+    rulecatalogue.cpp \
+    sensorhistory.cpp \
+    rulebacktest.cpp \
+    sessionrecorder.cpp \
     errorhandler.cpp \
     rule.cpp \
     S5WDial.cpp \
@@ -0,0 +1,22 @@
+# #####################################################################
+# Headless rule backtesting over a recorded session
+# #####################################################################
+TEMPLATE = app
+INCLUDEPATH += . ..
+QT += core
+QT -= gui
+
+TARGET = backtest
+CONFIG += console
+CONFIG -= app_bundle
+
+# Input
+HEADERS += ../ruleprogram.h \
+    ../slidingwindow.h \
+    ../sensorhistory.h \
+    ../rulebacktest.h
+SOURCES += main.cpp \
+    ../ruleprogram.cpp \
+    ../slidingwindow.cpp \
+    ../sensorhistory.cpp \
+    ../rulebacktest.cpp
@@ -0,0 +1,128 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <stdio.h>
+
+#include "sensorhistory.h"
+#include "rulebacktest.h"
+
+using namespace AutomonKernel;
+
+static bool backtest(const QString & rule, const SensorHistory & history)
+{
+    /* Run one rule over the session and print how often it fired, and when */
+
+    QElapsedTimer timer;
+    RuleBacktest backtest;
+
+    timer.start();
+
+    if (!backtest.run(rule, history))
+    {
+        printf("%s\n    error: %s\n", qPrintable(rule), qPrintable(backtest.getError()));
+        return false;
+    }
+
+    double elapsed = timer.nsecsElapsed() / 1000000.0;
+
+    printf("%s\n    fired %d times, satisfied for %.1f s, %d samples in %.3f ms\n", qPrintable(rule),
+           backtest.getFireCount(), backtest.getSatisfiedTime() / 1000.0, backtest.getSamples(), elapsed);
+
+    QVector<qint64> fireTimes = backtest.getFireTimes();
+
+    for (int i = 0; i < fireTimes.size(); i++)
+        printf("    %.3f s\n", (fireTimes.at(i) - history.timeAt(0)) / 1000.0);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    /*
+        Backtest rules over a session recorded while monitoring (see Automon::setSessionFile). The rules are
+        given after the session, or one per line on the standard input:
+
+            backtest session.csv "s010C > 4000 && s0105 < 40"
+            backtest session.csv < rules
+    */
+
+    QCoreApplication app(argc, argv);
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: backtest session.csv [rule ...]\n");
+        return 2;
+    }
+
+    SensorHistory history;
+
+    if (!history.load(argv[1]))
+    {
+        fprintf(stderr, "%s could not be read\n", argv[1]);
+        return 2;
+    }
+
+    printf("%s: %d rows, %d sensors, %.1f s\n\n", argv[1], history.size(), history.getColumnCount(),
+           history.getDuration() / 1000.0);
+
+    QStringList rules;
+
+    for (int i = 2; i < argc; i++)
+        rules.append(argv[i]);
+
+    if (rules.isEmpty())
+    {
+        QTextStream in(stdin);
+
+        while (!in.atEnd())
+        {
+            QString line = in.readLine().trimmed();
+
+            if (!line.isEmpty())
+                rules.append(line);
+        }
+    }
+
+    bool ok = true;
+
+    for (int i = 0; i < rules.size(); i++)
+        ok = backtest(rules.at(i), history) && ok;
+
+    return ok ? 0 : 1;
+}
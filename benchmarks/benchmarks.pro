@@ -0,0 +1,24 @@
+# #####################################################################
+# Micro-benchmarks for the hot paths of the Automon kernel
+# #####################################################################
+TEMPLATE = app
+INCLUDEPATH += . ..
+QT += core script
+QT -= gui
+
+TARGET = benchmarks
+CONFIG += console
+CONFIG -= app_bundle
+
+# Input
+HEADERS += ../hexdecoder.h \
+    ../ruleprogram.h \
+    ../slidingwindow.h \
+    ../sensorhistory.h \
+    ../rulebacktest.h
+SOURCES += main.cpp \
+    ../hexdecoder.cpp \
+    ../ruleprogram.cpp \
+    ../slidingwindow.cpp \
+    ../sensorhistory.cpp \
+    ../rulebacktest.cpp
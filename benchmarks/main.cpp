@@ -0,0 +1,299 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QRegExp>
+#include <QtScript>
+#include <stdio.h>
+
+#include "hexdecoder.h"
+#include "ruleprogram.h"
+#include "sensorhistory.h"
+#include "rulebacktest.h"
+
+using namespace AutomonKernel;
+
+static QList<int> legacyGetBytes(QString buffer)
+{
+    /*
+        Automon::getBytes() as it was before the HexDecoder, to compare against. Copied as it was, only taking
+        the buffer instead of the command
+    */
+
+    QList<int> result;
+
+    /* First grab the buffer the was populated by the Serial I/O thread and the ELM327 chip */
+    QString bufferResponse = buffer;
+
+    /* Remove any spaces in the response using a regular expression */
+    QRegExp removeSpaces( " " );
+    bufferResponse.replace(removeSpaces, "");
+
+    /* Remove the line break at the end that is sent back by the ELM327 */
+    QRegExp removeLineBreak( "\x0D" );
+    bufferResponse.replace(removeLineBreak, "");
+
+    /* Create a list of String bytes. */
+    QList<QString> bytes;
+
+    /* Ensure that the > character is at the end of the response. This is always sent by the ELM327 */
+    if (bufferResponse.at(bufferResponse.size()-1) != '>')
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "No prompt character found!";
+#endif
+    }
+    else
+    {
+        /* We have the prompt character, so all is good. Now remove it */
+        bufferResponse = bufferResponse.section("",0,bufferResponse.size()-1);
+
+        /*
+            The response back from the ELM327 will always be a even number of bytes.
+            Do a check for this before procedding
+        */
+
+
+        if ((bufferResponse.size() % 2) != 0)
+        {
+#ifdef DEBUGAUTOMON
+            qDebug() << "Uneven number of bytes, error!";
+#endif
+        }
+        else
+        {
+            /* All is well now. Response can be assumed valid */
+            for (int i = 0; i < bufferResponse.size(); i+=2)
+            {
+                /* For every second byte (ie, every Hexidecimal byte (2 ASCII bytes, ie: FF = 2 Bytes ASCII = 1 Byte int */
+                bytes.append(bufferResponse.section("",i+1,i+2));
+            }
+        }
+    }
+
+    /* This check is used in the toInt method of QString to check if it is a valid integer */
+    bool check;
+
+    for (int i = 0; i < bytes.size(); i++)
+    {
+        /* For each Byte string, eg: "FF" = 15base10, convert into an Integer and push onto the result list */
+
+        QByteArray temp(bytes[i].toLatin1());
+        result.append(temp.toInt(&check, 16));
+    }
+
+    /*
+        Now we have all the ASCII Hexidecimal strings converted into bytes.
+        EG: 10FF11
+            = "10", "FF", "11"
+            = 10 = 0001010 = integer 10, FF = 11111111 = integer 15, 11 = 0001011 = Integer 11
+    */
+
+    /* Return the list to the calling method */
+    return result;
+}
+
+static void benchmark(const char * name, const QString & response, int iterations)
+{
+    /* Time both decoders on the same response and check they agree. The sums keep the loops from being optimised out */
+
+    QElapsedTimer timer;
+    qint64 legacySum = 0;
+    qint64 decoderSum = 0;
+
+    timer.start();
+
+    for (int i = 0; i < iterations; i++)
+        legacySum += legacyGetBytes(response).value(2);
+
+    qint64 legacy = timer.nsecsElapsed();
+
+    timer.restart();
+
+    for (int i = 0; i < iterations; i++)
+        decoderSum += HexDecoder(response).at(2);
+
+    qint64 decoder = timer.nsecsElapsed();
+
+    /* getBytes() turned anything that wasn't hex into zeros, the HexDecoder gives no bytes at all */
+    const char * result = "same bytes";
+
+    if (HexDecoder(response).isEmpty())
+        result = "not hex, no bytes";
+    else if (legacyGetBytes(response) != HexDecoder(response).toList() || legacySum != decoderSum)
+        result = "DIFFERENT BYTES";
+
+    printf("%-28s getBytes %8.1f ns   HexDecoder %8.1f ns   %6.1fx   %s\n", name,
+           (double)legacy / iterations, (double)decoder / iterations, (double)legacy / qMax(decoder, (qint64)1),
+           result);
+}
+
+static void benchmarkRule(const char * rule, int iterations)
+{
+    /*
+        Time a rule the way Rule evaluated it before, with QtScript, against its RuleProgram. Both get a new
+        value for one sensor each time, as with a sample coming in, and have to agree on every result.
+    */
+
+    QElapsedTimer timer;
+    QScriptEngine engine;
+    RuleProgram program(rule);
+    double values[RuleProgram::MAXVARIABLES] = { 0 };
+    int scriptCount = 0;
+    int programCount = 0;
+
+    if (!program.isValid())
+    {
+        printf("%-40s does not compile: %s\n", rule, qPrintable(program.getError()));
+        return;
+    }
+
+    for (int v = 0; v < program.getVariableCount(); v++)
+        engine.globalObject().setProperty("s" + program.getVariable(v), 0.0);
+
+    QString first = "s" + program.getVariable(0);
+
+    timer.start();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        engine.globalObject().setProperty(first, (double)(i % 8000));
+        scriptCount += engine.evaluate(rule).toBoolean();
+    }
+
+    qint64 script = timer.nsecsElapsed();
+
+    timer.restart();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        values[0] = i % 8000;
+        programCount += program.isSatisfied(values);
+    }
+
+    qint64 compiled = timer.nsecsElapsed();
+
+    printf("%-40s QtScript %9.1f ns   RuleProgram %6.1f ns   %8.1fx   %s\n", rule,
+           (double)script / iterations, (double)compiled / iterations, (double)script / qMax(compiled, (qint64)1),
+           scriptCount == programCount ? "same results" : "DIFFERENT RESULTS");
+}
+
+static void benchmarkBacktest(const char * rule, const SensorHistory & history)
+{
+    /*
+        Time a backtest over the history, evaluated in blocks, against evaluating the rule a row at a time as
+        a live rule is. Both count the rows the rule is satisfied in
+    */
+
+    QElapsedTimer timer;
+    RuleProgram program(rule);
+    RuleBacktest backtest;
+    double values[RuleProgram::MAXVARIABLES] = { 0 };
+    const double * columns[RuleProgram::MAXVARIABLES];
+    int rowCount = 0;
+
+    for (int v = 0; v < program.getVariableCount(); v++)
+        columns[v] = history.column(history.indexOfColumn(program.getVariable(v)));
+
+    timer.start();
+
+    for (int row = 0; row < history.size(); row++)
+    {
+        for (int v = 0; v < program.getVariableCount(); v++)
+            values[v] = columns[v][row];
+
+        rowCount += program.isSatisfied(values);
+    }
+
+    qint64 rows = timer.nsecsElapsed();
+
+    timer.restart();
+    backtest.run(program, history);
+    qint64 blocks = timer.nsecsElapsed();
+
+    printf("%-40s rows %8.3f ms   blocks %8.3f ms   %6.1fx   %d rows satisfied, fired %d times\n", rule,
+           rows / 1000000.0, blocks / 1000000.0, (double)rows / qMax(blocks, (qint64)1), rowCount, backtest.getFireCount());
+}
+
+int main(int argc, char *argv[])
+{
+    /*
+        Micro-benchmarks for the kernel. Run without arguments, or give the number of iterations:
+
+            benchmarks 1000000
+    */
+
+    QCoreApplication app(argc, argv);
+
+    int iterations = 200000;
+
+    if (argc > 1)
+        iterations = QString(argv[1]).toInt();
+
+    printf("Response decoding, %d iterations each\n\n", iterations);
+
+    benchmark("Engine RPM", "41 0C 1A F8 \r\r>", iterations);
+    benchmark("Engine RPM, ATS0 ATL0", "410C1AF8\r\r>", iterations);
+    benchmark("Supported PIDs 0100", "41 00 BE 1F A8 13 \r\r>", iterations);
+    benchmark("VIN, 5 lines", "49 02 01 00 00 00 4F \r49 02 02 5A 45 4E 45 \r49 02 03 4C 45 4B 54 \r"
+                              "49 02 04 52 4F 4E 49 \r49 02 05 4B 31 32 33 \r\r>", iterations);
+    benchmark("NO DATA", "NO DATA\r\r>", iterations);
+
+    printf("\nRule evaluation, %d iterations each\n\n", iterations);
+
+    benchmarkRule("s010C > 4000 && s0105 < 40", iterations);
+    benchmarkRule("s010D > 60 && s010C < 2514", iterations);
+    benchmarkRule("(s010C - 800) / 2 >= 1500 || s0105 != 90", iterations);
+
+    /* An hour of two sensors changing every 50ms */
+    SensorHistory history;
+    int rpm = history.addColumn("010C");
+    int coolant = history.addColumn("0105");
+
+    for (int i = 0; i < 72000; i++)
+    {
+        history.append(i * 50, rpm, 800 + (i * 37) % 5000);
+        history.append(i * 50, coolant, 20 + i / 1000);
+    }
+
+    printf("\nBacktesting over %d rows\n\n", history.size());
+
+    benchmarkBacktest("s010C > 4000 && s0105 < 40", history);
+    benchmarkBacktest("(s010C - 800) / 2 >= 1500 || s0105 != 90", history);
+
+    return 0;
+}
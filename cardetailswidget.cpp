@@ -46,11 +46,11 @@ CarDetailsWidget::CarDetailsWidget(Automon * kernel, QWidget * parent)
 
     /* Create the labels that the user will see, including the tr() function for easy translation in future */
     m_header = new QLabel(tr("Car Details"));
-    QLabel * carVin = new QLabel(tr("<strong>Vehicle ID:</strong> ") + kernel->getVin());
-    QLabel * obdStandard = new QLabel(tr("<strong>Car's OBD Standard:</strong> ") + kernel->getOBDStandardType());
-    QLabel * obdProtocol = new QLabel(tr("<strong>Car's OBD Protocol:</strong> ") + kernel->getOBDProtocol());
-    QLabel * elmVersion = new QLabel(tr("<strong>ELM Interface Version:</strong> ") + kernel->getElmVersion());
-    QLabel * voltage = new QLabel(tr("<strong>Current Battery Voltage:</strong> ") + kernel->getVoltage());
+    m_carVin = new QLabel();
+    m_obdStandard = new QLabel();
+    m_obdProtocol = new QLabel();
+    m_elmVersion = new QLabel();
+    m_voltage = new QLabel();
     QLabel * introduction = new QLabel(tr("This widget displays some very simple car details."));
 
     /* Set style of header */
@@ -61,14 +61,33 @@ CarDetailsWidget::CarDetailsWidget(Automon * kernel, QWidget * parent)
     m_verticalLayout->addWidget(m_header);
     m_verticalLayout->addWidget(introduction);
     m_verticalLayout->addSpacing(10);
-    m_verticalLayout->addWidget(carVin);
-    m_verticalLayout->addWidget(obdStandard);
-    m_verticalLayout->addWidget(obdProtocol);
-    m_verticalLayout->addWidget(elmVersion);
-    m_verticalLayout->addWidget(voltage);
+    m_verticalLayout->addWidget(m_carVin);
+    m_verticalLayout->addWidget(m_obdStandard);
+    m_verticalLayout->addWidget(m_obdProtocol);
+    m_verticalLayout->addWidget(m_elmVersion);
+    m_verticalLayout->addWidget(m_voltage);
     m_verticalLayout->setAlignment(Qt::AlignTop);
     m_mainLayout->setAlignment(Qt::AlignTop);
 
     /* Set the main layout */
     setLayout(m_mainLayout);
+
+    /* Ask the ELM327 for the details without freezing the GUI. The labels are filled in when the answers arrive */
+    QString reading = tr("Reading...");
+    showDetails(reading, reading, reading, reading, reading);
+
+    connect(m_kernel, SIGNAL(vehicleDetailsReady(QString,QString,QString,QString,QString)),
+            this, SLOT(showDetails(QString,QString,QString,QString,QString)));
+    m_kernel->requestVehicleDetails();
+}
+
+void CarDetailsWidget::showDetails(QString vin, QString standard, QString protocol, QString elmVersion, QString voltage)
+{
+    /* This slot is called by the kernel with the car details requested in the constructor */
+
+    m_carVin->setText(tr("<strong>Vehicle ID:</strong> ") + vin);
+    m_obdStandard->setText(tr("<strong>Car's OBD Standard:</strong> ") + standard);
+    m_obdProtocol->setText(tr("<strong>Car's OBD Protocol:</strong> ") + protocol);
+    m_elmVersion->setText(tr("<strong>ELM Interface Version:</strong> ") + elmVersion);
+    m_voltage->setText(tr("<strong>Current Battery Voltage:</strong> ") + voltage);
 }
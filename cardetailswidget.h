@@ -52,9 +52,17 @@ public:
 
 signals:
     void changeStatus(const QString & status);
-    
+
+private slots:
+    void showDetails(QString vin, QString standard, QString protocol, QString elmVersion, QString voltage);
+
 private:
     QLabel * m_header;
+    QLabel * m_carVin;
+    QLabel * m_obdStandard;
+    QLabel * m_obdProtocol;
+    QLabel * m_elmVersion;
+    QLabel * m_voltage;
     QHBoxLayout * m_mainLayout;
     QVBoxLayout * m_verticalLayout;
     Automon * m_kernel;
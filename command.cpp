@@ -36,17 +36,20 @@ using namespace AutomonKernel;
 
 Command::Command()
 {
-
+    m_expectedBytes = 0;
+    m_responseCount = 0;
 }
 
 Command::Command(QString command, QString englishMeaning)
            : m_command(command), m_englishMeaning(englishMeaning)
 {
     /*
-        The expected bytes is something that the ELM327 uses. If you specify this in the command to the ELM327
-        it only waits for that many bytes, improving speed of response
+        The expected bytes is the number of data bytes the PID returns. It is what multi PID responses are split by.
+        The response count is the number of ECUs that answer. Sent after the PID, the ELM327 stops waiting once
+        that many responses arrived, improving speed of response. 0 means not known
     */
     m_expectedBytes = 0;
+    m_responseCount = 0;
 }
 
 void Command::setBuffer(QString bufferResponse)
@@ -84,6 +87,18 @@ int Command::getExpectedBytes()
     return m_expectedBytes;
 }
 
+void Command::setResponseCount(int responseCount)
+{
+    /* Set the number of ECUs that answer this command. Learned by Automon, see ResponseCounts */
+    m_responseCount = responseCount;
+}
+
+int Command::getResponseCount() const
+{
+    /* Get the number of ECU responses to wait for, 0 if not known */
+    return m_responseCount;
+}
+
 void Command::setEnglishMeaning(QString englishMeaning)
 {
     /* A setter to set the english meaning of the current command object */
@@ -49,6 +49,8 @@ namespace AutomonKernel
         void setCommand(QString command);
         void setExpectedBytes(int expectedBytes);
         int getExpectedBytes();
+        void setResponseCount(int responseCount);
+        int getResponseCount() const;
         QString getBuffer() const;
         QString getEnglishMeaning() const;
         QString getCommand() const;
@@ -60,6 +62,7 @@ namespace AutomonKernel
 
     private:
         int         m_expectedBytes;
+        int         m_responseCount;
 
     };
 }
@@ -0,0 +1,131 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+CommandRequest::CommandRequest(const QStringList & commands, int timeout, Lane lane)
+    : m_commands(commands), m_timeout(timeout), m_lane(lane)
+{
+    m_complete = false;
+}
+
+void CommandRequest::setCallback(QObject * receiver, const char * member)
+{
+    /*
+        The member is the name of a slot taking a QStringList, eg: "receiveResponses".
+        It is called through the receiver's event loop so it runs in the receiver's own thread.
+        QPointer means nothing is called if the receiver was deleted in the meantime.
+    */
+
+    m_receiver = receiver;
+    m_member = member;
+}
+
+void CommandRequest::finish(const QStringList & responses, bool complete)
+{
+    /* Called by the serial thread once every command in the request has been answered or timed out */
+
+    m_responses = responses;
+    m_complete = complete;
+
+    /* Wake anyone waiting on the future */
+    m_finished.release();
+
+    if (m_receiver && !m_member.isEmpty())
+        QMetaObject::invokeMethod(m_receiver, m_member.constData(), Qt::QueuedConnection, Q_ARG(QStringList, m_responses));
+}
+
+CommandFuture::CommandFuture()
+{
+}
+
+CommandFuture::CommandFuture(QSharedPointer<CommandRequest> request)
+    : m_request(request)
+{
+}
+
+bool CommandFuture::isValid() const
+{
+    /* A default constructed future isn't attached to any request */
+    return !m_request.isNull();
+}
+
+bool CommandFuture::isFinished() const
+{
+    return isValid() && m_request->m_finished.available() > 0;
+}
+
+bool CommandFuture::waitForFinished(int timeout)
+{
+    /*
+        Block the calling thread until the serial thread finished the request, or the timeout (ms) passed.
+        A negative timeout waits for as long as it takes. The semaphore is released again straight away so
+        the future can be waited on more than once.
+    */
+
+    if (!isValid())
+        return false;
+
+    if (!m_request->m_finished.tryAcquire(1, timeout))
+        return false;
+
+    m_request->m_finished.release();
+    return true;
+}
+
+bool CommandFuture::isComplete() const
+{
+    /* True if every command in the request got its prompt character back before timing out */
+    return isFinished() && m_request->m_complete;
+}
+
+QStringList CommandFuture::getResponses() const
+{
+    /* One raw response buffer per command, in the order they were sent */
+    if (!isFinished())
+        return QStringList();
+
+    return m_request->m_responses;
+}
+
+QString CommandFuture::getResponse(int index) const
+{
+    QStringList responses = getResponses();
+
+    if (index < 0 || index >= responses.size())
+        return QString("");
+
+    return responses[index];
+}
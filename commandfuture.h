@@ -0,0 +1,99 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef COMMANDFUTURE_H
+#define COMMANDFUTURE_H
+
+#include <QStringList>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QPointer>
+#include <QObject>
+
+namespace AutomonKernel
+{
+    /*
+        A CommandRequest is one or more commands for the ELM327 waiting in the serial thread's queue.
+        The commands of a request are sent back to back, nothing else gets onto the bus in between.
+        This matters for sequences like ATH1, 03, ATH0 where a sensor read in the middle would be parsed
+        with headers on.
+    */
+
+    class CommandRequest
+    {
+    public:
+        /*
+            The PriorityLane is for one off commands from the user interface. They go ahead of the next polling round.
+            The BackgroundLane is for work that can wait until no sensor is due.
+        */
+        enum Lane { PriorityLane, BackgroundLane };
+
+        CommandRequest(const QStringList & commands, int timeout, Lane lane);
+        void setCallback(QObject * receiver, const char * member);
+        void finish(const QStringList & responses, bool complete);
+
+        QStringList m_commands;
+        QStringList m_responses;
+        int m_timeout;
+        Lane m_lane;
+        bool m_complete;
+        QSemaphore m_finished;
+
+    private:
+        QPointer<QObject> m_receiver;
+        QByteArray m_member;
+    };
+
+    /*
+        A CommandFuture is handed back when a request is queued. The caller can wait on it, check it later
+        or ignore it and get the responses through the callback slot instead.
+    */
+
+    class CommandFuture
+    {
+    public:
+        CommandFuture();
+        CommandFuture(QSharedPointer<CommandRequest> request);
+        bool isValid() const;
+        bool isFinished() const;
+        bool waitForFinished(int timeout = -1);
+        bool isComplete() const;
+        QStringList getResponses() const;
+        QString getResponse(int index = 0) const;
+
+    private:
+        QSharedPointer<CommandRequest> m_request;
+    };
+}
+
+#endif // COMMANDFUTURE_H
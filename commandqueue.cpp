@@ -30,35 +30,70 @@
     
 */
 
+
 #include "automon.h"
 
 using namespace AutomonKernel;
 
-EngineRunTime::EngineRunTime(QString command, QString englishMeaning)
+CommandQueue::CommandQueue()
+    : m_incoming(0)
 {
-    m_command = command;
-    m_englishMeaning = englishMeaning;
+    m_pending = 0;
 }
 
-EngineRunTime::EngineRunTime()
+CommandQueue::~CommandQueue()
 {
-
-    m_command = "011F";
-    m_englishMeaning = "Engine Runtime";
-    setUnits(SECONDS);
-    setExpectedBytes(2);
-    setMin(0);
-    setMax(65535);
+    /* Free whatever was never taken off the queue */
+    while (!dequeue().isNull())
+        ;
 }
 
-double EngineRunTime::convertResult()
+void CommandQueue::enqueue(QSharedPointer<CommandRequest> request)
 {
-    /* This is the conversion formula. It basically returns the value from the bytes retrieved from the ECU */
+    /* Can be called from any thread. Push the node onto the incoming stack, retrying if another thread got in first */
 
-    QList<int> bytes = Automon::getBytes(*this);
+    Node * node = new Node;
+    node->request = request;
 
-    double value = (((int)bytes[2]*256) + (int)bytes[3]);
+    Node * head;
 
-    return value;
+    do
+    {
+        head = m_incoming.loadAcquire();
+        node->next = head;
+    }
+    while (!m_incoming.testAndSetRelease(head, node));
+}
 
+QSharedPointer<CommandRequest> CommandQueue::dequeue()
+{
+    /*
+        Only the serial thread calls this. Returns a null pointer if the queue is empty.
+        Taking the whole incoming stack at once means there is no ABA problem with the compare and swap above.
+    */
+
+    if (!m_pending)
+    {
+        Node * node = m_incoming.fetchAndStoreAcquire(0);
+
+        /* Reverse the stack so the oldest request comes out first */
+        while (node)
+        {
+            Node * next = node->next;
+            node->next = m_pending;
+            m_pending = node;
+            node = next;
+        }
+    }
+
+    if (!m_pending)
+        return QSharedPointer<CommandRequest>();
+
+    Node * node = m_pending;
+    m_pending = node->next;
+
+    QSharedPointer<CommandRequest> request = node->request;
+    delete node;
+
+    return request;
 }
@@ -0,0 +1,71 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <QAtomicPointer>
+#include <QSharedPointer>
+
+#include "commandfuture.h"
+
+namespace AutomonKernel
+{
+    /*
+        The CommandQueue is a lock free queue with many producers and one consumer, the serial thread.
+        Producers push onto an atomic stack with compare and swap so the GUI thread never waits on the
+        serial thread to queue a command. The consumer takes the whole stack in one atomic swap and
+        reverses it, so requests still come out in the order they were queued.
+    */
+
+    class CommandQueue
+    {
+    public:
+        CommandQueue();
+        ~CommandQueue();
+        void enqueue(QSharedPointer<CommandRequest> request);
+        QSharedPointer<CommandRequest> dequeue();
+
+    private:
+        struct Node
+        {
+            QSharedPointer<CommandRequest> request;
+            Node * next;
+        };
+
+        QAtomicPointer<Node> m_incoming; /* Pushed by the producers, newest first */
+        Node * m_pending;                /* Owned by the consumer, oldest first */
+    };
+}
+
+#endif // COMMANDQUEUE_H
@@ -1,63 +0,0 @@
-/*
-
-    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
-    Source Repository: https://github.com/donaloconnor/automon/
-    
-    Copyright (c) 2015, Donal O'Connor
-
-    All rights reserved.
-
-    Redistribution and use in source and binary forms, with or without
-    modification, are permitted provided that the following conditions are met:
-
-    * Redistributions of source code must retain the above copyright notice, this
-      list of conditions and the following disclaimer.
-
-    * Redistributions in binary form must reproduce the above copyright notice,
-      this list of conditions and the following disclaimer in the documentation
-      and/or other materials provided with the distribution.
-
-    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
-    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
-    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
-    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
-    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
-    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
-    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
-    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-    
-*/
-
-#include "automon.h"
-
-using namespace AutomonKernel;
-
-CoolantTempSensor::CoolantTempSensor(QString command, QString englishMeaning)
-{
-    m_command = command;
-    m_englishMeaning = englishMeaning;
-}
-
-CoolantTempSensor::CoolantTempSensor()
-{
-    m_command = "0105";
-    m_englishMeaning = "Engine coolant temperature";
-    setUnits(DEGREES);
-    setExpectedBytes(1);
-    setMin(-40);
-    setMax(215);
-}
-
-double CoolantTempSensor::convertResult()
-{
-    /* This is the conversion formula. It basically returns the value from the bytes retrieved from the ECU */
-
-    QList<int> bytes = Automon::getBytes(*this);
-
-    double value = (bytes[2]-40);
-
-    return value;
-
-}
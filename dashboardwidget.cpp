@@ -128,63 +128,41 @@ void DashboardWidget::startStopDashboard()
     {
         /* If in here, we are starting the dashboard */
 
-        /* Check to ensure that the Serial I/O thread isn't running already */
-        if (m_kernel->isMonitoring())
-        {
-            emit changeStatus(tr("Automon is currently busy with another task. Stop this first"));
-            return;
-        }
+        /*
+            The dials subscribe to the sensors they show. Anyone else using RPM or speed at the same time
+            shares the same ECU requests, so the dashboard can run beside monitoring or an acceleration test
+        */
 
         /* Disable clicking of the start/stop button for now */
         m_startStopButton->setEnabled(false);
 
         bool success = true;
 
-        /* Remove all sensors incase any in the serial I/O thread */
-        m_kernel->removeAllActiveSensors();
-
-        /* Get the two sensors we need */
-        Sensor * rpmSensor = m_kernel->getSensorByCommand("010C");
-        Sensor * kphSensor = m_kernel->getSensorByCommand("010D");
-
-        /* Add the rpmSensor by passing the pointer */
-        if (m_kernel->addActiveSensor(rpmSensor))
-            m_kernel->connectSensorToSlot(rpmSensor, m_revDial);
-        else
+        /* Subscribe the rev dial to the RPM sensor, as fast as possible */
+        if (!m_kernel->subscribe(m_revDial, "010C"))
             success = false; /* Sensor couldn't be added. */
 
-        /* Add the speedSensor by passing its pointer */
-        if (m_kernel->addActiveSensor(kphSensor))
-            m_kernel->connectSensorToSlot(kphSensor, m_speedDial);
-        else
+        /* Subscribe the speed dial to the speed sensor */
+        if (!m_kernel->subscribe(m_speedDial, "010D"))
             success = false; /* Speed sensor couldn't be added */
 
         if (!success)
         {
             /* If in here, one or more of the sensors could not be added */
 
-            /* Remove any sensors if any were added */
-            m_kernel->removeAllActiveSensors();
-
-            /* Disconnect any if already connected */
-            m_kernel->disconnectSensorFromSlot(rpmSensor, m_revDial);
-            m_kernel->disconnectSensorFromSlot(kphSensor, m_speedDial);
+            /* Remove any subscriptions if any were made */
+            m_kernel->unsubscribeAll(m_revDial);
+            m_kernel->unsubscribeAll(m_speedDial);
             emit changeStatus(tr("RPM or KPH Sensor could not be added to monitor. Exiting!"));
+            m_startStopButton->setEnabled(true);
             return;
         }
 
-        /* If at this pointer, sensors were added successfully */
+        /* If at this pointer, sensors were subscribed successfully and are being polled */
 
         /* Set the start/stop button to Stop Dashboard since it will be running now */
         m_startStopButton->setText(tr("Stop Dashboard"));
 
-        if (!m_kernel->startMonitoring())
-        {
-            /* We should not get in here */
-            emit changeStatus(tr("Failed to start serial thread. This is an exception! Restart the device."));
-            return;
-        }
-
         /* Monitoring has started now, set the button to enabled again so they can stop the dashboard */
         m_startStopButton->setEnabled(true);
         emit changeStatus(tr("Dashboard Started!"));
@@ -199,19 +177,9 @@ void DashboardWidget::startStopDashboard()
         /* If in here, dashboard was running and we now stopping it */
         m_startStopButton->setEnabled(false);
 
-        /* Stop the serial I/O thread */
-        m_kernel->stopMonitoring();
-
-        /* Get sensor pointers */
-        Sensor * rpmSensor = m_kernel->getSensorByCommand("010C");
-        Sensor * kphSensor = m_kernel->getSensorByCommand("010D");
-
-        /* Disconnect sensors from our slot */
-        m_kernel->disconnectSensorFromSlot(rpmSensor, m_revDial);
-        m_kernel->disconnectSensorFromSlot(kphSensor, m_speedDial);
-
-        /* Remove all sensors from Serial Thread */
-        m_kernel->removeAllActiveSensors();
+        /* Take the dials off the sensors. Polling only stops if nobody else is subscribed */
+        m_kernel->unsubscribeAll(m_revDial);
+        m_kernel->unsubscribeAll(m_speedDial);
 
         /* Update button text and re enable */
         m_startStopButton->setText(tr("Start Monitoring"));
@@ -90,6 +90,11 @@ DiagnosticsWidget::DiagnosticsWidget(Automon * kernel, QWidget * parent)
     m_checkButton->setFixedWidth(200);
     connect(m_checkButton, SIGNAL(clicked()), this, SLOT(checkECU()));
 
+    /* The DTC information arrives from the serial thread later, so the results are shown from this slot */
+    m_isResettingMil = false;
+    if (m_kernel)
+        connect(m_kernel, SIGNAL(dtcInformationReady()), this, SLOT(ecuChecked()));
+
     /* Add more widgets to the layouts */
     m_buttonsTop->addWidget(m_checkButton);
     m_buttonsTop->addStretch();
@@ -175,16 +180,10 @@ void DiagnosticsWidget::resetMIL()
 {
     /*
         This is the slot that is called when user clicks the reset MIL button if it's active.
-        In here we send a command to reset the MIL and clear codes
+        In here we send a command to reset the MIL and clear codes. The commands are queued in the serial
+        thread so this works while monitoring too. ecuChecked() is called when they are done.
     */
 
-    if (m_kernel->isMonitoring())
-    {
-        /* Don't continue if Automon is currently doing something else with the serial thread */
-        emit changeStatus(tr("Automon is currently busy with another task. Stop this first"));
-        return;
-    }
-
     /* Display the Reset MIL Prompt box */
 
     int ret = m_resetMilPromptBox->exec();
@@ -201,31 +200,10 @@ void DiagnosticsWidget::resetMIL()
 
             emit changeStatus(tr("Resetting MIL and clearing diagnostics codes"));
 
-            /* Call the kernel function to clear the MIL and delete the DTCs */
-            m_kernel->resetMilAndClearCodes();
-
-            /* Refresh DTC info now */
-            m_kernel->refreshDTCInformation();
-
-            if (m_kernel->getNumCodes() == 0)
-            {
-                /* Should get in here as codes now gone. */
-                emit changeStatus(tr("MIL successfully reset and all DTCs cleared"));
-                displayMilResetMsg();
-                setMilPicOff();
-            }
-            else
-            {
-                /* By right we should have 0 DTCs now since Mil off but could come on if car messed up */
-                setupDTCTable();
-
-                if (m_kernel->checkMil())
-                {
-                    setMilPicOn();
-                    emit changeStatus(tr("Warning - The MIL is still on after a reset. Needs attention"));
-                    m_resetMilButton->setEnabled(true);
-                }
-            }
+            /* Ask the kernel to clear the MIL, delete the DTCs and refresh the DTC info after */
+            m_checkButton->setEnabled(false);
+            m_isResettingMil = true;
+            m_kernel->requestMilResetAndClearCodes();
         }
     }
     else
@@ -237,26 +215,52 @@ void DiagnosticsWidget::resetMIL()
 
 void DiagnosticsWidget::checkECU()
 {
-    /* This is the slot that is called when user clicks check ECU */
-
-    if (m_kernel->isMonitoring())
-    {
-        /* Don't continue if Automon is busy with something else */
-        emit changeStatus(tr("Automon is currently busy with another task. Stop this first"));
-        return;
-    }
+    /*
+        This is the slot that is called when user clicks check ECU. The request is queued in the serial thread
+        and this returns straight away. ecuChecked() is called with the result.
+    */
 
     /* Disable the checkButton for now */
     m_checkButton->setEnabled(false);
 
     emit changeStatus(tr("Checking ECU for new DTCs"));
 
-    /* Call the Kernel's refresh DTC information method that will recheck for DTC codes and update list */
-    m_kernel->refreshDTCInformation();
+    /* Ask the kernel to recheck for DTC codes. The list is updated when the ECU answered */
+    m_isResettingMil = false;
+    m_kernel->requestDTCInformation();
+}
+
+void DiagnosticsWidget::ecuChecked()
+{
+    /* This slot is called when the kernel has fresh DTC information, after a check or a MIL reset */
 
     emit changeStatus(tr("Communication Received"));
 
-    if (m_kernel->getNumCodes() > 0 && m_kernel->checkMil())
+    if (m_isResettingMil)
+    {
+        m_isResettingMil = false;
+
+        if (m_kernel->getNumCodes() == 0)
+        {
+            /* Should get in here as codes now gone. */
+            emit changeStatus(tr("MIL successfully reset and all DTCs cleared"));
+            displayMilResetMsg();
+            setMilPicOff();
+        }
+        else
+        {
+            /* By right we should have 0 DTCs now since Mil off but could come on if car messed up */
+            setupDTCTable();
+
+            if (m_kernel->checkMil())
+            {
+                setMilPicOn();
+                emit changeStatus(tr("Warning - The MIL is still on after a reset. Needs attention"));
+                m_resetMilButton->setEnabled(true);
+            }
+        }
+    }
+    else if (m_kernel->getNumCodes() > 0 && m_kernel->checkMil())
     {
         /* Codes were found since Automon was started. Set message and update DTC table */
         emit changeStatus(tr("MIL light is *ON* and DTCs found! - Displaying..."));
@@ -58,6 +58,7 @@ signals:
 public slots:
     void resetMIL();    /* Slot for the reset MIL button */
     void checkECU();    /* Slot for the CheckECU button */
+    void ecuChecked();  /* Slot for when the kernel has fresh DTC information */
 
 private:
     void setupDTCTable();
@@ -82,6 +83,7 @@ private:
     QString engineMilOffPic;
     QLabel * engineMilPic;
     QMessageBox * m_resetMilPromptBox;
+    bool m_isResettingMil;
 
 
 };
@@ -102,12 +102,22 @@ void DTCHelper::setNumCodes()
 
     m_serialHelper->sendCommand(mode0101);
 
+    parseNumCodes(mode0101.getBuffer());
+}
+
+void DTCHelper::parseNumCodes(QString buffer)
+{
+    /* This method reads the MIL state and number of codes out of a mode 0101 response */
+
     /* Read back bytes in integer format */
-    QList<int> bytes = Automon::getBytes(mode0101);
+    HexDecoder bytes(buffer);
+
+    /* A response without the status byte means the ECU didn't answer. Keep what we had */
+    if (bytes.size() < 3)
+        return;
 
     /* Do a bit wise and to check if the MIL is on / off as it is bit encoded */
-    if ((int)(bytes[2] & 0x80) == 128)
-        m_milOn = true;
+    m_milOn = ((int)(bytes[2] & 0x80) == 128);
 
     /* The number of codes is specified by the lower bytes */
     m_numCodes = ((int)(bytes[2] & 0x7F));
@@ -143,6 +153,37 @@ void DTCHelper::refreshDTCInformation()
 
     if (m_numCodes > 0)
         loadFoundCodes(); /* If 1 or more codes, update the DTC code list */
+    else
+        m_codesFound.clear();
+}
+
+QStringList DTCHelper::getRefreshCommands()
+{
+    /*
+        The commands needed to refresh the DTC information in one go. They are queued as one group so no sensor
+        read gets between ATH1 and ATH0 while monitoring. Mode 03 is sent even if there are no codes, which costs
+        less than waiting for the 0101 answer before deciding.
+    */
+
+    QStringList commands;
+    commands << "0101" << "ATH1" << "03" << "ATH0";
+    return commands;
+}
+
+void DTCHelper::applyRefreshResponses(const QStringList & responses)
+{
+    /* Update the MIL state and codes found from the responses to getRefreshCommands(), in the same order */
+
+    if (responses.size() < 4)
+        return;
+
+    parseNumCodes(responses[0]);
+
+    /* Clear list incase old ones still present */
+    m_codesFound.clear();
+
+    if (m_numCodes > 0)
+        parseFoundCodes(responses[2]);
 }
 
 void DTCHelper::loadFoundCodes()
@@ -157,6 +198,18 @@ void DTCHelper::loadFoundCodes()
     if (m_numCodes == 0)
         return;
 
+    /* Turn headers on, send the mode 3 request and turn headers off again, all as one group */
+    QStringList commands;
+    commands << "ATH1" << "03" << "ATH0";
+
+    CommandFuture future = m_serialHelper->queueCommands(commands);
+    future.waitForFinished();
+
+    parseFoundCodes(future.getResponse(1));
+}
+
+void DTCHelper::parseFoundCodes(QString bufferResponse)
+{
     /*
         This is a complicated process since multiple ECU's may exist and '43' is a valid part of a command
         so we don't know for sure where our codes are in the returned string
@@ -165,20 +218,7 @@ void DTCHelper::loadFoundCodes()
     */
 
 
-    /* Turn headers on */
-    Command turnHeadersOn;
-    turnHeadersOn.setCommand("ATH1");
-    m_serialHelper->sendCommand(turnHeadersOn);
-
-    /* Next send mode3 request */
-
-    Command mode3Command;
-    mode3Command.setCommand("03");
-    m_serialHelper->sendCommand(mode3Command);
-
     /* Now we must parse the buffer and remove spaces */
-    QString bufferResponse = mode3Command.getBuffer();
-
     QRegExp removeSpaces( " " );
     bufferResponse.replace(removeSpaces, "");
     QRegExp removeLineBreak( "\x0D" );
@@ -188,7 +228,7 @@ void DTCHelper::loadFoundCodes()
     QList<QString> bytes;
     QList<QString> unParsedCodes;
 
-    if (bufferResponse.at(bufferResponse.size()-1) != '>')
+    if (bufferResponse.isEmpty() || bufferResponse.at(bufferResponse.size()-1) != '>')
         qDebug() << "No prompt character found!";
     else
     {
@@ -331,11 +371,6 @@ void DTCHelper::loadFoundCodes()
         }
 
     }
-
-    /* Turn off headers again */
-    Command turnHeadersOff;
-    turnHeadersOff.setCommand("ATH0");
-    m_serialHelper->sendCommand(turnHeadersOff);
 }
 
 bool DTCHelper::resetMilAndClearCodes()
@@ -50,12 +50,16 @@ namespace AutomonKernel
         bool checkMil() const;
         void init();
         void refreshDTCInformation();
+        static QStringList getRefreshCommands();
+        void applyRefreshResponses(const QStringList & responses);
 
 
     private:
         void loadCodes();
         void loadFoundCodes();
         void setNumCodes();
+        void parseNumCodes(QString buffer);
+        void parseFoundCodes(QString bufferResponse);
         QList<DTC*> m_codeDB;
         QList<DTC*> m_codesFound;
         QList<Sensor*> m_freezeFrame;
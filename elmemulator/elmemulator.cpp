@@ -0,0 +1,451 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include <QRegExp>
+
+#include "elmemulator.h"
+
+using namespace AutomonEmulator;
+
+ElmEmulator::ElmEmulator(Protocol protocol, int ecuCount)
+{
+    /* Set up the ECUs on the bus. The first one is always the engine ECU */
+
+    for (int i = 0; i < qMax(ecuCount, 1); i++)
+        m_ecus.append(new VirtualEcu(i));
+
+    m_protocol = protocol;
+    m_latency = 0;
+    m_jitter = 0;
+    m_noDataPercent = 0;
+    m_busErrorPercent = 0;
+    m_truncatePercent = 0;
+    m_requestCount = 0;
+
+    m_clock.start();
+
+    reset();
+}
+
+ElmEmulator::~ElmEmulator()
+{
+    /* Delete the ECUs from the heap */
+    qDeleteAll(m_ecus);
+    m_ecus.clear();
+}
+
+void ElmEmulator::reset()
+{
+    /* Put the settings back to what an ELM327 has after ATZ. The first OBD request searches for the protocol */
+
+    m_echo = true;
+    m_headers = false;
+    m_spaces = true;
+    m_linefeeds = false;
+    m_canAutoFormat = true;
+    m_searching = true;
+    m_lastCommand.clear();
+}
+
+void ElmEmulator::setLatency(int milliseconds)
+{
+    /* How long the ECUs take to answer an OBD request. AT commands are always answered straight away */
+    m_latency = milliseconds;
+}
+
+void ElmEmulator::setPidLatency(int pid, int milliseconds)
+{
+    /* Override the latency of one mode 01 PID, eg: a slow PID on a gateway ECU */
+    m_pidLatency[pid] = milliseconds;
+}
+
+void ElmEmulator::setJitter(int milliseconds)
+{
+    /* Add up to this many random milliseconds to every OBD request */
+    m_jitter = milliseconds;
+}
+
+void ElmEmulator::setFaultRates(int noDataPercent, int busErrorPercent, int truncatePercent)
+{
+    /*
+        Set the percentage of OBD requests that are answered with NO DATA, BUS ERROR or with the last byte cut
+        off the response. Rolled independently of each other, in that order
+    */
+    m_noDataPercent = noDataPercent;
+    m_busErrorPercent = busErrorPercent;
+    m_truncatePercent = truncatePercent;
+}
+
+void ElmEmulator::clearCodes()
+{
+    /* Clear the stored codes in every ECU, as if mode 04 was sent */
+    for (int i = 0; i < m_ecus.size(); i++)
+        m_ecus[i]->clearCodes();
+}
+
+int ElmEmulator::getRequestCount() const
+{
+    /* The number of requests handled since the emulator started */
+    return m_requestCount;
+}
+
+QByteArray ElmEmulator::process(QByteArray request, int & latency)
+{
+    /*
+        Handle one request line, without its carriage return. Returns everything the ELM327 sends back,
+        the echo and prompt character included. latency is set to how long the ECUs took to answer, in ms.
+        An empty line repeats the last command, like the real ELM327 does.
+    */
+
+    latency = 0;
+
+    QByteArray reply;
+
+    if (m_echo)
+        reply = request + "\x0D";
+
+    /* The ELM327 ignores spaces and case */
+    QString command = QString::fromLatin1(request).toUpper();
+    command.remove(' ');
+    command.remove('\n');
+
+    if (command.isEmpty())
+    {
+        if (m_lastCommand.isEmpty())
+            return reply + ">";
+
+        command = m_lastCommand;
+    }
+
+    m_lastCommand = command;
+    m_requestCount++;
+
+    if (command.startsWith("AT"))
+        reply += processAt(command.mid(2));
+    else
+        reply += processObd(command, latency);
+
+    return reply;
+}
+
+QByteArray ElmEmulator::processAt(QString command)
+{
+    /* Handle an AT command. Only the ones Automon and the usual OBD tools send are implemented */
+
+    QList<QByteArray> lines;
+
+    if (command == "Z" || command == "WS")
+    {
+        reset();
+        lines << "" << "" << "ELM327 v1.5";
+    }
+    else if (command == "D")
+    {
+        reset();
+        lines << "OK";
+    }
+    else if (command == "I")
+        lines << "ELM327 v1.5";
+    else if (command == "@1")
+        lines << "OBDII to RS232 Interpreter";
+    else if (command == "RV")
+        lines << QString("%1V").arg(12.0 + (qrand() % 10) / 10.0, 0, 'f', 1).toLatin1();
+    else if (command == "DP")
+        lines << describeProtocol().toLatin1();
+    else if (command == "DPN")
+        lines << (m_protocol == Iso9141 ? "A3" : "A6");
+    else if (command == "E0" || command == "E1")
+    {
+        m_echo = command.endsWith("1");
+        lines << "OK";
+    }
+    else if (command == "H0" || command == "H1")
+    {
+        m_headers = command.endsWith("1");
+        lines << "OK";
+    }
+    else if (command == "S0" || command == "S1")
+    {
+        m_spaces = command.endsWith("1");
+        lines << "OK";
+    }
+    else if (command == "L0" || command == "L1")
+    {
+        m_linefeeds = command.endsWith("1");
+        lines << "OK";
+    }
+    else if (command == "CAF0" || command == "CAF1")
+    {
+        m_canAutoFormat = command.endsWith("1");
+        lines << "OK";
+    }
+    else if (command.startsWith("AT") || command.startsWith("ST") || command.startsWith("SP") ||
+             command.startsWith("TP") || command == "M0" || command == "AL" || command == "NL")
+    {
+        /* Timing and protocol selection don't change anything in the emulator, the bus is always up */
+        lines << "OK";
+    }
+    else
+        lines << "?";
+
+    return finish(lines);
+}
+
+QByteArray ElmEmulator::processObd(QString command, int & latency)
+{
+    /* Handle an OBD request, eg: 010C, 010C0D05 or 0902. A trailing single digit is the response count */
+
+    if ((command.length() % 2) != 0)
+        command.chop(1); /* The number of responses to wait for. We always answer straight away */
+
+    /* A mode and up to six PIDs, all hex */
+    if (command.isEmpty() || command.length() > 14 || !QRegExp("[0-9A-F]+").exactMatch(command))
+        return finish(QList<QByteArray>() << "?");
+
+    QByteArray request = QByteArray::fromHex(command.toLatin1());
+
+    int mode = (quint8)request[0];
+    QList<QByteArray> lines;
+
+    if (m_searching)
+    {
+        /* The first OBD request after a reset makes the ELM327 search for the protocol */
+        lines << "SEARCHING...";
+        m_searching = false;
+    }
+
+    /* Work out how long the ECUs take. A multi PID request takes as long as its slowest PID */
+    latency = m_latency;
+
+    if (mode == 0x01)
+        for (int i = 1; i < request.size(); i++)
+            latency = qMax(latency, m_pidLatency.value((quint8)request[i], m_latency));
+
+    if (m_jitter > 0)
+        latency += qrand() % (m_jitter + 1);
+
+    /* Fault injection */
+    if (m_noDataPercent > 0 && qrand() % 100 < m_noDataPercent)
+        return finish(lines << "NO DATA");
+
+    if (m_busErrorPercent > 0 && qrand() % 100 < m_busErrorPercent)
+        return finish(lines << "BUS ERROR");
+
+    int header = lines.size();
+
+    for (int e = 0; e < m_ecus.size(); e++)
+    {
+        VirtualEcu * ecu = m_ecus[e];
+
+        if (mode == 0x01 && request.size() > 1)
+        {
+            /* Multi PID requests only exist on CAN. ISO 9141 ECUs don't answer them */
+            if (request.size() > 2 && m_protocol == Iso9141)
+                break;
+
+            QByteArray data(1, (char)0x41);
+
+            for (int i = 1; i < request.size(); i++)
+            {
+                int pid = (quint8)request[i];
+
+                if (ecu->isSupported(pid))
+                    data += QByteArray(1, (char)pid) + ecu->getPidData(pid, m_clock.elapsed());
+            }
+
+            if (data.size() > 1)
+                lines += formatMessage(ecu, data);
+        }
+        else if (mode == 0x03 && request.size() == 1)
+        {
+            /* Stored codes, two bytes each. ISO 9141 sends three codes per frame, CAN puts a count in front */
+            QList<quint16> codes = ecu->getCodes();
+            QByteArray data(1, (char)0x43);
+
+            if (m_protocol == Can11Bit500)
+                data += (char)codes.size();
+
+            for (int i = 0; i < codes.size(); i++)
+            {
+                data += (char)(codes[i] >> 8);
+                data += (char)(codes[i] & 0xFF);
+
+                if (m_protocol == Iso9141 && (i % 3) == 2 && i < codes.size() - 1)
+                {
+                    lines += formatMessage(ecu, data);
+                    data = QByteArray(1, (char)0x43);
+                }
+            }
+
+            if (m_protocol == Iso9141)
+                data = data.leftJustified(7, '\0');
+
+            lines += formatMessage(ecu, data);
+        }
+        else if (mode == 0x04 && request.size() == 1)
+        {
+            ecu->clearCodes();
+            lines += formatMessage(ecu, QByteArray(1, (char)0x44));
+        }
+        else if (mode == 0x09 && request.size() == 2 && ecu->answers(mode, (quint8)request[1]))
+        {
+            if (request[1] == 0x00)
+                lines += formatMessage(ecu, QByteArray::fromHex("490040000000"));
+            else if (m_protocol == Can11Bit500)
+                lines += formatMessage(ecu, QByteArray::fromHex("490201") + ecu->getVin());
+            else
+            {
+                /* ISO 9141 sends the VIN over five frames, four bytes each, the first padded with zeros */
+                QByteArray vin = QByteArray(3, '\0') + ecu->getVin();
+
+                for (int frame = 0; frame < 5; frame++)
+                {
+                    QByteArray data = QByteArray::fromHex("4902");
+                    data += (char)(frame + 1);
+                    data += vin.mid(frame * 4, 4);
+                    lines += formatMessage(ecu, data);
+                }
+            }
+        }
+    }
+
+    if (lines.size() == header)
+        return finish(lines << "NO DATA");
+
+    if (m_truncatePercent > 0 && qrand() % 100 < m_truncatePercent)
+    {
+        /* Cut the last byte off the last frame, as if it got lost on the bus */
+        lines.last().chop(m_spaces ? 3 : 2);
+    }
+
+    return finish(lines);
+}
+
+QByteArray ElmEmulator::formatBytes(const QByteArray & bytes) const
+{
+    /* Print bytes as hex the way the ELM327 does, with a space after each byte unless spaces are off */
+
+    QByteArray text;
+
+    for (int i = 0; i < bytes.size(); i++)
+    {
+        text += QByteArray(1, bytes[i]).toHex().toUpper();
+
+        if (m_spaces)
+            text += ' ';
+    }
+
+    return text;
+}
+
+QList<QByteArray> ElmEmulator::formatMessage(const VirtualEcu * ecu, const QByteArray & data) const
+{
+    /*
+        Turn one ECU message into the lines the ELM327 prints for it. ISO 9141 messages are always one frame.
+        CAN messages longer than seven bytes are split into a first frame and consecutive frames
+    */
+
+    QList<QByteArray> lines;
+
+    if (m_protocol == Iso9141)
+    {
+        /* Header is priority 48, target 6B and the ECU address. The checksum is the sum of all bytes */
+        QByteArray frame;
+        frame += (char)0x48;
+        frame += (char)0x6B;
+        frame += (char)ecu->getIsoAddress();
+        frame += data;
+
+        quint8 checksum = 0;
+        for (int i = 0; i < frame.size(); i++)
+            checksum += (quint8)frame[i];
+
+        lines << (m_headers ? formatBytes(frame + (char)checksum) : formatBytes(data));
+        return lines;
+    }
+
+    QByteArray id = QByteArray::number(ecu->getCanId(), 16).toUpper() + (m_spaces ? " " : "");
+    bool showPci = m_headers || !m_canAutoFormat;
+
+    if (data.size() <= 7)
+    {
+        /* Single frame. The PCI byte is the length */
+        lines << (m_headers ? id : QByteArray()) + formatBytes(showPci ? QByteArray(1, (char)data.size()) + data : data);
+        return lines;
+    }
+
+    if (!showPci)
+    {
+        /* The ELM327 prints the length on its own line, then each frame numbered */
+        lines << QByteArray::number(data.size(), 16).toUpper().rightJustified(3, '0');
+        lines << "0:" + QByteArray(m_spaces ? " " : "") + formatBytes(data.left(6));
+
+        for (int i = 6, frame = 1; i < data.size(); i += 7, frame++)
+            lines << QByteArray::number(frame % 16, 16).toUpper() + ":" + (m_spaces ? " " : "") +
+                     formatBytes(data.mid(i, 7).leftJustified(7, '\0'));
+
+        return lines;
+    }
+
+    /* First frame 10 LL, then consecutive frames 21, 22 ... */
+    QByteArray first;
+    first += (char)(0x10 | ((data.size() >> 8) & 0x0F));
+    first += (char)(data.size() & 0xFF);
+
+    lines << (m_headers ? id : QByteArray()) + formatBytes(first + data.left(6));
+
+    for (int i = 6, frame = 1; i < data.size(); i += 7, frame++)
+        lines << (m_headers ? id : QByteArray()) +
+                 formatBytes(QByteArray(1, (char)(0x20 | (frame % 16))) + data.mid(i, 7).leftJustified(7, '\0'));
+
+    return lines;
+}
+
+QByteArray ElmEmulator::finish(const QList<QByteArray> & lines) const
+{
+    /* End each line, add the blank line and the prompt character */
+
+    QByteArray end = m_linefeeds ? "\x0D\x0A" : "\x0D";
+    QByteArray reply;
+
+    for (int i = 0; i < lines.size(); i++)
+        reply += lines[i] + end;
+
+    return reply + end + ">";
+}
+
+QString ElmEmulator::describeProtocol() const
+{
+    /* The answer to ATDP */
+    return m_protocol == Iso9141 ? "AUTO, ISO 9141-2" : "AUTO, ISO 15765-4 (CAN 11/500)";
+}
@@ -0,0 +1,98 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef ELMEMULATOR_H
+#define ELMEMULATOR_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include "virtualecu.h"
+
+namespace AutomonEmulator
+{
+    /*
+        The ElmEmulator behaves like an ELM327 with one or more ECUs behind it. It takes a request line as typed
+        to the ELM327 and returns the bytes the ELM327 would send back, prompt character included. It implements
+        the AT commands Automon uses, modes 01, 03, 04 and 09, ISO 9141-2 and CAN 11/500 response formats,
+        and can be told to inject faults. It does no I/O itself, see EmulatorServer for that.
+    */
+
+    class ElmEmulator
+    {
+    public:
+        enum Protocol { Iso9141, Can11Bit500 };
+
+        ElmEmulator(Protocol protocol = Iso9141, int ecuCount = 1);
+        ~ElmEmulator();
+        QByteArray process(QByteArray request, int & latency);
+        void setLatency(int milliseconds);
+        void setPidLatency(int pid, int milliseconds);
+        void setJitter(int milliseconds);
+        void setFaultRates(int noDataPercent, int busErrorPercent, int truncatePercent);
+        void clearCodes();
+        int getRequestCount() const;
+
+    private:
+        void reset();
+        QByteArray processAt(QString command);
+        QByteArray processObd(QString command, int & latency);
+        QList<QByteArray> formatMessage(const VirtualEcu * ecu, const QByteArray & data) const;
+        QByteArray formatBytes(const QByteArray & bytes) const;
+        QByteArray finish(const QList<QByteArray> & lines) const;
+        QString describeProtocol() const;
+
+        QList<VirtualEcu*> m_ecus;
+        QMap<int, int> m_pidLatency;
+        QElapsedTimer m_clock;
+        QString m_lastCommand;
+        Protocol m_protocol;
+        int m_latency;
+        int m_jitter;
+        int m_noDataPercent;
+        int m_busErrorPercent;
+        int m_truncatePercent;
+        int m_requestCount;
+        bool m_echo;
+        bool m_headers;
+        bool m_spaces;
+        bool m_linefeeds;
+        bool m_canAutoFormat;
+        bool m_searching;
+    };
+}
+
+#endif // ELMEMULATOR_H
@@ -0,0 +1,20 @@
+# #####################################################################
+# ELM327 / ECU emulator. Automon connects to it with pty:// or tcp://
+# #####################################################################
+TEMPLATE = app
+INCLUDEPATH += .
+QT += core
+QT -= gui
+
+TARGET = elmemulator
+CONFIG += console
+CONFIG -= app_bundle
+
+# Input
+HEADERS += elmemulator.h \
+    emulatorserver.h \
+    virtualecu.h
+SOURCES += main.cpp \
+    elmemulator.cpp \
+    emulatorserver.cpp \
+    virtualecu.cpp
@@ -0,0 +1,264 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include <QDebug>
+#include <QThread>
+
+#include "emulatorserver.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace AutomonEmulator;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+EmulatorServer::EmulatorServer(ElmEmulator * emulator)
+{
+    /* Nothing is open until openPty() or listenTcp() is called */
+    m_emulator = emulator;
+    m_master = -1;
+    m_slave = -1;
+    m_listener = -1;
+    m_isTcp = false;
+}
+
+EmulatorServer::~EmulatorServer()
+{
+    /* Close whatever is open */
+    closeClient();
+
+    if (m_slave >= 0)
+        ::close(m_slave);
+
+    if (m_listener >= 0)
+        ::close(m_listener);
+}
+
+void EmulatorServer::stop()
+{
+    /* Make run() return. Safe to call from a signal handler */
+    stopRequested = 1;
+}
+
+bool EmulatorServer::openPty()
+{
+    /*
+        Create a pseudo terminal for Automon to open as if it was the serial port. The slave side is set to
+        raw mode and kept open ourselves, otherwise the master reads fail once the client closes it
+    */
+
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0)
+        return false;
+
+    m_address = QString::fromLocal8Bit(ptsname(m_master));
+    m_slave = ::open(ptsname(m_master), O_RDWR | O_NOCTTY);
+
+    if (m_slave < 0)
+        return false;
+
+    struct termios options;
+    tcgetattr(m_slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(m_slave, TCSANOW, &options);
+
+    fcntl(m_master, F_SETFL, O_NONBLOCK);
+
+    m_isTcp = false;
+    return true;
+}
+
+bool EmulatorServer::listenTcp(int port)
+{
+    /* Listen for a TCP client, the same way the WiFi ELM327 clones do */
+
+    m_listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (m_listener < 0)
+        return false;
+
+    int reuse = 1;
+    setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(m_listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(m_listener, 1) != 0)
+        return false;
+
+    m_address = QString("tcp://localhost:%1").arg(port);
+    m_isTcp = true;
+    return true;
+}
+
+QString EmulatorServer::getAddress() const
+{
+    /* Where Automon should connect to */
+    return m_isTcp ? m_address : "pty://" + m_address;
+}
+
+void EmulatorServer::closeClient()
+{
+    /* Hang up on the TCP client. The pty master is closed for good */
+    if (m_master >= 0)
+        ::close(m_master);
+
+    m_master = -1;
+    m_request.clear();
+}
+
+int EmulatorServer::run()
+{
+    /* Serve requests until stop() is called. Returns the exit code for main() */
+
+    char buffer[256];
+
+    while (!stopRequested)
+    {
+        struct pollfd watched;
+        watched.fd = m_master >= 0 ? m_master : m_listener;
+        watched.events = POLLIN;
+        watched.revents = 0;
+
+        if (watched.fd < 0)
+            return 1;
+
+        int ready = poll(&watched, 1, 500);
+
+        if (ready < 0 && errno != EINTR)
+            return 1;
+
+        if (ready <= 0)
+            continue;
+
+        if (m_master < 0)
+        {
+            /* A TCP client is connecting. Only one at a time, like the real adapter */
+            m_master = accept(m_listener, NULL, NULL);
+
+            if (m_master >= 0)
+            {
+                int noDelay = 1;
+                setsockopt(m_master, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                fcntl(m_master, F_SETFL, O_NONBLOCK);
+
+                qDebug("Client connected");
+            }
+
+            continue;
+        }
+
+        ssize_t bytes = ::read(m_master, buffer, sizeof(buffer));
+
+        if (bytes > 0)
+            handleInput(buffer, bytes);
+        else if (bytes == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            if (!m_isTcp)
+            {
+                /* Nobody has the pty open at the moment. Wait a bit rather than spin */
+                QThread::msleep(100);
+                continue;
+            }
+
+            qDebug("Client disconnected after %d requests", m_emulator->getRequestCount());
+            closeClient();
+        }
+    }
+
+    return 0;
+}
+
+void EmulatorServer::handleInput(const char * data, int size)
+{
+    /* Gather the request up to its carriage return, then answer it once the ECU latency has passed */
+
+    for (int i = 0; i < size; i++)
+    {
+        if (data[i] != '\x0D')
+        {
+            m_request += data[i];
+            continue;
+        }
+
+        int latency = 0;
+        QByteArray reply = m_emulator->process(m_request, latency);
+        m_request.clear();
+
+        if (latency > 0)
+            QThread::msleep(latency);
+
+        if (!writeAll(reply))
+            return;
+    }
+}
+
+bool EmulatorServer::writeAll(const QByteArray & data)
+{
+    /* Write the whole reply, waiting for room if the client is slow to read */
+
+    int written = 0;
+
+    while (written < data.size())
+    {
+        ssize_t result = ::write(m_master, data.constData() + written, data.size() - written);
+
+        if (result > 0)
+            written += result;
+        else if (result < 0 && errno != EAGAIN && errno != EINTR)
+            return false;
+        else
+        {
+            struct pollfd writable;
+            writable.fd = m_master;
+            writable.events = POLLOUT;
+            poll(&writable, 1, 100);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef EMULATORSERVER_H
+#define EMULATORSERVER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "elmemulator.h"
+
+namespace AutomonEmulator
+{
+    /*
+        The EmulatorServer puts an ElmEmulator on a pseudo terminal or a TCP port, so Automon can connect to it
+        with pty:///dev/pts/N or tcp://host:port. Like the real ELM327 it serves one client and one request
+        at a time. The ECU latency is slept before the answer is written.
+    */
+
+    class EmulatorServer
+    {
+    public:
+        EmulatorServer(ElmEmulator * emulator);
+        ~EmulatorServer();
+        bool openPty();
+        bool listenTcp(int port);
+        QString getAddress() const;
+        int run();
+        static void stop();
+
+    private:
+        void handleInput(const char * data, int size);
+        bool writeAll(const QByteArray & data);
+        void closeClient();
+
+        ElmEmulator * m_emulator;
+        QByteArray m_request;
+        QString m_address;
+        int m_master;  /* Pseudo terminal master, or the connected TCP client */
+        int m_slave;   /* Kept open so the pty survives the client closing it */
+        int m_listener;
+        bool m_isTcp;
+    };
+}
+
+#endif // EMULATORSERVER_H
@@ -0,0 +1,142 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+
+#include "elmemulator.h"
+#include "emulatorserver.h"
+
+#include <signal.h>
+#include <time.h>
+
+using namespace AutomonEmulator;
+
+static void handleSignal(int)
+{
+    /* Ctrl+C stops the server so the request count gets printed */
+    EmulatorServer::stop();
+}
+
+int main(int argc, char *argv[])
+{
+    /*
+        ELM327 emulator for testing and benchmarking Automon without a car. Examples:
+
+            elmemulator                                 Emulate on a pseudo terminal, prints the pty:// URI
+            elmemulator --tcp 35000 --protocol can      Emulate a CAN WiFi adapter on port 35000
+            elmemulator --latency 30 --pid-latency 0C=80 --ecus 2 --nodata 5
+    */
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("elmemulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Emulates an ELM327 and ECU on a pseudo terminal or TCP port");
+    parser.addHelpOption();
+
+    parser.addOption(QCommandLineOption("tcp", "Listen on a TCP port instead of a pseudo terminal.", "port"));
+    parser.addOption(QCommandLineOption("protocol", "Bus protocol, iso (ISO 9141-2) or can (CAN 11/500).", "name", "iso"));
+    parser.addOption(QCommandLineOption("ecus", "Number of ECUs answering on the bus.", "count", "1"));
+    parser.addOption(QCommandLineOption("latency", "ECU response time for OBD requests.", "ms", "0"));
+    parser.addOption(QCommandLineOption("pid-latency", "ECU response time of one mode 01 PID, eg: 0C=80. Can be repeated.", "pid=ms"));
+    parser.addOption(QCommandLineOption("jitter", "Random extra response time, up to this much.", "ms", "0"));
+    parser.addOption(QCommandLineOption("nodata", "Percentage of OBD requests answered with NO DATA.", "percent", "0"));
+    parser.addOption(QCommandLineOption("buserror", "Percentage of OBD requests answered with BUS ERROR.", "percent", "0"));
+    parser.addOption(QCommandLineOption("truncate", "Percentage of OBD responses with their last byte cut off.", "percent", "0"));
+    parser.addOption(QCommandLineOption("seed", "Random seed, to repeat a run with the same faults.", "number"));
+    parser.addOption(QCommandLineOption("no-codes", "Start with no trouble codes stored."));
+
+    parser.process(app);
+
+    ElmEmulator::Protocol protocol = ElmEmulator::Iso9141;
+
+    if (parser.value("protocol") == "can")
+        protocol = ElmEmulator::Can11Bit500;
+    else if (parser.value("protocol") != "iso")
+    {
+        qWarning() << "Unknown protocol" << parser.value("protocol");
+        return 1;
+    }
+
+    ElmEmulator emulator(protocol, parser.value("ecus").toInt());
+
+    emulator.setLatency(parser.value("latency").toInt());
+    emulator.setJitter(parser.value("jitter").toInt());
+    emulator.setFaultRates(parser.value("nodata").toInt(), parser.value("buserror").toInt(),
+                           parser.value("truncate").toInt());
+
+    QStringList pidLatencies = parser.values("pid-latency");
+
+    for (int i = 0; i < pidLatencies.size(); i++)
+    {
+        bool check;
+        int pid = pidLatencies[i].section('=', 0, 0).toInt(&check, 16);
+
+        if (!check || !pidLatencies[i].contains('='))
+        {
+            qWarning() << "Bad --pid-latency" << pidLatencies[i] << ", expected eg: 0C=80";
+            return 1;
+        }
+
+        emulator.setPidLatency(pid, pidLatencies[i].section('=', 1).toInt());
+    }
+
+    if (parser.isSet("no-codes"))
+        emulator.clearCodes();
+
+    qsrand(parser.isSet("seed") ? parser.value("seed").toUInt() : (uint)time(NULL));
+
+    EmulatorServer server(&emulator);
+
+    bool opened = parser.isSet("tcp") ? server.listenTcp(parser.value("tcp").toInt()) : server.openPty();
+
+    if (!opened)
+    {
+        qWarning("Could not open the emulator port");
+        return 1;
+    }
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    qDebug() << "ELM327 emulator ready on" << server.getAddress();
+
+    int result = server.run();
+
+    qDebug("Served %d requests", emulator.getRequestCount());
+
+    return result;
+}
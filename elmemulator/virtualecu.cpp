@@ -0,0 +1,233 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include <math.h>
+
+#include "virtualecu.h"
+
+using namespace AutomonEmulator;
+
+VirtualEcu::VirtualEcu(int index)
+{
+    /*
+        Set up the ECU. Index 0 is the engine ECU, the rest are secondary ECUs that answer a handful of PIDs.
+        The number of data bytes of each supported PID is what the SAE J1979 standard says
+    */
+
+    m_index = index;
+
+    m_dataBytes[0x01] = 4; /* Monitor status, MIL and number of codes */
+    m_dataBytes[0x05] = 1; /* Coolant temperature */
+    m_dataBytes[0x0C] = 2; /* Engine RPM */
+    m_dataBytes[0x0D] = 1; /* Vehicle speed */
+    m_dataBytes[0x1C] = 1; /* OBD standard */
+
+    if (index == 0)
+    {
+        m_dataBytes[0x04] = 1; /* Calculated engine load */
+        m_dataBytes[0x0A] = 1; /* Fuel pressure */
+        m_dataBytes[0x0F] = 1; /* Intake air temperature */
+        m_dataBytes[0x10] = 2; /* MAF air flow rate */
+        m_dataBytes[0x11] = 1; /* Throttle position */
+        m_dataBytes[0x14] = 2; /* O2 sensor bank 1 sensor 1 */
+        m_dataBytes[0x1F] = 2; /* Run time since engine start */
+        m_dataBytes[0x2C] = 1; /* Commanded EGR */
+        m_dataBytes[0x2F] = 1; /* Fuel level input */
+
+        /* The engine ECU starts off with two codes stored so the diagnostics screen has something to show */
+        m_codes << 0x0133 << 0x0420;
+
+        m_vin = "1G1JC5444R7252367";
+    }
+    else
+        m_codes << 0x0700; /* Transmission control system malfunction */
+}
+
+int VirtualEcu::getIndex() const
+{
+    return m_index;
+}
+
+int VirtualEcu::getIsoAddress() const
+{
+    /* The ISO 9141 / KWP source address. The engine is 0x10, others follow in steps of 8 */
+    return 0x10 + m_index * 8;
+}
+
+int VirtualEcu::getCanId() const
+{
+    /* The 11 bit CAN response ID. The engine answers on 7E8, the transmission on 7E9 and so on */
+    return 0x7E8 + m_index;
+}
+
+bool VirtualEcu::isSupported(int pid) const
+{
+    /* PID 00 is always there. 20 and 40 only if a PID in their range is, the rest as set up in the constructor */
+    if (pid == 0x00)
+        return true;
+
+    if (pid == 0x20 || pid == 0x40)
+        return !m_dataBytes.isEmpty() && m_dataBytes.lastKey() > pid;
+
+    return m_dataBytes.contains(pid);
+}
+
+bool VirtualEcu::answers(int mode, int pid) const
+{
+    /* True if this ECU responds to the request at all. Secondary ECUs have no VIN */
+    switch (mode)
+    {
+        case 0x01:
+            return isSupported(pid);
+        case 0x03:
+        case 0x04:
+            return true;
+        case 0x09:
+            return pid == 0x00 || (pid == 0x02 && !m_vin.isEmpty());
+        default:
+            return false;
+    }
+}
+
+QByteArray VirtualEcu::supportBitmap(int base) const
+{
+    /*
+        Build the four byte bitmap of the PIDs supported in base+1 to base+32. The last bit says the next
+        range is supported, which we set if any PID above this range is supported
+    */
+
+    QByteArray bitmap(4, '\0');
+
+    for (int pid = base + 1; pid <= base + 32; pid++)
+    {
+        bool supported = (pid == base + 32) ? !m_dataBytes.isEmpty() && m_dataBytes.lastKey() > base + 32
+                                            : m_dataBytes.contains(pid);
+
+        if (supported)
+            bitmap[(pid - base - 1) / 8] = bitmap[(pid - base - 1) / 8] | (0x80 >> ((pid - base - 1) % 8));
+    }
+
+    return bitmap;
+}
+
+QByteArray VirtualEcu::getPidData(int pid, qint64 elapsed) const
+{
+    /*
+        Return the data bytes for a mode 01 PID at the given time since the emulator started, in ms.
+        The values follow a slow drive cycle so gauges and rules have something to react to.
+        Returns an empty array for unsupported PIDs.
+    */
+
+    if (!isSupported(pid))
+        return QByteArray();
+
+    if (pid == 0x00 || pid == 0x20 || pid == 0x40)
+        return supportBitmap(pid);
+
+    double seconds = elapsed / 1000.0;
+    double cycle = (sin(seconds / 8.0) + 1.0) / 2.0; /* 0..1 over roughly 50 seconds */
+    quint32 value = 0;
+
+    switch (pid)
+    {
+        case 0x01:
+            value = (quint32)((m_codes.isEmpty() ? 0 : 0x80) | qMin(m_codes.size(), 0x7F)) << 24 | 0x076500;
+            break;
+        case 0x04:
+        case 0x11:
+            value = 20 + (int)(cycle * 180);
+            break;
+        case 0x05:
+            value = 40 + 40 + qMin((int)(seconds / 2), 50); /* Warms up from 40C to 90C, the offset is 40 */
+            break;
+        case 0x0A:
+            value = 100 + (int)(cycle * 50);
+            break;
+        case 0x0C:
+            value = (int)((800 + cycle * 4200) * 4); /* RPM * 4 */
+            break;
+        case 0x0D:
+            value = (int)(cycle * 130);
+            break;
+        case 0x0F:
+            value = 40 + 25;
+            break;
+        case 0x10:
+            value = (int)((2 + cycle * 60) * 100); /* g/s * 100 */
+            break;
+        case 0x14:
+            value = ((int)(200 * (0.1 + 0.8 * ((int)(seconds * 2) % 2))) << 8) | 0xFF; /* Toggles rich and lean */
+            break;
+        case 0x1C:
+            value = 6; /* EOBD */
+            break;
+        case 0x1F:
+            value = qMin((int)seconds, 0xFFFF);
+            break;
+        case 0x2C:
+            value = (int)(cycle * 255);
+            break;
+        case 0x2F:
+            value = 200 - qMin((int)(seconds / 60), 150);
+            break;
+    }
+
+    int count = m_dataBytes[pid];
+    QByteArray data(count, '\0');
+
+    for (int i = 0; i < count; i++)
+        data[i] = (char)((value >> (8 * (count - 1 - i))) & 0xFF);
+
+    return data;
+}
+
+QList<quint16> VirtualEcu::getCodes() const
+{
+    return m_codes;
+}
+
+void VirtualEcu::setCodes(const QList<quint16> & codes)
+{
+    m_codes = codes;
+}
+
+void VirtualEcu::clearCodes()
+{
+    /* Mode 04 clears the stored codes and turns off the MIL */
+    m_codes.clear();
+}
+
+QByteArray VirtualEcu::getVin() const
+{
+    return m_vin;
+}
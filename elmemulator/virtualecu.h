@@ -0,0 +1,76 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef VIRTUALECU_H
+#define VIRTUALECU_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+namespace AutomonEmulator
+{
+    /*
+        A VirtualEcu is one control unit on the emulated OBD bus. It knows which mode 01 PIDs it supports,
+        makes up plausible values for them that change over time, and keeps a list of stored trouble codes.
+        The engine ECU supports everything Automon reads. Extra ECUs, eg: a transmission ECU, only answer
+        a few PIDs so multi ECU responses can be tested.
+    */
+
+    class VirtualEcu
+    {
+    public:
+        VirtualEcu(int index);
+        int getIndex() const;
+        int getIsoAddress() const;
+        int getCanId() const;
+        bool isSupported(int pid) const;
+        bool answers(int mode, int pid) const;
+        QByteArray getPidData(int pid, qint64 elapsed) const;
+        QList<quint16> getCodes() const;
+        void setCodes(const QList<quint16> & codes);
+        void clearCodes();
+        QByteArray getVin() const;
+
+    private:
+        QByteArray supportBitmap(int base) const;
+
+        int m_index;
+        QMap<int, int> m_dataBytes; /* PID -> number of data bytes, only for supported PIDs */
+        QList<quint16> m_codes;
+        QByteArray m_vin;
+    };
+}
+
+#endif // VIRTUALECU_H
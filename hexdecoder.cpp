@@ -0,0 +1,209 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "hexdecoder.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+    Unlike the rest of the kernel this only includes its own header, so the benchmarks can build it without
+    the rest of Automon
+*/
+
+using namespace AutomonKernel;
+
+/* Value of each hex digit, -1 for anything else */
+static const signed char hexValues[256] =
+{
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,  0, 1, 2, 3, 4, 5, 6, 7, 8, 9,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+static inline unsigned int charCode(char c)
+{
+    return (unsigned char)c;
+}
+
+static inline unsigned int charCode(QChar c)
+{
+    return c.unicode();
+}
+
+HexDecoder::HexDecoder()
+    : m_size(0)
+{
+}
+
+HexDecoder::HexDecoder(const QString & response)
+    : m_size(0)
+{
+    decode(response);
+}
+
+bool HexDecoder::decode(const QString & response)
+{
+    /* Read the characters where the QString keeps them, no Latin-1 copy is made */
+    return decodeChars(response.constData(), response.size());
+}
+
+bool HexDecoder::decode(const char * response, int size)
+{
+    /* Decode the raw buffer as the serial helper read it */
+    return decodeChars(response, size);
+}
+
+int HexDecoder::size() const
+{
+    return m_size;
+}
+
+bool HexDecoder::isEmpty() const
+{
+    return m_size == 0;
+}
+
+int HexDecoder::at(int index) const
+{
+    /* Formulas index bytes they expect to be there. A short response reads as zeros instead of crashing */
+    return (index >= 0 && index < m_size) ? m_bytes[index] : 0;
+}
+
+int HexDecoder::operator[](int index) const
+{
+    return at(index);
+}
+
+const quint8 * HexDecoder::data() const
+{
+    return m_bytes;
+}
+
+QList<int> HexDecoder::toList() const
+{
+    /* For callers that want the bytes the way Automon::getBytes() always returned them */
+
+    QList<int> bytes;
+    bytes.reserve(m_size);
+
+    for (int i = 0; i < m_size; i++)
+        bytes.append(m_bytes[i]);
+
+    return bytes;
+}
+
+template <typename Char> bool HexDecoder::decodeChars(const Char * response, int size)
+{
+    /*
+        One pass over the response gathers the hex digits into a buffer on the stack, skipping spaces and line
+        breaks, and stops at the prompt. Then the digits are turned into bytes
+    */
+
+    char digits[MAXBYTES * 2];
+    int count = 0;
+    bool prompt = false;
+
+    m_size = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        unsigned int c = charCode(response[i]);
+
+        if (c == ' ' || c == '\x0D' || c == '\x0A')
+            continue;
+
+        if (c == '>')
+        {
+            prompt = true;
+            break;
+        }
+
+        if (c > 0xFF || hexValues[c] < 0 || count == (int)sizeof(digits))
+            return false;
+
+        digits[count++] = (char)c;
+    }
+
+    /* The response must be finished by the ELM327 and be whole bytes */
+    if (!prompt || (count % 2) != 0)
+        return false;
+
+    m_size = decodeDigits(digits, count, m_bytes);
+    return true;
+}
+
+int HexDecoder::decodeDigits(const char * digits, int count, quint8 * bytes)
+{
+    /* Turn pairs of hex digits into bytes. The digits are known to be valid */
+
+    int i = 0;
+
+#ifdef __SSE2__
+    /*
+        16 digits at a time: fold letters to lower case, turn every digit into its value, then put each pair
+        back together as one byte. Pairs are next to each other, so they are handled as 16 bit lanes
+    */
+    const __m128i lowerCase = _mm_set1_epi8(0x20);
+    const __m128i digitZero = _mm_set1_epi8('0');
+    const __m128i digitNine = _mm_set1_epi8('9');
+    const __m128i letterOffset = _mm_set1_epi8('a' - '0' - 10);
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i chars = _mm_or_si128(_mm_loadu_si128((const __m128i *)(digits + i)), lowerCase);
+        __m128i values = _mm_sub_epi8(chars, digitZero);
+        __m128i letters = _mm_cmpgt_epi8(chars, digitNine);
+
+        values = _mm_sub_epi8(values, _mm_and_si128(letters, letterOffset));
+
+        /* Each lane is high digit | low digit << 8. The byte is high << 4 | low */
+        __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, lowByte), 4), _mm_srli_epi16(values, 8));
+
+        _mm_storel_epi64((__m128i *)(bytes + i / 2), _mm_packus_epi16(pairs, _mm_setzero_si128()));
+    }
+#endif
+
+    for (; i < count; i += 2)
+        bytes[i / 2] = (quint8)((hexValues[(unsigned char)digits[i]] << 4) | hexValues[(unsigned char)digits[i + 1]]);
+
+    return count / 2;
+}
@@ -0,0 +1,79 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef HEXDECODER_H
+#define HEXDECODER_H
+
+#include <QString>
+#include <QList>
+
+namespace AutomonKernel
+{
+    /*
+        The HexDecoder turns an ELM327 response, eg: "41 0C 1A F8\r\r>", into bytes. It is used for every sample
+        a sensor converts, so it doesn't allocate: the response is read straight out of the QString, spaces and
+        line breaks are skipped, and the bytes go into a fixed array inside the decoder, which lives on the
+        stack. Long responses, like multi line mode 09 and DTC answers, are decoded 16 hex digits at a time
+        with SSE2 where the compiler has it.
+
+        Like Automon::getBytes(), a response has to end with the prompt and have an even number of hex digits,
+        otherwise no bytes are decoded. Indexing past the end gives 0.
+    */
+
+    class HexDecoder
+    {
+    public:
+        enum { MAXBYTES = 512 }; /* More than any response that fits the serial helper's read buffer */
+
+        HexDecoder();
+        HexDecoder(const QString & response);
+        bool decode(const QString & response);
+        bool decode(const char * response, int size);
+        int size() const;
+        bool isEmpty() const;
+        int at(int index) const;
+        int operator[](int index) const;
+        const quint8 * data() const;
+        QList<int> toList() const;
+
+    private:
+        template <typename Char> bool decodeChars(const Char * response, int size);
+        static int decodeDigits(const char * digits, int count, quint8 * bytes);
+
+        quint8 m_bytes[MAXBYTES];
+        int m_size;
+    };
+}
+
+#endif // HEXDECODER_H
@@ -0,0 +1,134 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+/* Upper bound in ms of each bucket */
+static const int bucketBounds[LatencyHistogram::BUCKETS] =
+{
+    2, 4, 6, 8, 10, 12, 16, 20, 25, 32, 40, 50, 64, 80,
+    100, 128, 160, 200, 256, 320, 400, 512, 640, 800, 1024, 1600, 2500, 5000
+};
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::clear()
+{
+    /* Forget every sample */
+    for (int i = 0; i <= BUCKETS; i++)
+        m_counts[i] = 0;
+
+    m_total = 0;
+}
+
+void LatencyHistogram::record(int milliseconds)
+{
+    /* Count an answered request in the first bucket it fits in. Anything slower than the last bound goes in it too */
+
+    int bucket = 0;
+
+    while (bucket < BUCKETS - 1 && milliseconds > bucketBounds[bucket])
+        bucket++;
+
+    m_counts[bucket]++;
+    m_total++;
+
+    age();
+}
+
+void LatencyHistogram::recordMiss()
+{
+    /* Count a request that got no answer in time */
+    m_counts[BUCKETS]++;
+    m_total++;
+
+    age();
+}
+
+void LatencyHistogram::age()
+{
+    /* Halve every count when the histogram is full, so it follows an ECU that changes speed */
+
+    if (m_total < MAXSAMPLES)
+        return;
+
+    m_total = 0;
+
+    for (int i = 0; i <= BUCKETS; i++)
+    {
+        m_counts[i] /= 2;
+        m_total += m_counts[i];
+    }
+}
+
+int LatencyHistogram::percentile(double fraction) const
+{
+    /*
+        Return the latency in ms that the given fraction of requests were answered within, eg: 0.99.
+        This is the upper bound of the bucket, so it errs on the slow side. Returns -1 if the fraction
+        reaches into the misses, or if there are no samples at all
+    */
+
+    if (m_total == 0)
+        return -1;
+
+    int wanted = (int)(fraction * m_total + 0.999);
+    int seen = 0;
+
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        seen += m_counts[i];
+
+        if (seen >= wanted)
+            return bucketBounds[i];
+    }
+
+    return -1;
+}
+
+int LatencyHistogram::getCount() const
+{
+    /* The number of samples, misses included */
+    return m_total;
+}
+
+int LatencyHistogram::getMisses() const
+{
+    /* The number of requests that were not answered in time */
+    return m_counts[BUCKETS];
+}
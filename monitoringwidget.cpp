@@ -41,7 +41,6 @@
 #include <QRgb>
 
 #include "monitoringwidget.h"
-#include "rule.h"
 #include "automonapp.h"
 
 MonitoringWidget::MonitoringWidget(Automon * kernel, QWidget * parent)
@@ -66,6 +65,9 @@ MonitoringWidget::MonitoringWidget(Automon * kernel, QWidget * parent)
     /* This variable is used by this widget to determine if we've started monitoring */
     m_isMonitoring = false;
 
+    /* The kernel's rule engine tells us when one of our rules is satisfied */
+    m_kernel->connectRulesToSlot(this);
+
     /* Create our tables. The sensor table list and the rules list */
 
     m_sensorsList = new QTableWidget();
@@ -199,22 +201,23 @@ void MonitoringWidget::populateRulesAvailableList()
     m_availableRulesList->clear();
 
     /* Get available rules from the kernel */
-    QStringList rulesAvailable = m_kernel->getRuleList();
+    const RuleCatalogue & catalogue = m_kernel->getRuleCatalogue();
+    QList<int> rulesAvailable = catalogue.getIds();
 
     if (rulesAvailable.size() == 0)
     {
-        /* If no rules available, add this to the rules List */
+        /* If no rules available, add this to the rules List. 0 is never the id of a rule */
         m_availableRulesList->addItem(tr("No Rules Available!"), 0);
         return;
     }
 
     /*
-        Otherwise, for each rule, add it to the combo box, making the human readable version for the text, and the normal
-        representation for the value
+        Otherwise, for each rule, add it to the combo box, making the human readable version for the text, and the rule's
+        id for the value
     */
 
     for (int i = 0; i < rulesAvailable.size(); i++)
-        m_availableRulesList->addItem(m_kernel->convertRuleToEnglish(rulesAvailable.at(i)), rulesAvailable.at(i));
+        m_availableRulesList->addItem(catalogue.getEnglishName(rulesAvailable.at(i)), rulesAvailable.at(i));
 }
 
 void MonitoringWidget::addRule()
@@ -224,14 +227,21 @@ void MonitoringWidget::addRule()
     /* The rule's table will only ever have a single column, the rule in human readable format */
     m_addedRulesList->setColumnCount(1);
 
-    /* Get the rule to add */
-    QString ruleToAdd = m_availableRulesList->itemData(m_availableRulesList->currentIndex()).toString();
+    /* Get the id of the rule to add */
+    int ruleToAdd = m_availableRulesList->itemData(m_availableRulesList->currentIndex()).toInt();
+
+    if (!m_kernel->getRuleCatalogue().contains(ruleToAdd))
+    {
+        /* Nothing to add, ie: there are no rules */
+        emit changeStatus(tr("No Rule Selected!"));
+        return;
+    }
 
-    /* Convert to human readable text */
+    /* The human readable text */
     QString ruleEnglishMeaning = m_availableRulesList->itemText(m_availableRulesList->currentIndex());
 
     for (int i = 0; i < m_addedRulesList->rowCount(); i++)
-        if (m_addedRulesList->item(i,0)->data(Qt::DisplayRole).toString().compare(ruleEnglishMeaning) == 0)
+        if (m_addedRulesList->item(i,0)->data(Qt::UserRole).toInt() == ruleToAdd)
         {
             /* Rule is already added so exit */
             emit changeStatus("Rule already added!");
@@ -241,8 +251,9 @@ void MonitoringWidget::addRule()
     /* Update row count of rule table to add in another rule */
     m_addedRulesList->setRowCount(m_addedRulesList->rowCount()+1);
 
-    /* Create the cell item */
+    /* Create the cell item. It keeps the rule's id to find the rule again */
     QTableWidgetItem * columnItem = new QTableWidgetItem(ruleEnglishMeaning);
+    columnItem->setData(Qt::UserRole, ruleToAdd);
 
     /* Disable it from being editable by setting these flags */
     columnItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
@@ -303,7 +314,7 @@ void MonitoringWidget::addSensor()
     /* Check is used for conversion of QString to int */
     bool check;
 
-    /* Convert the QVariant data to integer */
+    /* Convert the QVariant data to integer. 0 means as fast as possible */
     int frequency = m_frequencyUpdateList->itemData(m_frequencyUpdateList->currentIndex()).toInt(&check);
 
     /* Get the current number of rows */
@@ -329,8 +340,9 @@ void MonitoringWidget::addSensor()
     column1Item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
     QTableWidgetItem * column2Item = new QTableWidgetItem(code);
     column2Item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-    QTableWidgetItem * column3Item = new QTableWidgetItem(QString(QString::number(frequency)+"Hz"));
+    QTableWidgetItem * column3Item = new QTableWidgetItem(frequency ? QString(QString::number(frequency)+"Hz") : tr("Max"));
     column3Item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+    column3Item->setData(Qt::UserRole, frequency); /* Keep the requested rate, the text shows the achieved rate later */
     QTableWidgetItem * column4Item = new QTableWidgetItem("0");
     column4Item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
 
@@ -368,6 +380,16 @@ void MonitoringWidget::addSensor()
     /* Reset frequency combo box to first element (1Hz) for convienence */
     m_frequencyUpdateList->setCurrentIndex(0);
 
+    if (m_isMonitoring)
+    {
+        /* Monitoring is running. The serial thread picks the new sensor up from its next round, no restart needed */
+        if (!m_kernel->subscribe(this, code, frequency))
+        {
+            emit changeStatus(tr("Sensor : ")+code+tr(" could not be added!"));
+            return;
+        }
+    }
+
     emit changeStatus(tr("Sensor added to monitoring list!"));
 }
 
@@ -388,6 +410,26 @@ void MonitoringWidget::removeSensor()
         return;
     }
 
+    if (m_isMonitoring)
+    {
+        /* Monitoring is running, so take the sensor out of the serial thread straight away */
+        QString sensorCode = m_sensorsList->item(currentRowSelected,1)->data(Qt::DisplayRole).toString();
+
+        /* A running rule still reads this sensor. Don't pull it from under the rule */
+        for (int i = 0; i < m_rules.size(); i++)
+        {
+            QString rule = m_kernel->getActiveRule(m_rules.at(i));
+
+            if (m_kernel->extractSensorsFromRule(rule).contains(sensorCode))
+            {
+                emit changeStatus(tr("Sensor is used by a running rule. Stop monitoring first"));
+                return;
+            }
+        }
+
+        m_kernel->unsubscribe(this, sensorCode);
+    }
+
     /* Otherwise, they have so remove the selected row */
     m_sensorsList->removeRow(currentRowSelected);
 
@@ -420,11 +462,15 @@ void MonitoringWidget::populateSensorCombo()
 void MonitoringWidget::populateFrequencyUpdateList()
 {
     /*
-        This method simply populates the Frequency combo with frequency ranges, 1Hz to 30Hz
+        This method simply populates the Frequency combo with frequency ranges, 1Hz to 30Hz.
+        These are real rates, the serial thread schedules each sensor by deadline to meet them.
+        The last entry reads the sensor as often as the bus allows.
     */
 
     for (int i = 1; i <= 30; i++)
-        m_frequencyUpdateList->addItem(QString(QString::number(i)+"Hz (Every "+QString::number(i)+" cycles)"),i);
+        m_frequencyUpdateList->addItem(QString(QString::number(i)+"Hz"),i);
+
+    m_frequencyUpdateList->addItem(tr("As fast as possible"), 0);
 }
 
 void MonitoringWidget::display(double sensorVal)
@@ -443,7 +489,22 @@ void MonitoringWidget::display(double sensorVal)
     /* Go through each row and find the row that matches this sensor */
     for (int i = 0; i < m_sensorsList->rowCount(); i++)
         if (m_sensorsList->item(i,1)->data(Qt::DisplayRole).toString().compare(sensorCode) == 0) /* We have the pid/code match */
+        {
             m_sensorsList->item(i,3)->setData(Qt::DisplayRole, QString::number(sensorVal)); /* Update the value cell with new value */
+
+            /*
+                Show the achieved rate beside the requested one so the user can see if the bus is keeping up.
+                If the scheduler had to lower the rate, the rate it gives the sensor is shown too
+            */
+            int frequency = m_sensorsList->item(i,2)->data(Qt::UserRole).toInt();
+            double allocated = m_kernel->getAllocatedRate(sensorCode);
+            QString requested = frequency ? QString(QString::number(frequency)+"Hz") : tr("Max");
+
+            if (allocated > 0 && (frequency == 0 || allocated < frequency))
+                requested += tr(", given ") + QString::number(allocated, 'f', 1) + "Hz";
+
+            m_sensorsList->item(i,2)->setData(Qt::DisplayRole, requested + " (" + QString::number(caller->getAvgRefreshRate(), 'f', 1) + "Hz)");
+        }
 }
 
 void MonitoringWidget::startMonitoring()
@@ -455,17 +516,9 @@ void MonitoringWidget::startMonitoring()
     */
 
 
-    if (!m_isMonitoring && m_kernel->isMonitoring())
-    {
-        /* Automon is currently working on some other task so let user know and return */
-        emit changeStatus(tr("Automon is currently busy with another task. Stop this first"));
-        return;
-    }
-
-    /* Clear all active sensors from Serial I/O thread */
-    m_kernel->removeAllActiveSensors();
+    /* Other widgets may be polling at the same time. Sensors we share with them are only requested once */
 
-    if (m_sensorsList->rowCount() == 0)
+    if (!m_isMonitoring && m_sensorsList->rowCount() == 0)
     {
         /* No sensors are added to the sensor table. Let user know and return */
         emit changeStatus(tr("No Sensors to Monitor!"));
@@ -490,22 +543,23 @@ void MonitoringWidget::startMonitoring()
             /* For each sensor in the table, get its sensor code */
             QString sensorCode = m_sensorsList->item(i,1)->data(Qt::DisplayRole).toString();
 
-            /* Disconnect the sensor's changeValue signal from our custom slot in this widget */
-            disconnect(m_kernel->getActiveSensorByCommand(sensorCode), SIGNAL(changeOccurred(double)), this, SLOT(display(double)));
+            /* Reset the sensor, such as sensor change times etc. State has to be reversed */
+            if (m_kernel->getSensorByCommand(sensorCode))
+                m_kernel->getSensorByCommand(sensorCode)->resetSensor();
+        }
 
-            /* Get a pointer to the current sensor */
-            Sensor * thisSensor = m_kernel->getActiveSensorByCommand(sensorCode);
+        /* Stop our rules */
+        for (int i = 0; i < m_rules.size(); i++)
+            m_kernel->deactivateRule(m_rules.at(i));
 
-            /* Remove the sensor from the active list in the serial thread */
-            if (!m_kernel->removeActiveSensorByCommand(sensorCode))
-                emit changeStatus(tr("Sensor : ")+sensorCode+tr(" could not be removed!"));
+        m_rules.clear();
 
-            /* Reset the sensor, such as sensor change times etc. State has to be reversed */
-            thisSensor->resetSensor();
-        }
+        /* Unsubscribe from all our sensors. The serial thread stops polling them unless another widget uses them */
+        m_kernel->unsubscribeAll(this);
 
-        /* Stop the serial thread */
-        m_kernel->stopMonitoring();
+        /* Write out the values recorded while monitoring, rules can be backtested on them in the rule editor */
+        if (!m_kernel->setSessionFile(""))
+            emit changeStatus(tr("Recorded session could not be saved!"));
 
         /* Change text on push button to more appropiate text */
         m_startStopMonitoring->setText(tr("Start Monitoring"));
@@ -544,33 +598,22 @@ void MonitoringWidget::startMonitoring()
         /* Bool is used for QString->Interger conversion */
         bool check;
 
-        /* Get the frequency from the table */
-        QString frequencyStr = m_sensorsList->item(i,2)->data(Qt::DisplayRole).toString();
-
-        /* Convert to integer frequency */
-        int frequency = frequencyStr.section("", 0,frequencyStr.indexOf("Hz")).toInt(&check);
-
-        /* Add the sensor to the serial thread */
-        if (m_kernel->addActiveSensor(m_kernel->getSensorByCommand(sensorCode)))
-        {
-            /* Sensor added successfully, now update it's refresh frequency to the user defined one in table */
-            m_kernel->setSensorFrequency(m_kernel->getSensorByCommand(sensorCode), frequency);
+        /* Get the requested frequency from the table */
+        int frequency = m_sensorsList->item(i,2)->data(Qt::UserRole).toInt(&check);
 
-            /* Connect the sensor's signal to our slot */
-            connect(m_kernel->getActiveSensorByCommand(sensorCode), SIGNAL(changeOccurred(double)), this, SLOT(display(double)));
-        }
-        else
+        /*
+            Subscribe our display slot to the sensor at the user defined frequency in the table. This starts polling it.
+            Sensors higher up the table keep their frequency first if the bus can't keep up
+        */
+        if (!m_kernel->subscribe(this, sensorCode, frequency, m_sensorsList->rowCount() - i))
             emit changeStatus(tr("Sensor : ")+sensorCode+tr(" could not be added!"));
     }
 
     /* Now it is time to create the rules */
 
-    /* Clear old rules and delete them */
+    /* Clear old rules, the kernel stops evaluating them */
     for (int i = 0; i < m_rules.size(); i++)
-    {
-        disconnect(m_rules.at(i), SIGNAL(sendAlert(QString)), this, SLOT(ruleHandler(QString)));
-        delete(m_rules.at(i));
-    }
+        m_kernel->deactivateRule(m_rules.at(i));
 
     /* Clear rules list */
     m_rules.clear();
@@ -578,130 +621,96 @@ void MonitoringWidget::startMonitoring()
 
     for (int i = 0; i < m_addedRulesList->rowCount(); i++)
     {
-        /* For each rule in the table list */
-
-        /* Get the rule from the table, it is in human readable format */
-        QString currentRuleEnglishName = m_addedRulesList->item(i,0)->data(Qt::DisplayRole).toString();
-
-        for (int j = 0; j < m_availableRulesList->count(); j++)
-        {
-            /* For each rule in the available rules list ... */
-
-            /* Convert it to human readable format and compare to the one in the table */
-            if (m_kernel->convertRuleToEnglish(m_availableRulesList->itemData(j).toString()).compare(currentRuleEnglishName) == 0)
-            {
-
-                /* Found the rule we working on. Get the real rule string, not human readable one */
-                QString nonEnglishRule = m_availableRulesList->itemData(j).toString();
-
-                /* Now we also must verify that all sensors present in the kernel active sensoring*/
-                QStringList sensorsInRule = m_kernel->extractSensorsFromRule(nonEnglishRule);
-
-
-                bool ruleCanBeAdded = true;
-
-                for (int k = 0; k < sensorsInRule.size(); k++)
-                    /* Now for each sensor in the rule, check if it is in the active sensors */
-                    if (m_kernel->getActiveSensorByCommand(sensorsInRule.at(k)) == NULL)
-                        ruleCanBeAdded = false;
-
-                if (ruleCanBeAdded)
-                {
-                    /* The rulecanbeadded variable didn't change to false so all sensors are in the serial thread */
-
-                    /* Safe to create rule now */
-                    Rule * thisRule = new Rule();
-
-                    /* Set the rule to the real rule string */
-                    thisRule->setRule(nonEnglishRule);
-
-                    /* Add the rule to the list of rules */
-                    m_rules.append(thisRule);
-
-
-                    /* Connect rule to our slot */
-                    connect(thisRule, SIGNAL(sendAlert(QString)), this, SLOT(ruleHandler(QString)));
+        /* For each rule in the table list, get its id. The catalogue has the rule parsed */
+        int ruleId = m_addedRulesList->item(i,0)->data(Qt::UserRole).toInt();
 
-                    for (int v=0; v<sensorsInRule.size(); v++)
-                    {
-                        /* For each sensor in the rule string, check to ensure it not empty */
-                        if (sensorsInRule.at(v).compare("") != 0)
-                            /* If not empty, then add a pointer to the sensor to the rule */
-                            thisRule->addSensor(m_kernel->getActiveSensorByCommand(sensorsInRule.at(v)));
-                    }
+        /* Now we also must verify that all sensors present in the kernel active sensoring*/
+        QStringList sensorsInRule = m_kernel->getRuleCatalogue().getSensors(ruleId);
 
-                    /* Set the rule name to the english name */
-                    thisRule->setRuleName(currentRuleEnglishName);
+        bool ruleCanBeAdded = true;
 
-                    /* Activate the rule */
-                    if (!thisRule->activate())
-                    {
-                        /* Rule could not be actived. Highlight the rule in red and reverse actions from before */
-                        m_addedRulesList->item(i,0)->setForeground(QBrush(Qt::red));
-                        emit changeStatus(tr("The selected rule had an error of some kind"));
+        for (int k = 0; k < sensorsInRule.size(); k++)
+            /* Now for each sensor in the rule, check if we subscribed to it */
+            if (!m_kernel->isSubscribed(this, sensorsInRule.at(k)))
+                ruleCanBeAdded = false;
 
-                        /* Remove all the sensors */
-                        m_kernel->removeAllActiveSensors();
+        if (ruleCanBeAdded)
+        {
+            /* The rulecanbeadded variable didn't change to false so all sensors are in the serial thread */
 
-                        /* Re enable all buttons */
-                        m_startStopMonitoring->setEnabled(true);
-                        m_addSensorButton->setEnabled(true);
-                        m_removeSensorButton->setEnabled(true);
-                        m_addRuleButton->setEnabled(true);
-                        m_removeRuleButton->setEnabled(true);
-                        m_ruleEditorButton->setEnabled(true);
+            /* Safe to activate the rule now. The kernel's rule engine evaluates it, named by the english name */
+            int activeId = m_kernel->activateRule(ruleId);
 
-                        return;
-                    }
+            if (activeId == -1)
+            {
+                /* Rule could not be actived. Highlight the rule in red and reverse actions from before */
+                m_addedRulesList->item(i,0)->setForeground(QBrush(Qt::red));
+                emit changeStatus(tr("The selected rule had an error of some kind"));
+
+                /* Stop the rules activated so far and unsubscribe from all the sensors */
+                for (int r = 0; r < m_rules.size(); r++)
+                    m_kernel->deactivateRule(m_rules.at(r));
+
+                m_rules.clear();
+                m_kernel->unsubscribeAll(this);
+
+                /* Re enable all buttons */
+                m_startStopMonitoring->setEnabled(true);
+                m_addSensorButton->setEnabled(true);
+                m_removeSensorButton->setEnabled(true);
+                m_addRuleButton->setEnabled(true);
+                m_removeRuleButton->setEnabled(true);
+                m_ruleEditorButton->setEnabled(true);
+
+                return;
+            }
 
-                    /* If we get here, the rule successfully added */
-                    emit changeStatus(tr("Rule Added!"));
-                }
-                else
-                {
-                    /* If in here, the current rule has sensors that are not present in the serial thread.
-                       IE: We forgot to add a sensor needed by this rule
-                    */
+            /* If we get here, the rule successfully added */
+            m_rules.append(activeId);
+            emit changeStatus(tr("Rule Added!"));
+        }
+        else
+        {
+            /* If in here, the current rule has sensors that are not present in the serial thread.
+               IE: We forgot to add a sensor needed by this rule
+            */
 
-                    /* Set the rule color to red to highlight which rule caused the error */
-                    m_addedRulesList->item(i,0)->setForeground(QBrush(Qt::red));
-                    emit changeStatus(tr("Rule could not be added. Sensor not in list!"));
+            /* Set the rule color to red to highlight which rule caused the error */
+            m_addedRulesList->item(i,0)->setForeground(QBrush(Qt::red));
+            emit changeStatus(tr("Rule could not be added. Sensor not in list!"));
 
-                    /* Reverse all actions before, by removing the few sensors added to the serial thread */
-                    m_kernel->removeAllActiveSensors();
+            /* Reverse all actions before, by stopping the rules activated so far and unsubscribing from the few sensors subscribed to */
+            for (int r = 0; r < m_rules.size(); r++)
+                m_kernel->deactivateRule(m_rules.at(r));
 
-                    /* Re enable all buttons */
-                    m_startStopMonitoring->setEnabled(true);
-                    m_addSensorButton->setEnabled(true);
-                    m_removeSensorButton->setEnabled(true);
-                    m_addRuleButton->setEnabled(true);
-                    m_removeRuleButton->setEnabled(true);
-                    m_ruleEditorButton->setEnabled(true);
+            m_rules.clear();
+            m_kernel->unsubscribeAll(this);
 
-                    return;
-                }
-            }
+            /* Re enable all buttons */
+            m_startStopMonitoring->setEnabled(true);
+            m_addSensorButton->setEnabled(true);
+            m_removeSensorButton->setEnabled(true);
+            m_addRuleButton->setEnabled(true);
+            m_removeRuleButton->setEnabled(true);
+            m_ruleEditorButton->setEnabled(true);
 
+            return;
         }
     }
 
-    /* Now that sensors added, time to start monitoring! */
+    /* Now that sensors are subscribed, the serial thread is already polling them */
 
-    /* Attempt to start monitoring, ie: start the serial I/O thread */
-    if (!m_kernel->startMonitoring())
-    {
-        /* We should not get in here. */
-        emit changeStatus(tr("Failed to start serial thread. This is an exception! Restart the device."));
-        m_startStopMonitoring->setEnabled(true);
-        return;
-    }
+    /* Record the sensor values while monitoring */
+    m_kernel->setSessionFile(SESSIONFILE);
 
     /* Update the text on the start/stop monitoring button to stop now */
     m_startStopMonitoring->setText(tr("Stop Monitoring"));
     emit changeStatus(tr("Monitoring Started!"));
 
-    /* Only re enable the start/stop monitoring button so user can stop the monitoring */
+    /* Re enable the start/stop monitoring button so user can stop the monitoring. Sensors can be added and removed live */
     m_startStopMonitoring->setEnabled(true);
+    m_addSensorButton->setEnabled(true);
+    m_removeSensorButton->setEnabled(true);
 
     /* Update this variable so we know next time we click, we are stopping the monitoring */
     m_isMonitoring = true;
@@ -751,25 +760,19 @@ void MonitoringWidget::refreshRules()
     /* Update the combo box */
     populateRulesAvailableList();
 
-    /* Now in the table, clear any rules not in the combo */
-    for (int i = 0; i < m_addedRulesList->rowCount(); i++)
-    {
-        bool found = false;
+    /* Now in the table, clear any rules no longer in the catalogue. Rules keep their id, so the others stay. Go backwards as rows go */
+    const RuleCatalogue & catalogue = m_kernel->getRuleCatalogue();
 
-        for (int j =0; j < m_availableRulesList->count(); j++)
-        {
-            if (m_addedRulesList->item(i,0)->data(Qt::DisplayRole).toString().compare(m_availableRulesList->itemText(j)) == 0)
-            {
-                /* We found a rule in the table that is no longer in the available rules list */
-                found = true;
-                break;
-            }
-        }
+    for (int i = m_addedRulesList->rowCount() - 1; i >= 0; i--)
+    {
+        int ruleId = m_addedRulesList->item(i,0)->data(Qt::UserRole).toInt();
 
-        if (!found)
+        if (!catalogue.contains(ruleId))
         {
             /* So the rule we had before, that is now gone has being removed. So remove from list */
             m_addedRulesList->removeRow(i);
         }
+        else
+            m_addedRulesList->item(i,0)->setText(catalogue.getEnglishName(ruleId));
     }
 }
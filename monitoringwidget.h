@@ -103,7 +103,7 @@ private:
     QPushButton * m_startStopMonitoring;
     QComboBox * m_sensorComboList;
     QComboBox * m_frequencyUpdateList;
-    QList<Rule*> m_rules;
+    QList<int> m_rules; /* Ids of the rules we activated in the kernel */
     Automon * m_kernel;
     bool m_isMonitoring;
 };
@@ -0,0 +1,278 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+PidBatcher::PidBatcher()
+{
+    /* Batching is on until the ECU shows us it doesn't understand multi PID requests */
+    m_enabled.store(true);
+    m_rejections = 0;
+}
+
+void PidBatcher::setEnabled(bool enabled)
+{
+    /* Turn batching on or off. Turning it on gives the ECU a fresh chance */
+    m_enabled.store(enabled);
+    m_rejections = 0;
+}
+
+bool PidBatcher::isEnabled() const
+{
+    return m_enabled.load();
+}
+
+bool PidBatcher::canBatch(Sensor * sensor)
+{
+    /*
+        Only mode 01 sensors can go into a multi PID request, and we have to know how many data bytes
+        the PID returns to be able to split the combined response
+    */
+
+    QString command = sensor->getCommand();
+
+    return command.size() == 4 && command.startsWith("01") && sensor->getExpectedBytes() > 0;
+}
+
+QString PidBatcher::buildRequest(const QList<Sensor*> & sensors)
+{
+    /* Create the request, eg: "01 0C 0D 05" for Engine RPM, Vehicle Speed and Coolant Temperature */
+
+    QString request("01");
+
+    for (int i = 0; i < sensors.size() && i < MAXPIDS; i++)
+        request += " " + sensors.at(i)->getCommand().mid(2, 2);
+
+    return request + "\x0D";
+}
+
+int PidBatcher::hexValue(char c)
+{
+    /* Convert a single ASCII hex digit to its value, -1 if it isn't hex */
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+
+    return -1;
+}
+
+bool PidBatcher::dispatchResponse(QList<Sensor*> & sensors, const char * response, int size)
+{
+    /*
+        This method splits a multi PID response back into each sensor. A CAN response to "01 0C 0D 05" looks like:
+
+        00A
+        0: 41 0C 1A F8 0D 00
+        1: 05 7B 00 00 00 00 00
+
+        The first line is the byte count and each following line is prefixed with its frame number. A short
+        response comes back on a single line without these. The sensors that were answered are removed from
+        the list, so whatever is left in it has to be requested on its own by the caller.
+        Returns false if the ECU rejected the request.
+    */
+
+    quint8 bytes[256];
+    int count = 0;
+    int messageRemaining = -1; /* Bytes still to come in the current multi frame message, -1 if not in one */
+    int lineStart = 0;
+
+    while (lineStart < size)
+    {
+        /* Find the end of the current line */
+        int lineEnd = lineStart;
+        while (lineEnd < size && response[lineEnd] != '\x0D' && response[lineEnd] != '\n' && response[lineEnd] != '>')
+            lineEnd++;
+
+        int pos = lineStart;
+
+        /* Skip the frame number, eg: "0:" */
+        for (int i = lineStart; i < lineEnd; i++)
+            if (response[i] == ':')
+                pos = i + 1;
+
+        /* Count hex digits and check the line is all hex */
+        int digits = 0;
+        bool isHex = true;
+
+        for (int i = pos; i < lineEnd; i++)
+        {
+            if (response[i] == ' ')
+                continue;
+
+            if (hexValue(response[i]) < 0)
+                isHex = false;
+            else
+                digits++;
+        }
+
+        if (!isHex)
+        {
+            /* The ELM327 prints SEARCHING... before the first response on a new bus. Everything else is an error */
+            if (lineEnd - lineStart >= 9 && strncmp(response + lineStart, "SEARCHING", 9) == 0)
+            {
+                lineStart = lineEnd + 1;
+                continue;
+            }
+
+            count = 0;
+            break;
+        }
+
+        if (digits > 0)
+        {
+            if (digits == 3 && pos == lineStart)
+            {
+                /* This is the byte count line of a multi frame response. Anything past the count is padding */
+                messageRemaining = 0;
+
+                for (int i = pos; i < lineEnd; i++)
+                    if (response[i] != ' ')
+                        messageRemaining = (messageRemaining << 4) | hexValue(response[i]);
+            }
+            else if ((digits % 2) != 0)
+            {
+                /* Uneven number of hex digits, this response is broken */
+                count = 0;
+                break;
+            }
+            else
+            {
+                /* Gather the bytes on this line. A line without a frame number isn't part of a multi frame message */
+                int high = -1;
+
+                if (pos == lineStart)
+                    messageRemaining = -1;
+
+                for (int i = pos; i < lineEnd && count < (int)sizeof(bytes) && messageRemaining != 0; i++)
+                {
+                    if (response[i] == ' ')
+                        continue;
+
+                    if (high < 0)
+                        high = hexValue(response[i]);
+                    else
+                    {
+                        bytes[count++] = (high << 4) | hexValue(response[i]);
+                        high = -1;
+
+                        if (messageRemaining > 0)
+                            messageRemaining--;
+                    }
+                }
+            }
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    /* Now walk the bytes. Each message starts with 0x41 followed by PID, data bytes, PID, data bytes ... */
+    int answered = 0;
+    int requested = sensors.size();
+    bool inMessage = false;
+    int i = 0;
+
+    while (i < count)
+    {
+        int pid = bytes[i];
+        int index = -1;
+
+        if (inMessage)
+        {
+            for (int j = 0; j < sensors.size(); j++)
+                if (sensors.at(j)->getCommand().mid(2, 2).toInt(0, 16) == pid)
+                    index = j;
+        }
+
+        if (index < 0)
+        {
+            /* A 0x41 that isn't one of our PIDs is the start of a message, from this or another ECU */
+            if (pid != 0x41)
+                break;
+
+            inMessage = true;
+            i++;
+            continue;
+        }
+
+        Sensor * sensor = sensors.at(index);
+        int dataBytes = sensor->getExpectedBytes();
+
+        if (i + 1 + dataBytes > count)
+            break; /* Truncated response */
+
+        /* Rebuild the response the sensor would have got if requested on its own */
+        QString single("41 ");
+
+        for (int k = 0; k <= dataBytes; k++)
+            single += QString("%1 ").arg((int)bytes[i + k], 2, 16, QChar('0')).toUpper();
+
+        single += "\x0D\x0D>";
+
+        sensor->setBuffer(single);
+        sensors.removeAt(index);
+        answered++;
+
+        i += 1 + dataBytes;
+    }
+
+    if (answered == requested)
+    {
+        /* ECU understood the whole request */
+        m_rejections = 0;
+        return true;
+    }
+
+    if (answered <= 1)
+    {
+        /*
+            The ECU didn't answer, or only answered the first PID like older protocols do. After a few of these
+            we stop batching and go back to single requests
+        */
+        if (++m_rejections >= 3)
+        {
+#ifdef DEBUGAUTOMON
+            qDebug() << "ECU does not accept multi PID requests. Falling back to single PID requests";
+#endif
+            m_enabled.store(false);
+        }
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef PIDBATCHER_H
+#define PIDBATCHER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QString>
+
+#include "sensor.h"
+
+namespace AutomonKernel
+{
+    /*
+        The PidBatcher groups mode 01 sensors into multi PID requests, eg: "01 0C 0D 05 11 10 2F".
+        CAN ECUs answer up to six PIDs in one response, so six sensors cost one ECU round trip instead of six.
+        The combined response is split back into a normal single PID response for each sensor so the
+        sensors convert their results exactly as before.
+    */
+
+    class PidBatcher
+    {
+    public:
+        enum { MAXPIDS = 6 }; /* Maximum number of PIDs the ELM327/ECU accept in one mode 01 request */
+
+        PidBatcher();
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+        static bool canBatch(Sensor * sensor);
+        static QString buildRequest(const QList<Sensor*> & sensors);
+        bool dispatchResponse(QList<Sensor*> & sensors, const char * response, int size);
+
+    private:
+        static int hexValue(char c);
+        QAtomicInt m_enabled; /* Set from the GUI thread, read in the serial thread */
+        int m_rejections;
+    };
+}
+
+#endif // PIDBATCHER_H
@@ -0,0 +1,337 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+PidScheduler::PidScheduler()
+{
+    m_sampleCost = 0;
+}
+
+void PidScheduler::start()
+{
+    /*
+        Start the scheduler's clock. Called at the start of each monitoring session. Every sensor becomes due
+        straight away and the bus cost estimate starts again since the vehicle or adapter may have changed.
+    */
+
+    m_clock.start();
+    m_sampleCost = 0;
+
+    for (int i = 0; i < m_entries.size(); i++)
+        m_entries[i].deadline = 0;
+
+    rebalance();
+}
+
+qint64 PidScheduler::elapsed() const
+{
+    /* Milliseconds since the scheduler was started. QElapsedTimer uses the monotonic clock where there is one */
+    return m_clock.isValid() ? m_clock.elapsed() : 0;
+}
+
+int PidScheduler::indexOf(Sensor * sensor) const
+{
+    for (int i = 0; i < m_entries.size(); i++)
+        if (m_entries[i].sensor == sensor)
+            return i;
+
+    return -1;
+}
+
+void PidScheduler::synchronise(const QList<Sensor*> & sensors)
+{
+    /*
+        This method brings the scheduler's entries in line with the active sensor list. Sensors can be added or
+        removed while monitoring, and their target rate changed. New sensors and sensors with a new rate are
+        due straight away.
+    */
+
+    bool changed = false;
+    qint64 now = elapsed();
+
+    /* Drop the sensors that are no longer active */
+    for (int i = m_entries.size() - 1; i >= 0; i--)
+    {
+        if (!sensors.contains(m_entries[i].sensor))
+        {
+            m_entries.removeAt(i);
+            changed = true;
+        }
+    }
+
+    for (int i = 0; i < sensors.size(); i++)
+    {
+        int index = indexOf(sensors[i]);
+
+        if (index == -1)
+        {
+            Entry entry;
+            entry.sensor = sensors[i];
+            entry.requestedRate = sensors[i]->getTargetRate();
+            entry.deadline = now;
+            entry.allocatedRate = entry.requestedRate;
+            m_entries.append(entry);
+            changed = true;
+        }
+        else if (m_entries[index].requestedRate != sensors[i]->getTargetRate())
+        {
+            m_entries[index].requestedRate = sensors[i]->getTargetRate();
+            m_entries[index].deadline = now;
+            changed = true;
+        }
+    }
+
+    if (changed)
+        rebalance();
+}
+
+QList<Sensor*> PidScheduler::takeDue(int maxCount)
+{
+    /*
+        This method returns up to maxCount sensors whose deadline has passed, earliest deadline first.
+        When two sensors have the same deadline the higher priority one goes first.
+        Sensors with no target rate are always due, and their deadline is the time they were last read
+        so they share whatever time the periodic sensors leave free.
+    */
+
+    QList<int> due;
+    qint64 now = elapsed();
+
+    for (int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].deadline > now)
+            continue;
+
+        /* Insert in order. There are only ever a handful of sensors so this is cheap */
+        int position = 0;
+        while (position < due.size())
+        {
+            const Entry & other = m_entries[due[position]];
+
+            if (m_entries[i].deadline < other.deadline ||
+                (m_entries[i].deadline == other.deadline && m_entries[i].sensor->getPriority() > other.sensor->getPriority()))
+                break;
+
+            position++;
+        }
+
+        due.insert(position, i);
+    }
+
+    QList<Sensor*> sensors;
+
+    for (int i = 0; i < due.size() && i < maxCount; i++)
+        sensors.append(m_entries[due[i]].sensor);
+
+    return sensors;
+}
+
+void PidScheduler::completed(const QList<Sensor*> & sensors, qint64 roundTime)
+{
+    /*
+        This method is called after the sensors from takeDue() have been read. Each sensor gets its next
+        deadline one period after the last one so the rate doesn't drift with how long a round took.
+        If a sensor fell more than a whole period behind it is made due now instead of being read several
+        times in a row to catch up.
+        The round time is used to keep the average cost of a sensor read, which is what the bus can manage.
+    */
+
+    if (sensors.isEmpty())
+        return;
+
+    qint64 now = elapsed();
+
+    for (int i = 0; i < sensors.size(); i++)
+    {
+        int index = indexOf(sensors[i]);
+
+        if (index == -1)
+            continue;
+
+        Entry & entry = m_entries[index];
+
+        entry.sensor->recordRefresh(now);
+
+        /* Channels come out of the same answer, so they are refreshed with their source */
+        QList<Sensor*> channels = entry.sensor->getChannels();
+
+        for (int c = 0; c < channels.size(); c++)
+            channels[c]->recordRefresh(now);
+
+        if (entry.allocatedRate <= 0)
+        {
+            entry.deadline = now;
+        }
+        else
+        {
+            entry.deadline += (qint64)(1000.0 / entry.allocatedRate);
+
+            if (entry.deadline < now)
+                entry.deadline = now;
+        }
+    }
+
+    double cost = (double)roundTime / sensors.size();
+
+    if (!m_sampleCost)
+        m_sampleCost = cost;
+    else
+        m_sampleCost = 0.8 * m_sampleCost + 0.2 * cost;
+
+    rebalance();
+}
+
+qint64 PidScheduler::timeUntilNextDeadline() const
+{
+    /* Return how many milliseconds until the next sensor is due. 0 if one is due now, -1 if there are no sensors */
+
+    if (m_entries.isEmpty())
+        return -1;
+
+    qint64 now = elapsed();
+    qint64 next = m_entries[0].deadline;
+
+    for (int i = 1; i < m_entries.size(); i++)
+        if (m_entries[i].deadline < next)
+            next = m_entries[i].deadline;
+
+    return next > now ? next - now : 0;
+}
+
+double PidScheduler::getCapacity() const
+{
+    /* Return the estimated number of sensor reads per second the bus can manage. 0 until it has been measured */
+    return m_sampleCost > 0 ? 1000.0 / m_sampleCost : 0;
+}
+
+double PidScheduler::getAllocatedRate(Sensor * sensor) const
+{
+    /*
+        Return the rate the scheduler is actually aiming for with this sensor. Lower than its target when degraded.
+        0 if it is read as fast as possible, or isn't scheduled. Safe to call from any thread
+    */
+    QMutexLocker locker(&m_allocationLock);
+    return m_allocations.value(sensor, 0);
+}
+
+void PidScheduler::rebalance()
+{
+    /*
+        This method shares the bus between the sensors that asked for a rate. Sensors are given their target
+        rate in order of priority, highest first, until the estimated capacity runs out. The remaining sensors
+        are slowed down to what is left, but never below MINRATE_MHZ. Within the same priority the slower
+        sensors are served first since they cost less. 10% of the capacity is kept back for the sensors that
+        asked to be read as fast as possible.
+    */
+
+    double budget = getCapacity() * 0.9;
+    double minRate = MINRATE_MHZ / 1000.0;
+    QList<int> order;
+
+    for (int i = 0; i < m_entries.size(); i++)
+    {
+        m_entries[i].allocatedRate = m_entries[i].requestedRate;
+
+        if (m_entries[i].requestedRate <= 0)
+            continue;
+
+        int position = 0;
+        while (position < order.size())
+        {
+            const Entry & other = m_entries[order[position]];
+
+            if (m_entries[i].sensor->getPriority() > other.sensor->getPriority() ||
+                (m_entries[i].sensor->getPriority() == other.sensor->getPriority() && m_entries[i].requestedRate < other.requestedRate))
+                break;
+
+            position++;
+        }
+
+        order.insert(position, i);
+    }
+
+    /* Nothing is shared out until the cost of a read has been measured */
+    bool measured = budget > 0;
+
+    for (int i = 0; i < order.size() && measured; i++)
+    {
+        Entry & entry = m_entries[order[i]];
+
+        /* Once the budget is spent, the lower priority sensors only get the minimum */
+        if (entry.requestedRate > budget)
+            entry.allocatedRate = budget > minRate ? budget : minRate;
+
+        budget -= entry.allocatedRate;
+
+        if (budget < 0)
+            budget = 0;
+    }
+
+    /*
+        The capacity estimate moves a little every round. Only a change of a tenth of the requested rate from the
+        published one counts, so the log and the published rates don't churn. Only this thread writes them
+    */
+    bool changed = m_allocations.size() != m_entries.size();
+
+    for (int i = 0; i < m_entries.size(); i++)
+    {
+        const Entry & entry = m_entries[i];
+        double published = m_allocations.value(entry.sensor, -1);
+
+        if (published >= 0 && qAbs(entry.allocatedRate - published) <= 0.1 * entry.requestedRate)
+            continue;
+
+        changed = true;
+
+#ifdef DEBUGAUTOMON
+        if (entry.allocatedRate < entry.requestedRate)
+            qDebug("Bus can't keep up. %s degraded from %.2f Hz to %.2f Hz", qPrintable(entry.sensor->getPid()),
+                   entry.requestedRate, entry.allocatedRate);
+        else
+            qDebug("%s back to %.2f Hz", qPrintable(entry.sensor->getPid()), entry.allocatedRate);
+#endif
+    }
+
+    if (!changed)
+        return;
+
+    QMutexLocker locker(&m_allocationLock);
+
+    m_allocations.clear();
+
+    for (int i = 0; i < m_entries.size(); i++)
+        m_allocations.insert(m_entries[i].sensor, m_entries[i].allocatedRate);
+}
@@ -0,0 +1,92 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef PIDSCHEDULER_H
+#define PIDSCHEDULER_H
+
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include "sensor.h"
+
+namespace AutomonKernel
+{
+    /*
+        The PidScheduler decides which sensors the serial thread reads next. Each sensor has a target rate in Hz
+        and so a deadline for its next read. The sensors whose deadline has passed are handed out earliest deadline
+        first, timed with a monotonic clock. It keeps a running estimate of how long one sensor read costs on the
+        bus. When the requested rates add up to more than the bus can do, the lowest priority sensors get their
+        rate lowered first so the important ones keep theirs.
+
+        Only the serial thread schedules. The allocated rates are published under a lock so the GUI can show
+        them with getAllocatedRate().
+    */
+
+    class PidScheduler
+    {
+    public:
+        PidScheduler();
+        void start();
+        void synchronise(const QList<Sensor*> & sensors);
+        QList<Sensor*> takeDue(int maxCount);
+        void completed(const QList<Sensor*> & sensors, qint64 roundTime);
+        qint64 timeUntilNextDeadline() const;
+        qint64 elapsed() const;
+        double getCapacity() const;
+        double getAllocatedRate(Sensor * sensor) const;
+
+    private:
+        struct Entry
+        {
+            Sensor * sensor;
+            double requestedRate; /* The sensor's target rate when it was last looked at */
+            qint64 deadline;      /* Time in ms the sensor should next be read by */
+            double allocatedRate; /* Rate the scheduler gives the sensor. 0 means as fast as possible */
+        };
+
+        void rebalance();
+        int indexOf(Sensor * sensor) const;
+
+        enum { MINRATE_MHZ = 200 }; /* A degraded sensor is still read at least every 5 seconds */
+
+        QList<Entry> m_entries;
+        QElapsedTimer m_clock;
+        double m_sampleCost; /* Average milliseconds the bus takes per sensor read */
+        mutable QMutex m_allocationLock;
+        QHash<Sensor*, double> m_allocations; /* Copy of the allocated rates for other threads */
+    };
+}
+
+#endif // PIDSCHEDULER_H
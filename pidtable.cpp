@@ -0,0 +1,206 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+using namespace AutomonKernel::PidDecode;
+
+/*
+    The SAE J1979 mode 01 PIDs that carry a value. Status and bit encoded PIDs, like 01 and 03, are read by
+    other parts of Automon. PIDs with two values in one answer, eg: the O2 sensors, have the second value
+    as a channel at the end of the line. Names of the PIDs Automon always had are kept, so nothing that shows
+    them changes.
+*/
+static constexpr PidDescriptor pidDescriptors[] =
+{
+    /* PID  Name                                       Units                  Bytes  Min     Max         Decode */
+    { 0x04, "Calculated Engine Load",                  Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x05, "Engine coolant temperature",              Sensor::DEGREES,       1,     -40,    215,        byteValue<0, 1, 1, -40> },
+    { 0x06, "Short Term Fuel Trim Bank 1",             Sensor::PERCENTAGE,    1,     -100,   99.2,       byteValue<0, 100, 128, -100> },
+    { 0x07, "Long Term Fuel Trim Bank 1",              Sensor::PERCENTAGE,    1,     -100,   99.2,       byteValue<0, 100, 128, -100> },
+    { 0x08, "Short Term Fuel Trim Bank 2",             Sensor::PERCENTAGE,    1,     -100,   99.2,       byteValue<0, 100, 128, -100> },
+    { 0x09, "Long Term Fuel Trim Bank 2",              Sensor::PERCENTAGE,    1,     -100,   99.2,       byteValue<0, 100, 128, -100> },
+    { 0x0A, "Fuel Pressure",                           Sensor::KPA,           1,     0,      765,        byteValue<0, 3, 1, 0> },
+    { 0x0B, "Intake Manifold Pressure",                Sensor::KPA,           1,     0,      255,        byteValue<0, 1, 1, 0> },
+    { 0x0C, "Engine RPM",                              Sensor::RPM,           2,     0,      12000,      wordValue<0, 1, 4, 0> },
+    { 0x0D, "Vehicle Speed",                           Sensor::KMH,           1,     0,      255,        byteValue<0, 1, 1, 0> },
+    { 0x0E, "Timing Advance",                          Sensor::DEGREES,       1,     -64,    63.5,       byteValue<0, 1, 2, -64> },
+    { 0x0F, "Intake Air Temperature",                  Sensor::DEGREES,       1,     -40,    215,        byteValue<0, 1, 1, -40> },
+    { 0x10, "MAF Airflow Sensor",                      Sensor::GS,            2,     0,      655.35,     wordValue<0, 1, 100, 0> },
+    { 0x11, "Throttle Position",                       Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x14, "02 Voltage in Bank 1 Sensor 1",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 1 Sensor 1", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x15, "O2 Voltage in Bank 1 Sensor 2",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 1 Sensor 2", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x16, "O2 Voltage in Bank 1 Sensor 3",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 1 Sensor 3", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x17, "O2 Voltage in Bank 1 Sensor 4",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 1 Sensor 4", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x18, "O2 Voltage in Bank 2 Sensor 1",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 2 Sensor 1", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x19, "O2 Voltage in Bank 2 Sensor 2",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 2 Sensor 2", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x1A, "O2 Voltage in Bank 2 Sensor 3",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 2 Sensor 3", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x1B, "O2 Voltage in Bank 2 Sensor 4",           Sensor::VOLTS,         2,     0,      1.275,      byteValue<0, 1, 200, 0>,
+      { "Short Term Fuel Trim Bank 2 Sensor 4", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x1F, "Engine Runtime",                          Sensor::SECONDS,       2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x21, "Distance Travelled with MIL On",          Sensor::KM,            2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x22, "Fuel Rail Pressure (Manifold Vacuum)",    Sensor::KPA,           2,     0,      5177.265,   wordValue<0, 79, 1000, 0> },
+    { 0x23, "Fuel Rail Gauge Pressure",                Sensor::KPA,           2,     0,      655350,     wordValue<0, 10, 1, 0> },
+    { 0x24, "O2 Sensor 1 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 1 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x25, "O2 Sensor 2 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 2 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x26, "O2 Sensor 3 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 3 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x27, "O2 Sensor 4 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 4 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x28, "O2 Sensor 5 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 5 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x29, "O2 Sensor 6 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 6 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x2A, "O2 Sensor 7 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 7 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x2B, "O2 Sensor 8 Equivalence Ratio",           Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 8 Voltage", Sensor::VOLTS, 0, 8, wordValue<2, 8, 65536, 0> } },
+    { 0x2C, "Commanded EGR",                           Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x2D, "EGR Error",                               Sensor::PERCENTAGE,    1,     -100,   99.2,       byteValue<0, 100, 128, -100> },
+    { 0x2E, "Commanded Evaporative Purge",             Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x2F, "Fuel Level Input",                        Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x30, "Warm-ups Since Codes Cleared",            Sensor::COUNT,         1,     0,      255,        byteValue<0, 1, 1, 0> },
+    { 0x31, "Distance Travelled Since Codes Cleared",  Sensor::KM,            2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x32, "Evap System Vapour Pressure",             Sensor::PA,            2,     -8192,  8191.75,    signedWordValue<0, 1, 4, 0> },
+    { 0x33, "Barometric Pressure",                     Sensor::KPA,           1,     0,      255,        byteValue<0, 1, 1, 0> },
+    { 0x34, "O2 Sensor 1 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 1 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x35, "O2 Sensor 2 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 2 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x36, "O2 Sensor 3 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 3 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x37, "O2 Sensor 4 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 4 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x38, "O2 Sensor 5 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 5 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x39, "O2 Sensor 6 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 6 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x3A, "O2 Sensor 7 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 7 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x3B, "O2 Sensor 8 Equivalence Ratio (Current)", Sensor::RATIO,         4,     0,      2,          wordValue<0, 2, 65536, 0>,
+      { "O2 Sensor 8 Current", Sensor::MA, -128, 128, wordValue<2, 1, 256, -128> } },
+    { 0x3C, "Catalyst Temperature Bank 1 Sensor 1",    Sensor::DEGREES,       2,     -40,    6513.5,     wordValue<0, 1, 10, -40> },
+    { 0x3D, "Catalyst Temperature Bank 2 Sensor 1",    Sensor::DEGREES,       2,     -40,    6513.5,     wordValue<0, 1, 10, -40> },
+    { 0x3E, "Catalyst Temperature Bank 1 Sensor 2",    Sensor::DEGREES,       2,     -40,    6513.5,     wordValue<0, 1, 10, -40> },
+    { 0x3F, "Catalyst Temperature Bank 2 Sensor 2",    Sensor::DEGREES,       2,     -40,    6513.5,     wordValue<0, 1, 10, -40> },
+    { 0x42, "Control Module Voltage",                  Sensor::VOLTS,         2,     0,      65.535,     wordValue<0, 1, 1000, 0> },
+    { 0x43, "Absolute Load Value",                     Sensor::PERCENTAGE,    2,     0,      25700,      wordValue<0, 100, 255, 0> },
+    { 0x44, "Commanded Equivalence Ratio",             Sensor::RATIO,         2,     0,      2,          wordValue<0, 2, 65536, 0> },
+    { 0x45, "Relative Throttle Position",              Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x46, "Ambient Air Temperature",                 Sensor::DEGREES,       1,     -40,    215,        byteValue<0, 1, 1, -40> },
+    { 0x47, "Absolute Throttle Position B",            Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x48, "Absolute Throttle Position C",            Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x49, "Accelerator Pedal Position D",            Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x4A, "Accelerator Pedal Position E",            Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x4B, "Accelerator Pedal Position F",            Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x4C, "Commanded Throttle Actuator",             Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x4D, "Time Run with MIL On",                    Sensor::MINUTES,       2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x4E, "Time Since Codes Cleared",                Sensor::MINUTES,       2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x52, "Ethanol Fuel Percentage",                 Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x53, "Absolute Evap System Vapour Pressure",    Sensor::KPA,           2,     0,      327.675,    wordValue<0, 1, 200, 0> },
+    { 0x54, "Evap System Vapour Pressure (Wide)",      Sensor::PA,            2,     -32768, 32767,      signedWordValue<0, 1, 1, 0> },
+    { 0x55, "Short Term Secondary O2 Trim Bank 1",     Sensor::PERCENTAGE,    2,     -100,   99.2,       byteValue<0, 100, 128, -100>,
+      { "Short Term Secondary O2 Trim Bank 3", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x56, "Long Term Secondary O2 Trim Bank 1",      Sensor::PERCENTAGE,    2,     -100,   99.2,       byteValue<0, 100, 128, -100>,
+      { "Long Term Secondary O2 Trim Bank 3", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x57, "Short Term Secondary O2 Trim Bank 2",     Sensor::PERCENTAGE,    2,     -100,   99.2,       byteValue<0, 100, 128, -100>,
+      { "Short Term Secondary O2 Trim Bank 4", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x58, "Long Term Secondary O2 Trim Bank 2",      Sensor::PERCENTAGE,    2,     -100,   99.2,       byteValue<0, 100, 128, -100>,
+      { "Long Term Secondary O2 Trim Bank 4", Sensor::PERCENTAGE, -100, 99.2, byteValue<1, 100, 128, -100> } },
+    { 0x59, "Fuel Rail Absolute Pressure",             Sensor::KPA,           2,     0,      655350,     wordValue<0, 10, 1, 0> },
+    { 0x5A, "Relative Accelerator Pedal Position",     Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x5B, "Hybrid Battery Pack Remaining Life",      Sensor::PERCENTAGE,    1,     0,      100,        byteValue<0, 100, 255, 0> },
+    { 0x5C, "Engine Oil Temperature",                  Sensor::DEGREES,       1,     -40,    210,        byteValue<0, 1, 1, -40> },
+    { 0x5D, "Fuel Injection Timing",                   Sensor::DEGREES,       2,     -210,   301.992,    wordValue<0, 1, 128, -210> },
+    { 0x5E, "Engine Fuel Rate",                        Sensor::LPH,           2,     0,      3212.75,    wordValue<0, 1, 20, 0> },
+    { 0x61, "Driver's Demand Engine Torque",           Sensor::PERCENTAGE,    1,     -125,   130,        byteValue<0, 1, 1, -125> },
+    { 0x62, "Actual Engine Torque",                    Sensor::PERCENTAGE,    1,     -125,   130,        byteValue<0, 1, 1, -125> },
+    { 0x63, "Engine Reference Torque",                 Sensor::NM,            2,     0,      65535,      wordValue<0, 1, 1, 0> },
+    { 0x8E, "Engine Friction Torque",                  Sensor::PERCENTAGE,    1,     -125,   130,        byteValue<0, 1, 1, -125> },
+    { 0xA6, "Odometer",                                Sensor::KM,            4,     0,      429496729.5, longValue<0, 1, 10, 0> }
+};
+
+static constexpr int pidDescriptorCount = sizeof(pidDescriptors) / sizeof(pidDescriptors[0]);
+
+/* find() looks PIDs up by halving the table, so the table has to stay sorted. Checked when compiling */
+static constexpr bool isSorted(int index)
+{
+    return index + 1 >= pidDescriptorCount ||
+           (pidDescriptors[index].pid < pidDescriptors[index + 1].pid && isSorted(index + 1));
+}
+
+static_assert(isSorted(0), "pidDescriptors must be sorted by PID");
+
+int PidTable::size()
+{
+    return pidDescriptorCount;
+}
+
+const PidDescriptor & PidTable::at(int index)
+{
+    return pidDescriptors[index];
+}
+
+const PidDescriptor * PidTable::find(int pid)
+{
+    /* Look up a mode 01 PID. NULL if it isn't in the table */
+
+    int low = 0;
+    int high = pidDescriptorCount - 1;
+
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+
+        if (pidDescriptors[middle].pid == pid)
+            return &pidDescriptors[middle];
+
+        if (pidDescriptors[middle].pid < pid)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,123 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef PIDTABLE_H
+#define PIDTABLE_H
+
+#include <QtGlobal>
+
+#include "sensor.h"
+
+namespace AutomonKernel
+{
+    /*
+        The decode kernels turn the data bytes of a mode 01 response into a value. Data points at byte A,
+        the first byte after the mode and PID. Every SAE J1979 formula is a byte or a word scaled by a whole
+        number fraction plus an offset, eg: RPM is (256A+B)/4 and coolant temperature A-40, so they are
+        templates and each PID gets its own specialised function at compile time.
+    */
+
+    namespace PidDecode
+    {
+        typedef double (*Kernel)(const quint8 * data);
+
+        /* One unsigned byte: data[Byte] * Mul / Div + Add */
+        template <int Byte, int Mul, int Div, int Add> double byteValue(const quint8 * data)
+        {
+            return data[Byte] * ((double)Mul / Div) + Add;
+        }
+
+        /* Two bytes, most significant first: (256 * data[Byte] + data[Byte + 1]) * Mul / Div + Add */
+        template <int Byte, int Mul, int Div, int Add> double wordValue(const quint8 * data)
+        {
+            return ((data[Byte] << 8) | data[Byte + 1]) * ((double)Mul / Div) + Add;
+        }
+
+        /* Two bytes as a two's complement number, eg: the evap system vapour pressure */
+        template <int Byte, int Mul, int Div, int Add> double signedWordValue(const quint8 * data)
+        {
+            return (qint16)((data[Byte] << 8) | data[Byte + 1]) * ((double)Mul / Div) + Add;
+        }
+
+        /* Four bytes, most significant first, eg: the odometer */
+        template <int Byte, int Mul, int Div, int Add> double longValue(const quint8 * data)
+        {
+            return (((quint32)data[Byte] << 24) | ((quint32)data[Byte + 1] << 16) |
+                    ((quint32)data[Byte + 2] << 8) | (quint32)data[Byte + 3]) * ((double)Mul / Div) + Add;
+        }
+    }
+
+    /* A second value carried in the same answer, eg: the fuel trim next to an O2 sensor voltage */
+
+    struct PidChannel
+    {
+        const char * name;
+        Sensor::UNITS units;
+        double min;
+        double max;
+        PidDecode::Kernel decode; /* NULL if the PID has no second value */
+    };
+
+    /*
+        A PidDescriptor is everything Automon needs to know about a mode 01 PID to read it as a sensor.
+        The table of them is in pidtable.cpp. Entries that leave out the second channel get an empty one.
+    */
+
+    struct PidDescriptor
+    {
+        int pid;
+        const char * name;
+        Sensor::UNITS units;
+        int bytes;            /* Data bytes in the answer */
+        double min;
+        double max;
+        PidDecode::Kernel decode;
+        PidChannel second;
+    };
+
+    /*
+        The PidTable is the catalogue of mode 01 PIDs Automon can read, sorted by PID. It is built at compile
+        time. Adding a sensor is a line in the table, see pidtable.cpp.
+    */
+
+    class PidTable
+    {
+    public:
+        static int size();
+        static const PidDescriptor & at(int index);
+        static const PidDescriptor * find(int pid);
+    };
+}
+
+#endif // PIDTABLE_H
@@ -30,20 +30,17 @@
     
 */
 
-#ifndef ENGINERPMSENSOR_H
-#define ENGINERPMSENSOR_H
 
-#include "sensor.h"
+#include "automon.h"
 
-namespace AutomonKernel
+using namespace AutomonKernel;
+
+PtyTransport::PtyTransport(QString path)
+    : SerialTransport(path, false)
+{
+}
+
+QString PtyTransport::getUri() const
 {
-    class EngineRPM : public Sensor
-    {
-    public:
-        EngineRPM(QString command, QString englishMeaning);
-        EngineRPM();
-        double convertResult();
-        ~EngineRPM() { }
-    };
+    return "pty://" + m_port;
 }
-#endif // ENGINERPMSENSOR_H
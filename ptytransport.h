@@ -30,20 +30,25 @@
     
 */
 
-#ifndef MAFAIRFLOWRATESENSOR_H
-#define MAFAIRFLOWRATESENSOR_H
 
-#include "sensor.h"
+#ifndef PTYTRANSPORT_H
+#define PTYTRANSPORT_H
+
+#include "serialtransport.h"
 
 namespace AutomonKernel
 {
-    class MafAirFlowRate : public Sensor
+    /*
+        The PtyTransport connects to a pseudo terminal, such as the one the ELM327 emulator prints when it starts.
+        It is a serial port without a baud rate.
+    */
+
+    class PtyTransport : public SerialTransport
     {
     public:
-        MafAirFlowRate(QString command, QString englishMeaning);
-        MafAirFlowRate();
-        double convertResult();
-        ~MafAirFlowRate() { }
+        PtyTransport(QString path);
+        QString getUri() const;
     };
 }
-#endif // MAFAIRFLOWRATESENSOR_H
+
+#endif // PTYTRANSPORT_H
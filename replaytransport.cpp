@@ -0,0 +1,219 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include <QFile>
+#include <QTextStream>
+
+#include "automon.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace AutomonKernel;
+
+ReplayTransport::ReplayTransport(QString fileName)
+    : m_fileName(fileName)
+{
+    m_position = 0;
+    m_isOpen = false;
+    m_signal[0] = -1;
+    m_signal[1] = -1;
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    close();
+}
+
+QString ReplayTransport::getUri() const
+{
+    return "replay://" + m_fileName;
+}
+
+bool ReplayTransport::open()
+{
+    /* Load every request and its response from the recording */
+
+    close();
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QTextStream in(&file);
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+
+        if (line.startsWith("> "))
+        {
+            Exchange exchange;
+            exchange.request = line.mid(2).trimmed();
+            m_exchanges.append(exchange);
+        }
+        else if (line.startsWith("<") && !m_exchanges.isEmpty())
+        {
+            /* A response line. "<" on its own is an empty line of the response */
+            m_exchanges.last().response += line.mid(2).toLatin1() + "\x0D";
+        }
+    }
+
+    for (int i = 0; i < m_exchanges.size(); i++)
+        m_exchanges[i].response += ">";
+
+#ifdef Q_OS_UNIX
+    if (pipe(m_signal) != 0)
+        return false;
+
+    fcntl(m_signal[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_signal[1], F_SETFL, O_NONBLOCK);
+#endif
+
+    m_position = 0;
+    m_isOpen = true;
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Replaying" << m_exchanges.size() << "recorded requests from" << m_fileName;
+#endif
+
+    return true;
+}
+
+void ReplayTransport::close()
+{
+#ifdef Q_OS_UNIX
+    for (int i = 0; i < 2; i++)
+        if (m_signal[i] >= 0)
+            ::close(m_signal[i]);
+#endif
+
+    m_signal[0] = -1;
+    m_signal[1] = -1;
+    m_exchanges.clear();
+    m_request.clear();
+    m_lastRequest.clear();
+    m_pending.clear();
+    m_isOpen = false;
+}
+
+bool ReplayTransport::isOpen() const
+{
+    return m_isOpen;
+}
+
+int ReplayTransport::descriptor() const
+{
+    return m_signal[0];
+}
+
+qint64 ReplayTransport::bytesAvailable()
+{
+    return m_pending.size();
+}
+
+qint64 ReplayTransport::read(char * data, qint64 maxSize)
+{
+    /* Hand out the waiting response. Once it is all gone the pipe is emptied so the reactor sleeps again */
+
+    qint64 bytes = qMin((qint64)m_pending.size(), maxSize);
+
+    memcpy(data, m_pending.constData(), bytes);
+    m_pending.remove(0, bytes);
+
+#ifdef Q_OS_UNIX
+    if (m_pending.isEmpty())
+    {
+        char rubbish[16];
+        while (::read(m_signal[0], rubbish, sizeof(rubbish)) > 0)
+            ;
+    }
+#endif
+
+    return bytes;
+}
+
+qint64 ReplayTransport::write(const char * data, qint64 size)
+{
+    /* Gather the request until its carriage return, then queue the recorded answer. A bare one repeats the last */
+
+    for (qint64 i = 0; i < size; i++)
+    {
+        if (data[i] == '\x0D')
+        {
+            QString request = QString::fromLatin1(m_request).trimmed();
+
+            if (request.isEmpty())
+                request = m_lastRequest;
+            else
+                m_lastRequest = request;
+
+            answer(request);
+            m_request.clear();
+        }
+        else
+            m_request += data[i];
+    }
+
+    return size;
+}
+
+void ReplayTransport::answer(QString request)
+{
+    /* Find the next recording of this request, wrapping round at the end of the file */
+
+    QByteArray response = "?\x0D\x0D>";
+
+    for (int i = 0; i < m_exchanges.size(); i++)
+    {
+        int index = (m_position + i) % m_exchanges.size();
+
+        if (m_exchanges[index].request.compare(request) == 0)
+        {
+            response = m_exchanges[index].response;
+            m_position = index + 1;
+            break;
+        }
+    }
+
+    m_pending += response;
+
+#ifdef Q_OS_UNIX
+    /* Make the pipe readable so a reactor waiting on it wakes up */
+    char ready = 1;
+    ssize_t written = ::write(m_signal[1], &ready, 1);
+    Q_UNUSED(written);
+#endif
+}
@@ -0,0 +1,95 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+#include "transport.h"
+
+namespace AutomonKernel
+{
+    /*
+        The ReplayTransport plays back a recorded session instead of talking to an adapter, so the serial
+        thread can be benchmarked without a car. The file is what SerialHelper::setRecordFile() writes:
+
+            # Comment
+            > 010C
+            < 41 0C 1A F8
+            <
+
+        A "> " line is a request and the "< " lines after it are its response lines. Each response line gets
+        its line break back and the prompt is added after the last one. A request is answered with the next
+        recording of the same request, wrapping round at the end of the file, so a short recording can be
+        replayed for as long as needed. A request that was never recorded gets the ELM327's "?".
+        Responses are available straight away, the recorded ECU latency is not reproduced.
+    */
+
+    class ReplayTransport : public Transport
+    {
+    public:
+        ReplayTransport(QString fileName);
+        ~ReplayTransport();
+        bool open();
+        void close();
+        bool isOpen() const;
+        int descriptor() const;
+        qint64 bytesAvailable();
+        qint64 read(char * data, qint64 maxSize);
+        qint64 write(const char * data, qint64 size);
+        QString getUri() const;
+
+    private:
+        struct Exchange
+        {
+            QString request;
+            QByteArray response;
+        };
+
+        void answer(QString request);
+
+        QString m_fileName;
+        QList<Exchange> m_exchanges;
+        int m_position;
+        bool m_isOpen;
+        QByteArray m_request;
+        QString m_lastRequest;
+        QByteArray m_pending;
+        int m_signal[2]; /* Pipe that is readable while a response is waiting, so the reactor can wait on it */
+    };
+}
+
+#endif // REPLAYTRANSPORT_H
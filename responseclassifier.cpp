@@ -0,0 +1,236 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+/* The messages the ELM327 sends instead of data, compared without spaces. First match wins */
+static const struct
+{
+    const char * message;
+    ResponseClassifier::Status status;
+}
+elmMessages[] =
+{
+    { "NODATA",          ResponseClassifier::NoData },
+    { "?",               ResponseClassifier::NoData },
+    { "SEARCHING...",    ResponseClassifier::Searching },
+    { "BUSERROR",        ResponseClassifier::BusError },
+    { "BUSBUSY",         ResponseClassifier::BusError },
+    { "BUSINIT:...OK",   ResponseClassifier::Searching },
+    { "BUSINIT:...ERROR", ResponseClassifier::BusError },
+    { "FBERROR",         ResponseClassifier::BusError },
+    { "UNABLETOCONNECT", ResponseClassifier::BusError },
+    { "CANERROR",        ResponseClassifier::CanError },
+    { "BUFFERFULL",      ResponseClassifier::CanError },
+    { "STOPPED",         ResponseClassifier::Stopped }
+};
+
+static inline unsigned int charCode(char c)
+{
+    return (unsigned char)c;
+}
+
+static inline unsigned int charCode(QChar c)
+{
+    return c.unicode();
+}
+
+static inline bool isHexDigit(unsigned int c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+ResponseClassifier::ResponseClassifier()
+{
+    reset();
+}
+
+ResponseClassifier::Status ResponseClassifier::classify(const char * response, int size)
+{
+    /* Classify the raw buffer as the serial helper read it */
+    return classifyChars(response, size);
+}
+
+ResponseClassifier::Status ResponseClassifier::classify(const QString & response)
+{
+    /* Classify the characters where the QString keeps them */
+    return classifyChars(response.constData(), response.size());
+}
+
+const char * ResponseClassifier::statusName(Status status)
+{
+    /* For debug output and the statistics */
+
+    switch (status)
+    {
+        case Ok: return "OK";
+        case NoData: return "NO DATA";
+        case BusError: return "BUS ERROR";
+        case CanError: return "CAN ERROR";
+        case Stopped: return "STOPPED";
+        case Searching: return "SEARCHING";
+        default: return "MALFORMED";
+    }
+}
+
+void ResponseClassifier::record(Status status)
+{
+    /* Count a response. Called in the serial thread, read from the GUI thread */
+    m_counts[status].ref();
+}
+
+int ResponseClassifier::getCount(Status status) const
+{
+    return m_counts[status].load();
+}
+
+int ResponseClassifier::getTotal() const
+{
+    int total = 0;
+
+    for (int i = 0; i < STATUSES; i++)
+        total += m_counts[i].load();
+
+    return total;
+}
+
+void ResponseClassifier::reset()
+{
+    for (int i = 0; i < STATUSES; i++)
+        m_counts[i].store(0);
+}
+
+template <typename Char> ResponseClassifier::Status ResponseClassifier::classifyChars(const Char * response, int size)
+{
+    /*
+        Walk the response line by line up to the prompt. A line of hex is data. Any other line has to be one
+        of the ELM327's messages, and the first one found decides, except SEARCHING... which only counts if
+        nothing worse follows it, eg: SEARCHING... then UNABLE TO CONNECT. No prompt means it never finished
+    */
+
+    Status status = Ok;
+    bool data = false;
+    bool prompt = false;
+    int start = 0;
+
+    for (int i = 0; i <= size && !prompt; i++)
+    {
+        unsigned int c = i < size ? charCode(response[i]) : '\x0D';
+
+        if (c == '>')
+            prompt = true;
+        else if (c != '\x0D' && c != '\x0A')
+            continue;
+
+        Status line = classifyLine(response + start, i - start);
+        start = i + 1;
+
+        if (line == Ok)
+            data = true;
+        else if (line != STATUSES && (status == Ok || status == Searching))
+            status = line;
+    }
+
+    if (!prompt)
+        return Malformed;
+
+    if (status == Ok && !data)
+        return Malformed;
+
+    return status;
+}
+
+template <typename Char> ResponseClassifier::Status ResponseClassifier::classifyLine(const Char * line, int size)
+{
+    /* Classify one line without its line break. STATUSES means the line was empty */
+
+    bool hex = true;
+    bool empty = true;
+    int first = 0;
+
+    while (first < size && charCode(line[first]) == ' ')
+        first++;
+
+    /* Skip the frame number of a CAN multi frame line, eg: "0: 41 0C 1A F8 0D 00", as PidBatcher does */
+    if (first + 1 < size && isHexDigit(charCode(line[first])) && charCode(line[first + 1]) == ':')
+        first += 2;
+
+    for (int i = first; i < size; i++)
+    {
+        unsigned int c = charCode(line[i]);
+
+        if (c == ' ')
+            continue;
+
+        empty = false;
+
+        if (!isHexDigit(c))
+        {
+            hex = false;
+            break;
+        }
+    }
+
+    if (empty)
+        return STATUSES;
+
+    if (hex)
+        return Ok;
+
+    /* Compare against each message, skipping the spaces in the line */
+    for (unsigned int m = 0; m < sizeof(elmMessages) / sizeof(elmMessages[0]); m++)
+    {
+        const char * message = elmMessages[m].message;
+        int i = 0;
+
+        while (*message)
+        {
+            while (i < size && charCode(line[i]) == ' ')
+                i++;
+
+            if (i == size || charCode(line[i]) != (unsigned char)*message)
+                break;
+
+            i++;
+            message++;
+        }
+
+        if (!*message)
+            return elmMessages[m].status;
+    }
+
+    return Malformed;
+}
@@ -0,0 +1,84 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef RESPONSECLASSIFIER_H
+#define RESPONSECLASSIFIER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+namespace AutomonKernel
+{
+    /*
+        The ResponseClassifier tags an ELM327 response with what it is: data, or one of the messages the ELM327
+        sends instead, eg: NO DATA or BUS ERROR. It looks at every character once and doesn't allocate or throw,
+        so a link with lots of errors costs no more than a good one. Spaces are ignored, so the compact output
+        after ATS0 classifies the same.
+
+        An instance also counts the statuses it was given, so the statistics of a link can be shown.
+    */
+
+    class ResponseClassifier
+    {
+    public:
+        enum Status
+        {
+            Ok,         /* Lines of hex and the prompt */
+            NoData,     /* NO DATA, or ? when the ELM327 didn't understand the request */
+            BusError,   /* BUS ERROR, BUS BUSY, FB ERROR, UNABLE TO CONNECT and the like */
+            CanError,   /* CAN ERROR, BUFFER FULL */
+            Stopped,    /* STOPPED, the request was interrupted */
+            Searching,  /* SEARCHING... or BUS INIT ahead of the answer, the protocol was still being set up */
+            Malformed,  /* Anything else, eg: no prompt, DATA ERROR or stray characters */
+            STATUSES
+        };
+
+        ResponseClassifier();
+        static Status classify(const char * response, int size);
+        static Status classify(const QString & response);
+        static const char * statusName(Status status);
+        void record(Status status);
+        int getCount(Status status) const;
+        int getTotal() const;
+        void reset();
+
+    private:
+        template <typename Char> static Status classifyChars(const Char * response, int size);
+        template <typename Char> static Status classifyLine(const Char * line, int size);
+
+        QAtomicInt m_counts[STATUSES];
+    };
+}
+
+#endif // RESPONSECLASSIFIER_H
@@ -0,0 +1,135 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+#include <QSettings>
+
+using namespace AutomonKernel;
+
+ResponseCounts::ResponseCounts()
+{
+    /* Nothing is known until the counts are loaded or learned */
+}
+
+bool ResponseCounts::load(QString vin)
+{
+    /* Load the counts stored for the vehicle with this VIN. Returns false if it was never seen before */
+
+    m_vin = vin;
+    m_counts.clear();
+
+    if (vin.isEmpty())
+        return false;
+
+    QSettings settings("Automon", "Automon");
+    settings.beginGroup("ResponseCounts/" + vin);
+
+    QStringList commands = settings.childKeys();
+
+    for (int i = 0; i < commands.size(); i++)
+        m_counts[commands[i]] = settings.value(commands[i]).toInt();
+
+    settings.endGroup();
+
+    return !m_counts.isEmpty();
+}
+
+void ResponseCounts::save() const
+{
+    /* Store the counts under the VIN they were loaded for. Nothing is stored without a VIN */
+
+    if (m_vin.isEmpty())
+        return;
+
+    QSettings settings("Automon", "Automon");
+    settings.beginGroup("ResponseCounts/" + m_vin);
+    settings.remove("");
+
+    QMap<QString, int>::const_iterator i;
+    for (i = m_counts.constBegin(); i != m_counts.constEnd(); ++i)
+        settings.setValue(i.key(), i.value());
+
+    settings.endGroup();
+}
+
+int ResponseCounts::getCount(QString command) const
+{
+    /* The number of ECUs that answer the command. 0 if not known, in which case no count is sent */
+    return m_counts.value(command, 0);
+}
+
+void ResponseCounts::setCount(QString command, int count)
+{
+    /* Remember the count for a command. Counts the ELM327 can't take are dropped */
+
+    if (count < 1 || count > MAXCOUNT)
+        m_counts.remove(command);
+    else
+        m_counts[command] = count;
+}
+
+void ResponseCounts::clear()
+{
+    /* Forget the counts, eg: before learning them again */
+    m_counts.clear();
+}
+
+int ResponseCounts::countResponses(QString command, QString response)
+{
+    /*
+        Count the ECU responses in the answer to a single PID request sent with headers on. Each ECU answers
+        on its own line starting with its header, eg: "48 6B 10 41 0C 1A F8 D2" or "7E8 04 41 0C 1A F8".
+        Anything that isn't a line of hex, like SEARCHING... or NO DATA, isn't a response. Neither is the echo
+    */
+
+    QStringList lines = response.split("\x0D");
+    QRegExp hexLine("[0-9A-Fa-f]+");
+    int count = 0;
+
+    for (int i = 0; i < lines.size(); i++)
+    {
+        QString line = lines[i];
+        line.remove(' ');
+        line.remove('>');
+
+        if (line.compare(command, Qt::CaseInsensitive) == 0)
+            continue;
+
+        /* The shortest response is a three byte header, the mode and the PID */
+        if (line.size() >= 8 && hexLine.exactMatch(line))
+            count++;
+    }
+
+    return count;
+}
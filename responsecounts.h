@@ -0,0 +1,68 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef RESPONSECOUNTS_H
+#define RESPONSECOUNTS_H
+
+#include <QMap>
+#include <QString>
+
+namespace AutomonKernel
+{
+    /*
+        ResponseCounts remembers how many ECUs answer each PID on the current vehicle. The count goes after the
+        PID in the request, eg: "010C 1", and the ELM327 prints the prompt as soon as that many responses are in
+        instead of waiting for its timeout. The counts are learned once per vehicle with headers turned on and
+        stored under the VIN, so the next session can use them straight away.
+    */
+
+    class ResponseCounts
+    {
+    public:
+        ResponseCounts();
+        bool load(QString vin);
+        void save() const;
+        int getCount(QString command) const;
+        void setCount(QString command, int count);
+        void clear();
+        static int countResponses(QString command, QString response);
+
+        static const int MAXCOUNT = 15; /* The ELM327 takes a single hex digit */
+
+    private:
+        QString m_vin;
+        QMap<QString, int> m_counts;
+    };
+}
+
+#endif // RESPONSECOUNTS_H
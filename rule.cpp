@@ -35,9 +35,15 @@
 using namespace AutomonKernel;
 
 Rule::Rule()
+    : m_satisfied(false)
 {
-    /* Create a script engine that will perform execution of our rule script */
-    m_scriptEngine = new QScriptEngine();
+    /* No sensors are bound until the rule is activated. The clock gives the time to temporal operators */
+    m_clock.start();
+    for (int i = 0; i < RuleProgram::MAXVARIABLES; i++)
+    {
+        m_variableSensors[i] = NULL;
+        m_values[i] = 0;
+    }
 }
 
 bool Rule::addSensor(Sensor * sensor)
@@ -55,27 +61,10 @@ bool Rule::addSensor(Sensor * sensor)
         return false;
     }
 
-    /* Add the sensor pointer to our list of sensors */
+    /* Add the sensor pointer to our list of sensors. activate() matches it to the rule's variables */
     m_sensors.append(sensor);
 
-    /* Create a regular string for our command name */
-    char commandName[1024];
-
-    /* Prepend our command, ie sensor 010D with an s, so we have s010D. This is required since variables
-       in EmeaScript (javascript) cannot start with a number
-    */
-
-    QString copyIn = "s" + sensor->getCommand();
-
-    /* Copy the QString into our regular string */
-    strcpy(commandName, copyIn.toLatin1());
-
-    /* Create a QScriptValue object */
-    QScriptValue value(m_scriptEngine, 0.0);
-
-    /* Create a variable in our script engine of the name our sensor with the s and a value of 0.0 */
-    m_scriptEngine->globalObject().setProperty(commandName, value);
-
+    return true;
 }
 
 bool Rule::activate()
@@ -97,29 +86,32 @@ bool Rule::activate()
         if (m_sensors[i] == NULL)
             return false;
 
-    /* Get a list of the sensors in the rule string */
-    QStringList sensorNames;
-    sensorNames = m_rule.split(QRegExp("s"));
+    /* Ensure that the rule compiled */
+    if (!m_program.isValid())
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "Rule" << m_rule << "could not be compiled:" << m_program.getError();
+#endif
+        return false;
+    }
+
+    for (int i = 0; i < m_program.getVariableCount(); i++)
+    {
+        /* For each sensor in the rule, check if found in sensor list, and bind it to its variable */
+        found = false;
 
-    for (int i = 0; i < sensorNames.size(); i++)
-        if (sensorNames.at(i).compare("") != 0)
+        for (int j = 0; j < m_sensors.size(); j++)
         {
-            /* For each sensor that isn't NULL in the list, check if found in sensor list */
-            found = false;
-
-            for (int j = 0; j < m_sensors.size(); j++)
+            if (m_program.getVariable(i).compare(m_sensors.at(j)->getCommand()) == 0)
             {
-                if (sensorNames.at(i).section("",0,4).compare(m_sensors.at(j)->getCommand()) == 0)
-                    found = true; /* We have a match so safe */
+                m_variableSensors[i] = m_sensors[j];
+                found = true; /* We have a match so safe */
             }
-
-            if (!found)
-                return false; /* Sensor wasn't found in list so can't active so return */
         }
 
-    /* Ensure that the script engine can evaulate the inputted rule */
-    if (!m_scriptEngine->canEvaluate(m_rule))
-        return false;
+        if (!found)
+            return false; /* Sensor wasn't found in list so can't active so return */
+    }
 
     /* Connect each sensor's signal to this rule so we can get updates */
     for (int i = 0; i < m_sensors.size(); i++)
@@ -133,20 +125,15 @@ void Rule::updateRule(double value)
 {
     /*
         This slot is called by each sensor in the rule when their values change.
-        We update the value of the corresponding sensor in the script engine and do check
+        We update the value of the corresponding variable of the rule and do check
     */
 
     Sensor * senderSensor = static_cast<Sensor*>(QObject::sender());
 
-    char commandName[1024];
-    QString copyIn = "s" + senderSensor->getCommand();
-    strcpy(commandName, copyIn.toLatin1());
-
-    /* Set a new value to this */
-    QScriptValue scriptValue(m_scriptEngine, value);
-
-    /* Set the sXXXX sensor variable in the script engine to the value inputted */
-    m_scriptEngine->globalObject().setProperty(commandName, scriptValue);
+    /* Set the sXXXX variable bound to the sensor to the value inputted */
+    for (int i = 0; i < m_program.getVariableCount(); i++)
+        if (m_variableSensors[i] == senderSensor)
+            m_values[i] = value;
 
     /* Now do a check to see if the rule is satisfied */
     checkIfSatisfied();
@@ -164,8 +151,15 @@ bool Rule::validateRule()
 
 void Rule::setRule(QString rule)
 {
-    /* A setter method to set the rule */
+    /* A setter method to set the rule. It is compiled here once, not for every sample */
     m_rule = rule;
+    m_program.compile(rule);
+
+    for (int i = 0; i < RuleProgram::MAXVARIABLES; i++)
+    {
+        m_variableSensors[i] = NULL;
+        m_values[i] = 0;
+    }
 }
 
 void Rule::setRuleName(QString ruleName)
@@ -205,7 +199,7 @@ bool Rule::checkIfSatisfied()
     }
 
     /* Get the result of our rule expression */
-    bool ruleResult = m_scriptEngine->evaluate(m_rule.toLatin1()).toBoolean();
+    bool ruleResult = m_program.isSatisfied(m_values, m_clock.elapsed());
 
     if (ruleResult != m_satisfied && ruleResult)
     {
@@ -35,9 +35,10 @@
 
 #include <QString>
 #include <QObject>
-#include <QtScript>
+#include <QElapsedTimer>
 
 #include "sensor.h"
+#include "ruleprogram.h"
 
 namespace AutomonKernel
 {
@@ -64,7 +65,10 @@ namespace AutomonKernel
     private:
         bool validateRule();
 
-        QScriptEngine * m_scriptEngine;
+        RuleProgram m_program;
+        QElapsedTimer m_clock;
+        Sensor * m_variableSensors[RuleProgram::MAXVARIABLES];
+        double m_values[RuleProgram::MAXVARIABLES];
         QString m_rule;
         QString m_ruleName;
         bool m_satisfied;
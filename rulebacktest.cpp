@@ -0,0 +1,207 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "rulebacktest.h"
+
+/*
+    Like the HexDecoder this only includes its own header, so the backtest tool can build it without the rest
+    of Automon
+*/
+
+using namespace AutomonKernel;
+
+RuleBacktest::RuleBacktest()
+    : m_satisfiedTime(0), m_samples(0), m_satisfied(false)
+{
+}
+
+bool RuleBacktest::run(const QString & rule, const SensorHistory & history)
+{
+    /* Compile the rule and run it */
+
+    RuleProgram program(rule);
+
+    if (!program.isValid())
+    {
+        m_fireTimes.clear();
+        m_satisfiedTime = 0;
+        m_samples = 0;
+        m_error = program.getError();
+        return false;
+    }
+
+    return run(program, history);
+}
+
+bool RuleBacktest::run(const RuleProgram & program, const SensorHistory & history)
+{
+    /* Run the rule over the history. Returns false if the rule isn't valid or the history lacks one of its sensors */
+
+    m_fireTimes.clear();
+    m_satisfiedTime = 0;
+    m_samples = 0;
+    m_satisfied = false;
+    m_error.clear();
+
+    if (!program.isValid())
+    {
+        m_error = program.getError();
+        return false;
+    }
+
+    const double * columns[RuleProgram::MAXVARIABLES];
+    int first = 0;
+
+    for (int v = 0; v < program.getVariableCount(); v++)
+    {
+        int column = history.indexOfColumn(program.getVariable(v));
+
+        if (column == -1)
+        {
+            m_error = "The session has no values for " + program.getVariable(v);
+            return false;
+        }
+
+        columns[v] = history.column(column);
+
+        /* A live rule waits for all its sensors. Values hold once there, so skip to the row where the last one came */
+        while (first < history.size() && columns[v][first] != columns[v][first])
+            first++;
+    }
+
+    const qint64 * times = history.times();
+    int rows = history.size();
+
+    if (program.isTemporal())
+    {
+        /* Row at a time. The copy keeps the state of the temporal operators */
+
+        RuleProgram temporal(program);
+        temporal.reset();
+        double values[RuleProgram::MAXVARIABLES];
+        qint64 tick = first < rows ? times[first] + RuleProgram::TEMPORALINTERVAL : 0;
+
+        for (int row = first; row < rows; row++)
+        {
+            for (int v = 0; v < program.getVariableCount(); v++)
+                values[v] = columns[v][row];
+
+            qint64 time = times[row];
+            qint64 next = row + 1 < rows ? times[row + 1] : time;
+            bool satisfied = temporal.isSatisfied(values, time);
+
+            /* A tick at the time of the row is the same evaluation */
+            while (tick <= time)
+                tick += RuleProgram::TEMPORALINTERVAL;
+
+            /* The engine's timer goes off until the next row comes, the values are held meanwhile */
+            while (tick < next)
+            {
+                record(time, tick, satisfied);
+
+                time = tick;
+                satisfied = temporal.isSatisfied(values, time);
+                tick += RuleProgram::TEMPORALINTERVAL;
+            }
+
+            record(time, next, satisfied);
+        }
+    }
+    else
+    {
+        double results[RuleProgram::BLOCKSIZE];
+        const double * block[RuleProgram::MAXVARIABLES];
+
+        for (int row = first; row < rows; row += RuleProgram::BLOCKSIZE)
+        {
+            int count = qMin((int)RuleProgram::BLOCKSIZE, rows - row);
+
+            for (int v = 0; v < program.getVariableCount(); v++)
+                block[v] = columns[v] + row;
+
+            program.evaluateBlock(block, count, results);
+
+            for (int i = 0; i < count; i++)
+            {
+                int at = row + i;
+                record(times[at], at + 1 < rows ? times[at + 1] : times[at], results[i] != 0 && results[i] == results[i]);
+            }
+        }
+    }
+
+    m_samples = rows - first;
+
+    return true;
+}
+
+void RuleBacktest::record(qint64 time, qint64 next, bool satisfied)
+{
+    /* Fire on the rising edge, as sendAlert. An evaluation that is satisfied counts until the next one */
+
+    if (satisfied && !m_satisfied)
+        m_fireTimes.append(time);
+
+    if (satisfied)
+        m_satisfiedTime += next - time;
+
+    m_satisfied = satisfied;
+}
+
+int RuleBacktest::getFireCount() const
+{
+    return m_fireTimes.size();
+}
+
+QVector<qint64> RuleBacktest::getFireTimes() const
+{
+    /* When the rule fired, in milliseconds from the start of the session */
+    return m_fireTimes;
+}
+
+qint64 RuleBacktest::getSatisfiedTime() const
+{
+    /* How long the rule was satisfied in all, in milliseconds */
+    return m_satisfiedTime;
+}
+
+int RuleBacktest::getSamples() const
+{
+    /* The number of rows the rule was evaluated for */
+    return m_samples;
+}
+
+QString RuleBacktest::getError() const
+{
+    return m_error;
+}
@@ -0,0 +1,79 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef RULEBACKTEST_H
+#define RULEBACKTEST_H
+
+#include <QString>
+#include <QVector>
+
+#include "ruleprogram.h"
+#include "sensorhistory.h"
+
+namespace AutomonKernel
+{
+    /*
+        A RuleBacktest runs a rule over a recorded SensorHistory to show how often it would have fired. The
+        rule fires as a live rule alerts: when it becomes satisfied, once every sensor in it has a value. The
+        history is evaluated in blocks of RuleProgram::BLOCKSIZE rows with RuleProgram::evaluateBlock(), so
+        hours of driving take milliseconds. Rules with temporal operators depend on the order of the samples
+        and are evaluated a row at a time instead. As the RuleEngine's timer does, they are also evaluated every
+        RuleProgram::TEMPORALINTERVAL between rows with the values held, so eg: for(s010C > 4000, 5) fires on a
+        steady RPM that was only recorded once.
+    */
+
+    class RuleBacktest
+    {
+    public:
+        RuleBacktest();
+        bool run(const QString & rule, const SensorHistory & history);
+        bool run(const RuleProgram & program, const SensorHistory & history);
+        int getFireCount() const;
+        QVector<qint64> getFireTimes() const;
+        qint64 getSatisfiedTime() const;
+        int getSamples() const;
+        QString getError() const;
+
+    private:
+        void record(qint64 time, qint64 next, bool satisfied);
+
+        QVector<qint64> m_fireTimes;
+        qint64 m_satisfiedTime;
+        int m_samples;
+        bool m_satisfied;
+        QString m_error;
+    };
+}
+
+#endif // RULEBACKTEST_H
@@ -0,0 +1,170 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+RuleCatalogue::RuleCatalogue()
+    : m_nextId(1)
+{
+}
+
+RuleCatalogue::~RuleCatalogue()
+{
+    qDeleteAll(m_entries);
+}
+
+int RuleCatalogue::add(const QString & rule, const QString & englishName)
+{
+    /*
+        Parse the rule and add it with its English label. A rule that doesn't compile is still added, so it
+        can be shown and deleted, but it has no variables and its program isn't valid. Returns the rule's id.
+    */
+
+    int id = m_ids.value(rule, 0);
+
+    if (id == 0)
+    {
+        id = m_nextId++;
+        m_ids.insert(rule, id);
+    }
+
+    if (m_entries.contains(id))
+        return id;
+
+    Entry * entry = new Entry;
+    entry->rule = rule;
+    entry->englishName = englishName;
+    entry->program.compile(rule);
+
+    for (int v = 0; v < entry->program.getVariableCount(); v++)
+        entry->sensors.append(entry->program.getVariable(v));
+
+#ifdef DEBUGAUTOMON
+    if (!entry->program.isValid())
+        qDebug() << "Rule" << rule << "could not be compiled:" << entry->program.getError();
+#endif
+
+    m_entries.insert(id, entry);
+    m_order.append(id);
+    m_englishIds.insert(englishName, id);
+
+    return id;
+}
+
+bool RuleCatalogue::remove(int id)
+{
+    /* Take the rule out. Its id is kept for it, in case it comes back */
+
+    Entry * entry = m_entries.take(id);
+
+    if (entry == NULL)
+        return false;
+
+    m_order.removeOne(id);
+
+    if (m_englishIds.value(entry->englishName) == id)
+        m_englishIds.remove(entry->englishName);
+
+    delete entry;
+    return true;
+}
+
+void RuleCatalogue::clear()
+{
+    /* Remove all rules, ie: before loading the file again. The ids are kept */
+
+    qDeleteAll(m_entries);
+    m_entries.clear();
+    m_order.clear();
+    m_englishIds.clear();
+}
+
+int RuleCatalogue::size() const
+{
+    return m_order.size();
+}
+
+bool RuleCatalogue::contains(int id) const
+{
+    return m_entries.contains(id);
+}
+
+QList<int> RuleCatalogue::getIds() const
+{
+    return m_order;
+}
+
+int RuleCatalogue::findRule(const QString & rule) const
+{
+    /* The id of the rule string, -1 if it isn't in the catalogue */
+
+    int id = m_ids.value(rule, 0);
+    return m_entries.contains(id) ? id : -1;
+}
+
+int RuleCatalogue::findEnglishName(const QString & englishName) const
+{
+    /* The id of the rule with this English label, -1 if none has it */
+    return m_englishIds.value(englishName, -1);
+}
+
+QString RuleCatalogue::getRule(int id) const
+{
+    Entry * entry = m_entries.value(id);
+    return entry ? entry->rule : QString();
+}
+
+QString RuleCatalogue::getEnglishName(int id) const
+{
+    Entry * entry = m_entries.value(id);
+    return entry ? entry->englishName : QString();
+}
+
+QStringList RuleCatalogue::getSensors(int id) const
+{
+    /* The commands of the sensors the rule reads, ie: 010C, in the order they appear */
+
+    Entry * entry = m_entries.value(id);
+    return entry ? entry->sensors : QStringList();
+}
+
+const RuleProgram * RuleCatalogue::getProgram(int id) const
+{
+    /* The compiled rule, NULL if there's no such rule. Copy it to evaluate it, evaluating keeps state */
+
+    Entry * entry = m_entries.value(id);
+    return entry ? &entry->program : NULL;
+}
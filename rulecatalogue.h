@@ -0,0 +1,92 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef RULECATALOGUE_H
+#define RULECATALOGUE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+
+#include "ruleprogram.h"
+
+namespace AutomonKernel
+{
+    /*
+        The RuleCatalogue holds the rules of the rules file, each parsed once when the file is loaded: the rule
+        string, its English label, eg: "Engine RPM > 4000 AND Coolant Temperature < 40", the sensors it reads
+        and its compiled RuleProgram. Every rule has an id, so the UI and monitoring can refer to a rule by it
+        instead of comparing strings. Ids are stable: a rule keeps its id when the file is loaded again, and
+        no other rule gets it. Ids start at 1, so 0 is never a rule.
+    */
+
+    class RuleCatalogue
+    {
+    public:
+        RuleCatalogue();
+        ~RuleCatalogue();
+        int add(const QString & rule, const QString & englishName);
+        bool remove(int id);
+        void clear();
+        int size() const;
+        bool contains(int id) const;
+        QList<int> getIds() const;
+        int findRule(const QString & rule) const;
+        int findEnglishName(const QString & englishName) const;
+        QString getRule(int id) const;
+        QString getEnglishName(int id) const;
+        QStringList getSensors(int id) const;
+        const RuleProgram * getProgram(int id) const;
+
+    private:
+        Q_DISABLE_COPY(RuleCatalogue)
+
+        struct Entry
+        {
+            QString rule;
+            QString englishName;
+            QStringList sensors;
+            RuleProgram program;
+        };
+
+        QList<int> m_order;              /* The ids in the order of the file */
+        QHash<int, Entry*> m_entries;
+        QHash<QString, int> m_englishIds;
+        QHash<QString, int> m_ids;       /* Every rule seen this session, so it gets the same id when loaded again */
+        int m_nextId;
+    };
+}
+
+#endif // RULECATALOGUE_H
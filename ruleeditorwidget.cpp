@@ -37,6 +37,7 @@
 #include <QSlider>
 #include <QPushButton>
 #include <QTableWidget>
+#include <QMessageBox>
 
 #include "ruleeditorwidget.h"
 #include "sensor.h"
@@ -75,6 +76,7 @@ RuleEditorWidget::RuleEditorWidget(Automon * kernel, QWidget * parent)
     /* Create the create rule and delete rule push buttons */
     m_createRuleButton = new QPushButton(tr("Create Rule"));
     m_deleteRuleButton = new QPushButton(tr("Delete Rule"));
+    m_backtestRuleButton = new QPushButton(tr("Backtest Rule"));
 
     /* Populate the rules table with rules loaded from the rules file */
     updateRulesTable();
@@ -82,10 +84,12 @@ RuleEditorWidget::RuleEditorWidget(Automon * kernel, QWidget * parent)
     /* Connect the push buttons to their appropiate slots */
     connect(m_createRuleButton, SIGNAL(clicked()), this, SLOT(createRule()));
     connect(m_deleteRuleButton, SIGNAL(clicked()), this, SLOT(deleteRule()));
+    connect(m_backtestRuleButton, SIGNAL(clicked()), this, SLOT(backtestRule()));
 
     /* Set the width of the buttons */
     m_createRuleButton->setFixedWidth(200);
     m_deleteRuleButton->setFixedWidth(200);
+    m_backtestRuleButton->setFixedWidth(200);
 
     /* Create header label and set it's stylesheet and add to a layout manager */
     m_header = new QLabel(tr("Rule Editor"));
@@ -195,6 +199,7 @@ RuleEditorWidget::RuleEditorWidget(Automon * kernel, QWidget * parent)
     m_verticalLayout->addLayout(m_buttonLayout);
     m_buttonLayout->addWidget(m_createRuleButton);
     m_buttonLayout->addWidget(m_deleteRuleButton);
+    m_buttonLayout->addWidget(m_backtestRuleButton);
     m_buttonLayout->addStretch();
 
     m_verticalLayout->addLayout(m_ruleListLayout);
@@ -373,11 +378,10 @@ void RuleEditorWidget::deleteRule()
         return;
     }
 
-    /* Get the current rule selected. It will be in human readable format */
-    QString selectedRule = m_ruleListTable->currentItem()->data(Qt::DisplayRole).toString();
+    /* Get the id of the current rule selected, and remove the rule it belongs to */
+    int selectedRule = m_ruleListTable->currentItem()->data(Qt::UserRole).toInt();
 
-    /* Remove the rule using the kernel's method for removing by human readable format */
-    m_kernel->removeRuleEnglishMeaningString(selectedRule);
+    m_kernel->removeRuleString(m_kernel->getRuleCatalogue().getRule(selectedRule));
 
     /* Save the rule list back to file */
     m_kernel->saveRuleList();
@@ -392,6 +396,62 @@ void RuleEditorWidget::deleteRule()
     emit changeStatus("Rule Successfully Removed!");
 }
 
+void RuleEditorWidget::backtestRule()
+{
+    /*
+        This slot is called when the user clicks the backtest rule button.
+        It runs the selected rule over the sensor values recorded the last time monitoring ran,
+        and shows how often the rule would have fired
+    */
+
+    if (m_ruleListTable->currentItem() == NULL)
+    {
+        /* No rule was selected in the rule table */
+        emit changeStatus("No Rule Selected!");
+        return;
+    }
+
+    int selectedRule = m_ruleListTable->currentItem()->data(Qt::UserRole).toInt();
+    const RuleProgram * program = m_kernel->getRuleCatalogue().getProgram(selectedRule);
+
+    SensorHistory history;
+
+    if (!history.load(SESSIONFILE))
+    {
+        /* Nothing was recorded yet */
+        emit changeStatus(tr("No recorded session. Monitor the sensors in the rule first!"));
+        return;
+    }
+
+    RuleBacktest backtest;
+
+    if (program == NULL || !backtest.run(*program, history))
+    {
+        /* The rule uses sensors that weren't recorded, or didn't compile */
+        emit changeStatus(tr("Rule could not be backtested: ") + (program ? backtest.getError() : tr("Rule not found")));
+        return;
+    }
+
+    /* Summarise the result, with the first few times the rule fired into the session */
+    QString message = m_kernel->getRuleCatalogue().getEnglishName(selectedRule) + "\n\n";
+    message += tr("Fired ") + QString::number(backtest.getFireCount()) + tr(" times in ") + QString::number(history.getDuration() / 1000) + tr(" seconds recorded. ");
+    message += tr("Satisfied for ") + QString::number(backtest.getSatisfiedTime() / 1000) + tr(" seconds.");
+
+    QVector<qint64> fireTimes = backtest.getFireTimes();
+
+    for (int i = 0; i < fireTimes.size() && i < 10; i++)
+    {
+        qint64 seconds = (fireTimes.at(i) - history.timeAt(0)) / 1000;
+        message += (i ? ", " : tr("\n\nFirst fired at: ")) + QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+
+    QMessageBox result(QMessageBox::NoIcon, tr("Backtest Rule"), message, QMessageBox::Ok, 0, Qt::FramelessWindowHint);
+    result.setStyleSheet("background-color: rgba(51,51,51,80%); color:beige");
+    result.exec();
+
+    emit changeStatus(tr("Rule fired ") + QString::number(backtest.getFireCount()) + tr(" times in the recorded session"));
+}
+
 void RuleEditorWidget::updateRulesTable()
 {
     /*
@@ -401,8 +461,9 @@ void RuleEditorWidget::updateRulesTable()
     /* Reload the rules list from file so we have up to date rules list */
     m_kernel->loadRuleList();
 
-    /* Get the list of rules in a string list */
-    QStringList ruleList = m_kernel->getRuleList();
+    /* Get the ids of the rules, the catalogue has them parsed with their human readable format */
+    const RuleCatalogue & catalogue = m_kernel->getRuleCatalogue();
+    QList<int> ruleList = catalogue.getIds();
 
     /* Set the table properties */
     m_ruleListTable->setRowCount(ruleList.size());
@@ -421,7 +482,8 @@ void RuleEditorWidget::updateRulesTable()
     /* Insert each rule into the table, starting with the most up to date rule on top */
     for (int i = ruleList.size()-1; i >= 0; i--)
     {
-        QTableWidgetItem *ruleItem = new QTableWidgetItem(m_kernel->convertRuleToEnglish((ruleList.at(i))));
+        QTableWidgetItem *ruleItem = new QTableWidgetItem(catalogue.getEnglishName(ruleList.at(i)));
+        ruleItem->setData(Qt::UserRole, ruleList.at(i));
         ruleItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
         m_ruleListTable->setItem(ruleList.size()-1-i, 0, ruleItem);
     }
@@ -63,6 +63,7 @@ public slots:
     void changeSliderValuesSensor2(int index);
     void createRule();
     void deleteRule();
+    void backtestRule();
 
 private:
     void updateRulesTable();
@@ -86,6 +87,7 @@ private:
     QLCDNumber * m_sensor2ValueDisplay;
     QPushButton * m_createRuleButton;
     QPushButton * m_deleteRuleButton;
+    QPushButton * m_backtestRuleButton;
     QTableWidget * m_ruleListTable;
 
     Automon * m_kernel;
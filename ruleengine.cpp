@@ -0,0 +1,292 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+RuleEngine::RuleEngine(QObject * parent)
+    : QObject(parent), m_nextId(0)
+{
+    /* Temporal operators are given the time from a monotonic clock, so changing the system clock doesn't upset them */
+    m_clock.start();
+
+    m_temporalTimer.setInterval(TEMPORALINTERVAL);
+    connect(&m_temporalTimer, SIGNAL(timeout()), this, SLOT(evaluateTemporal()));
+}
+
+RuleEngine::~RuleEngine()
+{
+    qDeleteAll(m_rules);
+}
+
+int RuleEngine::addRule(const QString & rule, const QString & ruleName, const QList<Sensor*> & sensors)
+{
+    /* Compile the rule and add it. Returns the id of the rule, or -1 if it doesn't compile */
+
+    RuleProgram program(rule);
+
+    if (!program.isValid())
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "Rule" << rule << "could not be compiled:" << program.getError();
+#endif
+        return -1;
+    }
+
+    return addRule(program, ruleName, sensors);
+}
+
+int RuleEngine::addRule(const RuleProgram & program, const QString & ruleName, const QList<Sensor*> & sensors)
+{
+    /*
+        Add a copy of the compiled rule and bind each sensor in it to one of the given sensors by its command.
+        Returns the id of the rule, or -1 if it isn't valid or one of its sensors wasn't given.
+    */
+
+    if (!program.isValid())
+        return -1;
+
+    ActiveRule * activeRule = new ActiveRule;
+    activeRule->program = program;
+    activeRule->program.reset();
+    activeRule->name = ruleName;
+    activeRule->satisfied = false;
+
+    QList<Sensor*> bound;
+
+    for (int v = 0; v < activeRule->program.getVariableCount(); v++)
+    {
+        Sensor * sensor = NULL;
+
+        for (int i = 0; i < sensors.size() && sensor == NULL; i++)
+            if (sensors[i] != NULL && sensors[i]->getCommand().compare(activeRule->program.getVariable(v)) == 0)
+                sensor = sensors[i];
+
+        if (sensor == NULL)
+        {
+#ifdef DEBUGAUTOMON
+            qDebug() << "Rule" << program.getRule() << "uses the sensor" << activeRule->program.getVariable(v) << "which wasn't given";
+#endif
+            delete activeRule;
+            return -1;
+        }
+
+        bound.append(sensor);
+    }
+
+    /* All sensors are there, now put them in the value table and index the rule under each */
+    for (int v = 0; v < bound.size(); v++)
+    {
+        activeRule->inputs[v] = addInput(bound[v]);
+        m_dependents[activeRule->inputs[v]].append(activeRule);
+    }
+
+    int id = m_nextId++;
+    m_rules.insert(id, activeRule);
+
+    if (activeRule->program.isTemporal())
+    {
+        m_temporalRules.append(activeRule);
+        m_temporalTimer.start();
+    }
+
+    return id;
+}
+
+bool RuleEngine::removeRule(int id)
+{
+    /* Stop the rule. Sensors no other rule uses are dropped from the value table */
+
+    ActiveRule * rule = m_rules.take(id);
+
+    if (rule == NULL)
+        return false;
+
+    for (int v = 0; v < rule->program.getVariableCount(); v++)
+        releaseInput(rule->inputs[v], rule);
+
+    if (m_temporalRules.removeOne(rule) && m_temporalRules.isEmpty())
+        m_temporalTimer.stop();
+
+    delete rule;
+    return true;
+}
+
+void RuleEngine::clear()
+{
+    /* Stop all rules */
+
+    QList<int> ids = m_rules.keys();
+
+    for (int i = 0; i < ids.size(); i++)
+        removeRule(ids[i]);
+}
+
+QString RuleEngine::getRule(int id) const
+{
+    ActiveRule * rule = m_rules.value(id);
+    return rule ? rule->program.getRule() : QString();
+}
+
+QString RuleEngine::getRuleName(int id) const
+{
+    ActiveRule * rule = m_rules.value(id);
+    return rule ? rule->name : QString();
+}
+
+bool RuleEngine::isSatisfied(int id) const
+{
+    ActiveRule * rule = m_rules.value(id);
+    return rule ? rule->satisfied : false;
+}
+
+int RuleEngine::getRuleCount() const
+{
+    return m_rules.size();
+}
+
+QList<Sensor*> RuleEngine::getSensors() const
+{
+    /* The sensors read by the active rules */
+
+    QList<Sensor*> sensors;
+
+    for (int i = 0; i < m_inputs.size(); i++)
+        if (m_inputs[i] != NULL)
+            sensors.append(m_inputs[i]);
+
+    return sensors;
+}
+
+int RuleEngine::addInput(Sensor * sensor)
+{
+    /*
+        Find the sensor in the value table, or add it and connect to it. Each sensor is connected once, however
+        many rules read it. Its current value is taken, it may already be polled for someone else.
+    */
+
+    QHash<Sensor*, int>::const_iterator found = m_inputIndex.constFind(sensor);
+
+    if (found != m_inputIndex.constEnd())
+        return found.value();
+
+    /* Reuse an entry a removed sensor left behind */
+    int input = m_inputs.indexOf(NULL);
+
+    if (input == -1)
+    {
+        input = m_inputs.size();
+        m_inputs.append(NULL);
+        m_values.append(0);
+        m_dependents.append(QVector<ActiveRule*>());
+    }
+
+    m_inputs[input] = sensor;
+    m_values[input] = sensor->getResult();
+    m_inputIndex.insert(sensor, input);
+
+    connect(sensor, SIGNAL(changeOccurred(double)), this, SLOT(updateSensor(double)));
+
+    return input;
+}
+
+void RuleEngine::releaseInput(int input, ActiveRule * rule)
+{
+    /* Take the rule off the sensor's dependents. A sensor no rule depends on any more is disconnected */
+
+    m_dependents[input].remove(m_dependents[input].indexOf(rule));
+
+    if (!m_dependents[input].isEmpty())
+        return;
+
+    disconnect(m_inputs[input], SIGNAL(changeOccurred(double)), this, SLOT(updateSensor(double)));
+
+    m_inputIndex.remove(m_inputs[input]);
+    m_inputs[input] = NULL;
+}
+
+void RuleEngine::updateSensor(double value)
+{
+    /*
+        A sensor used by rules has a new value. Store it and evaluate only the rules that read the sensor.
+        The sensor could have been released while the value was queued, then it's ignored.
+    */
+
+    int input = m_inputIndex.value(static_cast<Sensor*>(QObject::sender()), -1);
+
+    if (input == -1)
+        return;
+
+    m_values[input] = value;
+
+    const QVector<ActiveRule*> & dependents = m_dependents[input];
+
+    for (int i = 0; i < dependents.size(); i++)
+        evaluate(dependents[i]);
+}
+
+void RuleEngine::evaluateTemporal()
+{
+    /* Time passed. Rules that look back in time may have changed even if none of their values did */
+
+    for (int i = 0; i < m_temporalRules.size(); i++)
+        evaluate(m_temporalRules[i]);
+}
+
+void RuleEngine::evaluate(ActiveRule * rule)
+{
+    /* Gather the rule's values from the table and run it. Alerts only when the rule becomes satisfied */
+
+    double values[RuleProgram::MAXVARIABLES];
+
+    for (int v = 0; v < rule->program.getVariableCount(); v++)
+    {
+        /* Ensure that all sensors have updated first, the same as Rule::checkIfSatisfied() */
+        if (m_inputs[rule->inputs[v]]->getChangeTimes() < 1)
+            return;
+
+        values[v] = m_values[rule->inputs[v]];
+    }
+
+    bool result = rule->program.isSatisfied(values, m_clock.elapsed());
+
+    if (result && !rule->satisfied)
+    {
+        rule->satisfied = true;
+        emit sendAlert(rule->name);
+    }
+    else if (!result)
+        rule->satisfied = false;
+}
@@ -0,0 +1,117 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef RULEENGINE_H
+#define RULEENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "sensor.h"
+#include "ruleprogram.h"
+
+namespace AutomonKernel
+{
+    /*
+        The RuleEngine runs all active rules of the kernel. Each rule is compiled into a RuleProgram once, and
+        the latest value of every sensor used by any rule is kept in one table. The engine connects to each
+        sensor once, however many rules use it, and keeps an index from each sensor to the rules that depend on
+        it, so a new value only re-evaluates the rules that read that sensor.
+
+        Alerts are edge triggered, as with Rule::sendAlert: a rule alerts when it becomes satisfied and can
+        only alert again after it stopped being satisfied. A rule is not evaluated until every sensor in it has
+        a value.
+
+        Rules with temporal operators, eg: for(s010C > 4000, 5), also depend on time passing. A value that
+        doesn't change isn't sent again, so these rules are evaluated every TEMPORALINTERVAL as well.
+    */
+
+    class RuleEngine : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        enum { TEMPORALINTERVAL = RuleProgram::TEMPORALINTERVAL }; /* Milliseconds, the backtest steps the same */
+
+        RuleEngine(QObject * parent = 0);
+        ~RuleEngine();
+        int addRule(const QString & rule, const QString & ruleName, const QList<Sensor*> & sensors);
+        int addRule(const RuleProgram & program, const QString & ruleName, const QList<Sensor*> & sensors);
+        bool removeRule(int id);
+        void clear();
+        QString getRule(int id) const;
+        QString getRuleName(int id) const;
+        bool isSatisfied(int id) const;
+        int getRuleCount() const;
+        QList<Sensor*> getSensors() const;
+
+    signals:
+        void sendAlert(QString); /* The name of the rule that became satisfied */
+
+    private slots:
+        void updateSensor(double value);
+        void evaluateTemporal();
+
+    private:
+        struct ActiveRule
+        {
+            RuleProgram program;
+            QString name;
+            int inputs[RuleProgram::MAXVARIABLES]; /* Where each variable of the program is in the value table */
+            bool satisfied;
+        };
+
+        int addInput(Sensor * sensor);
+        void releaseInput(int input, ActiveRule * rule);
+        void evaluate(ActiveRule * rule);
+
+        QHash<int, ActiveRule*> m_rules;
+        QList<ActiveRule*> m_temporalRules;
+        int m_nextId;
+        QElapsedTimer m_clock;
+        QTimer m_temporalTimer;
+
+        /* The value table, one entry per sensor used by any rule */
+        QHash<Sensor*, int> m_inputIndex;
+        QVector<Sensor*> m_inputs;
+        QVector<double> m_values;
+        QVector<QVector<ActiveRule*> > m_dependents;
+    };
+}
+
+#endif // RULEENGINE_H
@@ -0,0 +1,624 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "ruleprogram.h"
+
+/*
+    Like the HexDecoder this only includes its own header, so the benchmarks can build it without the rest of
+    Automon
+*/
+
+using namespace AutomonKernel;
+
+static inline bool isTrue(double value)
+{
+    /* As in the script, 0 and NaN are false */
+    return value != 0 && value == value;
+}
+
+static inline double truth(double value)
+{
+    /* isTrue() as 1 or 0 without a branch, for the block loops */
+    return (double)((value != 0) & (value == value));
+}
+
+/* Apply the operation over a block, a[i] = op(a[i], b[i]). Small enough loops for the compiler to vectorise */
+template <typename Operation>
+static inline void blockOperation(double * a, const double * b, int count, Operation operation)
+{
+    for (int i = 0; i < count; i++)
+        a[i] = operation(a[i], b[i]);
+}
+
+static inline bool isHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+RuleProgram::RuleProgram()
+    : m_size(0), m_pos(0), m_depth(0)
+{
+}
+
+RuleProgram::RuleProgram(const QString & rule)
+    : m_size(0), m_pos(0), m_depth(0)
+{
+    compile(rule);
+}
+
+bool RuleProgram::compile(const QString & rule)
+{
+    /*
+        Parse the rule into instructions. On an error the program is left empty and getError() says what was
+        wrong and where.
+    */
+
+    m_rule = rule;
+    m_error.clear();
+    m_variables.clear();
+    m_temporals.clear();
+    m_size = 0;
+    m_depth = 0;
+    m_pos = 0;
+    m_source = rule.toLatin1();
+
+    skipSpaces();
+
+    if (m_pos == m_source.size())
+        return fail("The rule is empty");
+
+    if (!parseOr())
+    {
+        m_size = 0;
+        return false;
+    }
+
+    if (m_pos != m_source.size())
+    {
+        fail("Unexpected \"" + QString(m_source.mid(m_pos, 8)) + "\"");
+        m_size = 0;
+        return false;
+    }
+
+    m_source.clear();
+    return true;
+}
+
+bool RuleProgram::isValid() const
+{
+    return m_size > 0;
+}
+
+QString RuleProgram::getRule() const
+{
+    return m_rule;
+}
+
+QString RuleProgram::getError() const
+{
+    return m_error;
+}
+
+int RuleProgram::getVariableCount() const
+{
+    return m_variables.size();
+}
+
+QString RuleProgram::getVariable(int index) const
+{
+    /* The sensor command of a variable, eg: 010C */
+    return m_variables.value(index);
+}
+
+int RuleProgram::indexOfVariable(const QString & command) const
+{
+    return m_variables.indexOf(command);
+}
+
+bool RuleProgram::isTemporal() const
+{
+    /* True if the rule looks back in time, then it should be evaluated now and again even if no value changed */
+    return !m_temporals.isEmpty();
+}
+
+double RuleProgram::evaluate(const double * values, qint64 time)
+{
+    /*
+        Run the program with the values of the variables, in the order of getVariable(), at the time in
+        milliseconds. The compiler made sure the stack never goes past MAXSTACK, so there are no checks in here.
+    */
+
+    double stack[MAXSTACK];
+    int top = -1;
+
+    for (int i = 0; i < m_size; i++)
+    {
+        const Instruction & instruction = m_code[i];
+
+        switch (instruction.opcode)
+        {
+        case Constant:      stack[++top] = instruction.constant; break;
+        case Variable:      stack[++top] = values[instruction.variable]; break;
+        case Negate:        stack[top] = -stack[top]; break;
+        case Not:           stack[top] = !isTrue(stack[top]); break;
+        case Add:           top--; stack[top] = stack[top] + stack[top+1]; break;
+        case Subtract:      top--; stack[top] = stack[top] - stack[top+1]; break;
+        case Multiply:      top--; stack[top] = stack[top] * stack[top+1]; break;
+        case Divide:        top--; stack[top] = stack[top] / stack[top+1]; break;
+        case Less:          top--; stack[top] = stack[top] < stack[top+1]; break;
+        case LessEqual:     top--; stack[top] = stack[top] <= stack[top+1]; break;
+        case Greater:       top--; stack[top] = stack[top] > stack[top+1]; break;
+        case GreaterEqual:  top--; stack[top] = stack[top] >= stack[top+1]; break;
+        case Equal:         top--; stack[top] = stack[top] == stack[top+1]; break;
+        case NotEqual:      top--; stack[top] = stack[top] != stack[top+1]; break;
+        case And:           top--; stack[top] = isTrue(stack[top]) && isTrue(stack[top+1]); break;
+        case Or:            top--; stack[top] = isTrue(stack[top]) || isTrue(stack[top+1]); break;
+
+        case For:
+        {
+            Temporal & temporal = m_temporals[instruction.variable];
+
+            if (!isTrue(stack[top]))
+                temporal.since = -1;
+            else if (temporal.since == -1)
+                temporal.since = time;
+
+            stack[top] = temporal.since != -1 && time - temporal.since >= instruction.constant;
+            break;
+        }
+
+        case Rate:
+        case Average:
+        case Minimum:
+        case Maximum:
+        {
+            SlidingWindow & window = m_temporals[instruction.variable].window;
+            window.add(time, stack[top]);
+
+            if (instruction.opcode == Rate)
+                stack[top] = window.rate();
+            else if (instruction.opcode == Average)
+                stack[top] = window.average();
+            else if (instruction.opcode == Minimum)
+                stack[top] = window.minimum();
+            else
+                stack[top] = window.maximum();
+            break;
+        }
+        }
+    }
+
+    return top == 0 ? stack[0] : 0;
+}
+
+bool RuleProgram::isSatisfied(const double * values, qint64 time)
+{
+    return isValid() && isTrue(evaluate(values, time));
+}
+
+bool RuleProgram::evaluateBlock(const double * const * columns, int count, double * results) const
+{
+    /*
+        Evaluate the rule for count samples, up to BLOCKSIZE, at once. columns[v] has the count values of
+        variable v. The results are as evaluate() gives them. Each stack entry is a block, so every instruction
+        is one loop over the samples. Temporal operators depend on the order of the samples, so a rule with
+        them can't be evaluated this way and false is returned.
+    */
+
+    if (!isValid() || isTemporal() || count < 0 || count > BLOCKSIZE)
+        return false;
+
+    double stack[MAXSTACK][BLOCKSIZE];
+    int top = -1;
+
+    for (int n = 0; n < m_size; n++)
+    {
+        const Instruction & instruction = m_code[n];
+        double * a = stack[top > 0 ? top - 1 : 0];
+        const double * b = stack[top > 0 ? top : 0];
+
+        switch (instruction.opcode)
+        {
+        case Constant:
+            top++;
+            for (int i = 0; i < count; i++)
+                stack[top][i] = instruction.constant;
+            break;
+
+        case Variable:
+            top++;
+            for (int i = 0; i < count; i++)
+                stack[top][i] = columns[instruction.variable][i];
+            break;
+
+        case Negate:
+            for (int i = 0; i < count; i++)
+                stack[top][i] = -stack[top][i];
+            break;
+
+        case Not:
+            for (int i = 0; i < count; i++)
+                stack[top][i] = 1 - truth(stack[top][i]);
+            break;
+
+        case Add:           blockOperation(a, b, count, [](double x, double y) { return x + y; }); top--; break;
+        case Subtract:      blockOperation(a, b, count, [](double x, double y) { return x - y; }); top--; break;
+        case Multiply:      blockOperation(a, b, count, [](double x, double y) { return x * y; }); top--; break;
+        case Divide:        blockOperation(a, b, count, [](double x, double y) { return x / y; }); top--; break;
+        case Less:          blockOperation(a, b, count, [](double x, double y) { return (double)(x < y); }); top--; break;
+        case LessEqual:     blockOperation(a, b, count, [](double x, double y) { return (double)(x <= y); }); top--; break;
+        case Greater:       blockOperation(a, b, count, [](double x, double y) { return (double)(x > y); }); top--; break;
+        case GreaterEqual:  blockOperation(a, b, count, [](double x, double y) { return (double)(x >= y); }); top--; break;
+        case Equal:         blockOperation(a, b, count, [](double x, double y) { return (double)(x == y); }); top--; break;
+        case NotEqual:      blockOperation(a, b, count, [](double x, double y) { return (double)(x != y); }); top--; break;
+        case And:           blockOperation(a, b, count, [](double x, double y) { return truth(x) * truth(y); }); top--; break;
+        case Or:            blockOperation(a, b, count, [](double x, double y) { return truth(truth(x) + truth(y)); }); top--; break;
+
+        default:
+            return false;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+        results[i] = stack[0][i];
+
+    return true;
+}
+
+void RuleProgram::reset()
+{
+    /* Forget the history of the temporal operators, ie: when starting again after a break */
+
+    for (int i = 0; i < m_temporals.size(); i++)
+    {
+        m_temporals[i].since = -1;
+        m_temporals[i].window.clear();
+    }
+}
+
+bool RuleProgram::parseOr()
+{
+    /* or := and { "||" and } */
+
+    if (!parseAnd())
+        return false;
+
+    while (accept("||"))
+        if (!parseAnd() || !append(Or))
+            return false;
+
+    return true;
+}
+
+bool RuleProgram::parseAnd()
+{
+    /* and := comparison { "&&" comparison } */
+
+    if (!parseComparison())
+        return false;
+
+    while (accept("&&"))
+        if (!parseComparison() || !append(And))
+            return false;
+
+    return true;
+}
+
+bool RuleProgram::parseComparison()
+{
+    /* comparison := sum [ ( "<=" | ">=" | "==" | "!=" | "<" | ">" ) sum ]. The two character ones go first */
+
+    if (!parseSum())
+        return false;
+
+    Opcode opcode;
+
+    if (accept("<="))
+        opcode = LessEqual;
+    else if (accept(">="))
+        opcode = GreaterEqual;
+    else if (accept("=="))
+        opcode = Equal;
+    else if (accept("!="))
+        opcode = NotEqual;
+    else if (accept("<"))
+        opcode = Less;
+    else if (accept(">"))
+        opcode = Greater;
+    else
+        return true;
+
+    return parseSum() && append(opcode);
+}
+
+bool RuleProgram::parseSum()
+{
+    /* sum := term { ( "+" | "-" ) term } */
+
+    if (!parseTerm())
+        return false;
+
+    for (;;)
+    {
+        if (accept("+"))
+        {
+            if (!parseTerm() || !append(Add))
+                return false;
+        }
+        else if (accept("-"))
+        {
+            if (!parseTerm() || !append(Subtract))
+                return false;
+        }
+        else
+            return true;
+    }
+}
+
+bool RuleProgram::parseTerm()
+{
+    /* term := unary { ( "*" | "/" ) unary } */
+
+    if (!parseUnary())
+        return false;
+
+    for (;;)
+    {
+        if (accept("*"))
+        {
+            if (!parseUnary() || !append(Multiply))
+                return false;
+        }
+        else if (accept("/"))
+        {
+            if (!parseUnary() || !append(Divide))
+                return false;
+        }
+        else
+            return true;
+    }
+}
+
+bool RuleProgram::parseUnary()
+{
+    /* unary := ( "-" | "!" ) unary | primary. != is a comparison, so ! only counts if no = follows */
+
+    if (accept("-"))
+        return parseUnary() && append(Negate);
+
+    if (m_pos + 1 < m_source.size() && m_source[m_pos] == '!' && m_source[m_pos+1] != '=')
+    {
+        accept("!");
+        return parseUnary() && append(Not);
+    }
+
+    return parsePrimary();
+}
+
+bool RuleProgram::parsePrimary()
+{
+    /* primary := sensor | number | temporal | "(" or ")" */
+
+    if (accept("("))
+    {
+        if (!parseOr())
+            return false;
+
+        if (!accept(")"))
+            return fail("Missing )");
+
+        return true;
+    }
+
+    if (m_pos < m_source.size() && m_source[m_pos] == 's')
+        return parseSensor();
+
+    if (m_pos < m_source.size() && m_source[m_pos] >= 'a' && m_source[m_pos] <= 'z')
+        return parseTemporal();
+
+    return parseNumber();
+}
+
+bool RuleProgram::parseTemporal()
+{
+    /* temporal := ( "for" | "rate" | "avg" | "min" | "max" ) "(" or "," seconds ")" */
+
+    Opcode opcode;
+
+    if (accept("for"))
+        opcode = For;
+    else if (accept("rate"))
+        opcode = Rate;
+    else if (accept("avg"))
+        opcode = Average;
+    else if (accept("min"))
+        opcode = Minimum;
+    else if (accept("max"))
+        opcode = Maximum;
+    else
+        return fail("Unknown function at \"" + QString(m_source.mid(m_pos, 8)) + "\"");
+
+    if (!accept("("))
+        return fail("Missing (");
+
+    if (!parseOr())
+        return false;
+
+    double seconds = 0;
+
+    if (!accept(",") || !scanNumber(seconds) || seconds <= 0)
+        return fail("Expected the window in seconds");
+
+    if (!accept(")"))
+        return fail("Missing )");
+
+    Temporal temporal;
+    temporal.since = -1;
+    temporal.window.setLength(qint64(seconds * 1000));
+    m_temporals.append(temporal);
+
+    return append(opcode, m_temporals.size() - 1, seconds * 1000);
+}
+
+bool RuleProgram::parseSensor()
+{
+    /* sensor := "s" 4 hex digits [ "_" digit ], eg: s010C or s0114_1 */
+
+    int start = m_pos + 1;
+    int end = start;
+
+    while (end < m_source.size() && end - start < 4 && isHexDigit(m_source[end]))
+        end++;
+
+    if (end - start != 4)
+        return fail("Expected a sensor like s010C at \"" + QString(m_source.mid(m_pos, 8)) + "\"");
+
+    if (end + 1 < m_source.size() && m_source[end] == '_' && m_source[end+1] >= '0' && m_source[end+1] <= '9')
+        end += 2;
+
+    QString command = QString::fromLatin1(m_source.constData() + start, end - start);
+    int variable = m_variables.indexOf(command);
+
+    if (variable == -1)
+    {
+        if (m_variables.size() == MAXVARIABLES)
+            return fail("More than " + QString::number((int)MAXVARIABLES) + " sensors in the rule");
+
+        variable = m_variables.size();
+        m_variables.append(command);
+    }
+
+    m_pos = end;
+    skipSpaces();
+
+    return append(Variable, variable);
+}
+
+bool RuleProgram::parseNumber()
+{
+    double value = 0;
+
+    if (!scanNumber(value))
+        return fail(m_pos == m_source.size() ? QString("Unexpected end of the rule")
+                                             : "Expected a number or sensor at \"" + QString(m_source.mid(m_pos, 8)) + "\"");
+
+    return append(Constant, 0, value);
+}
+
+bool RuleProgram::scanNumber(double & value)
+{
+    /* number := digits [ "." digits ] [ ( "e" | "E" ) [ sign ] digits ]. Converted by Qt, so the locale doesn't matter */
+
+    int start = m_pos;
+    int end = start;
+
+    while (end < m_source.size() && ((m_source[end] >= '0' && m_source[end] <= '9') || m_source[end] == '.'))
+        end++;
+
+    if (end < m_source.size() && end > start && (m_source[end] == 'e' || m_source[end] == 'E'))
+    {
+        end++;
+
+        if (end < m_source.size() && (m_source[end] == '+' || m_source[end] == '-'))
+            end++;
+
+        while (end < m_source.size() && m_source[end] >= '0' && m_source[end] <= '9')
+            end++;
+    }
+
+    bool ok = false;
+    value = m_source.mid(start, end - start).toDouble(&ok);
+
+    if (end == start || !ok)
+        return false;
+
+    m_pos = end;
+    skipSpaces();
+
+    return true;
+}
+
+bool RuleProgram::accept(const char * token)
+{
+    /* Take the token if the rule continues with it, and the spaces after it */
+
+    int length = qstrlen(token);
+
+    if (m_pos + length > m_source.size() || qstrncmp(m_source.constData() + m_pos, token, length) != 0)
+        return false;
+
+    m_pos += length;
+    skipSpaces();
+
+    return true;
+}
+
+void RuleProgram::skipSpaces()
+{
+    while (m_pos < m_source.size() && (m_source[m_pos] == ' ' || m_source[m_pos] == '\t'))
+        m_pos++;
+}
+
+bool RuleProgram::append(Opcode opcode, int variable, double constant)
+{
+    /* Add an instruction, keeping track of how deep the stack gets when it runs */
+
+    if (m_size == MAXINSTRUCTIONS)
+        return fail("The rule is too long");
+
+    if (opcode == Constant || opcode == Variable)
+    {
+        if (++m_depth > MAXSTACK)
+            return fail("The rule is nested too deep");
+    }
+    else if (opcode < For && opcode != Negate && opcode != Not)
+        m_depth--;
+
+    m_code[m_size].opcode = opcode;
+    m_code[m_size].variable = variable;
+    m_code[m_size].constant = constant;
+    m_size++;
+
+    return true;
+}
+
+bool RuleProgram::fail(const QString & error)
+{
+    /* Keep the first error, it's where the parse went wrong */
+
+    if (m_error.isEmpty())
+        m_error = error + " (at " + QString::number(m_pos + 1) + ")";
+
+    return false;
+}
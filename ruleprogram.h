@@ -0,0 +1,150 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef RULEPROGRAM_H
+#define RULEPROGRAM_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+
+#include "slidingwindow.h"
+
+namespace AutomonKernel
+{
+    /*
+        A RuleProgram is a rule, eg: "s010C > 4000 && s0105 < 40", compiled once into a small stack machine
+        program. Rules used to be evaluated by QtScript, which parsed the rule again for every sample. Here the
+        rule is parsed when it is compiled, and evaluating it runs the instructions over a fixed stack, without
+        allocating.
+
+        The grammar is what the rules file uses: sensors (sXXXX, or sXXXX_N for a channel), numbers, + - * /,
+        the comparisons < <= > >= == !=, && || and !, and brackets. Each sensor is a variable. The variables are
+        numbered in the order they first appear in the rule, and evaluate() takes their values in that order.
+        As in the script, a comparison is 1 or 0 and anything but 0 is true.
+
+        Rules can also look back in time, over a window given in seconds:
+
+            for(condition, seconds)     true once the condition has been true for that long, without a break
+            rate(expression, seconds)   change per second of the expression over the window
+            avg(expression, seconds)    average of the expression over the time of the window
+            min(expression, seconds)    smallest value of the expression in the window
+            max(expression, seconds)    biggest value of the expression in the window
+
+        eg: "for(s010C > 4000, 5) && s0105 < 40" or "rate(s0105, 10) > 2". The program keeps a SlidingWindow
+        for each of these, so each evaluation costs the same however long the windows are. The windows see the
+        values the rule is evaluated with, so evaluations have to be given the time, in milliseconds.
+
+        A rule without temporal operators can also be evaluated over a block of samples at once, with
+        evaluateBlock(). Each instruction then runs over the whole block in a plain loop the compiler can
+        vectorise, which is how recorded sessions are backtested.
+    */
+
+    class RuleProgram
+    {
+    public:
+        enum Opcode
+        {
+            Constant, Variable,
+            Negate, Not,
+            Add, Subtract, Multiply, Divide,
+            Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+            And, Or,
+            For, Rate, Average, Minimum, Maximum
+        };
+
+        enum { MAXINSTRUCTIONS = 128, MAXSTACK = 32, MAXVARIABLES = 16, BLOCKSIZE = 64 };
+        enum { TEMPORALINTERVAL = 250 }; /* ms between evaluations of a temporal rule whose values don't change */
+
+        RuleProgram();
+        RuleProgram(const QString & rule);
+        bool compile(const QString & rule);
+        bool isValid() const;
+        QString getRule() const;
+        QString getError() const;
+        int getVariableCount() const;
+        QString getVariable(int index) const;
+        int indexOfVariable(const QString & command) const;
+        bool isTemporal() const;
+        double evaluate(const double * values, qint64 time = 0);
+        bool isSatisfied(const double * values, qint64 time = 0);
+        bool evaluateBlock(const double * const * columns, int count, double * results) const;
+        void reset();
+
+    private:
+        struct Instruction
+        {
+            Opcode opcode;
+            int variable;    /* The variable, or the temporal state of a temporal operator */
+            double constant; /* The constant, or the window of a temporal operator in milliseconds */
+        };
+
+        struct Temporal
+        {
+            qint64 since; /* When the condition of a for() became true, -1 while it isn't */
+            SlidingWindow window;
+        };
+
+        bool parseOr();
+        bool parseAnd();
+        bool parseComparison();
+        bool parseSum();
+        bool parseTerm();
+        bool parseUnary();
+        bool parsePrimary();
+        bool parseTemporal();
+        bool parseSensor();
+        bool parseNumber();
+        bool scanNumber(double & value);
+        bool accept(const char * token);
+        void skipSpaces();
+        bool append(Opcode opcode, int variable = 0, double constant = 0);
+        bool fail(const QString & error);
+
+        Instruction m_code[MAXINSTRUCTIONS];
+        int m_size;
+        QStringList m_variables;
+        QVector<Temporal> m_temporals;
+        QString m_rule;
+        QString m_error;
+
+        /* Only used while compiling */
+        QByteArray m_source;
+        int m_pos;
+        int m_depth;
+    };
+}
+
+#endif // RULEPROGRAM_H
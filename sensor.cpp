@@ -30,66 +30,59 @@
     
 */
 
-#include <QRegExp>
-
 #include "automon.h"
 
 using namespace AutomonKernel;
 
-void Sensor::setFrequency(int frequency)
+void Sensor::setTargetRate(double rate)
 {
-    m_maxFrequency = frequency;
+    /*
+        Set how many times per second this sensor should be read from the ECU. The serial thread's scheduler
+        gives each sensor a deadline from this rate. A rate of 0 means read it as often as the bus allows.
+    */
+    m_targetRate = rate < 0 ? 0 : rate;
 }
 
-bool Sensor::isTurn()
+double Sensor::getTargetRate() const
 {
-    /*
-        This method is responsible for checking if it is time to give this sensor access to the ELM.
-        Depending on the frequency of the sensor, this method will determine how often it will get access.
-        For example, if frequency is 10Hz, then this will get called every round in the serial thread but only
-        every 10 times will it be given access to the ELM and processed. This saves on bandwidth. No point updating
-        coolant temperature every round when it changes slow relative to engine RPM for example.
-
-        This method also records the time period between each time it gets processes and gives an average update frequency
-        time
-    */
+    /* Return the requested rate in Hz. 0 means as fast as possible */
+    return m_targetRate;
+}
 
-    if (!m_lastTime)
-    {
-//        gettimeofday(&m_timeVal, NULL); // [LA]
-        m_lastTime = m_timeVal.tv_sec+(m_timeVal.tv_usec/1000000.0);
-    }
+void Sensor::setPriority(int priority)
+{
+    /* Higher priority sensors keep their rate when the bus can't keep up with every sensor */
+    m_priority = priority;
+}
 
-    if (m_currentFrequency == m_maxFrequency)
-    {
-        /* If in here, it is this sensor's turn to get access to the ELM.*/
+int Sensor::getPriority() const
+{
+    return m_priority;
+}
 
-        m_currentFrequency = 1; /* Reset the current frequency */
+void Sensor::recordRefresh(qint64 time)
+{
+    /*
+        This method is called by the scheduler each time this sensor was read from the ECU. The time is in
+        milliseconds on a monotonic clock so the rate isn't thrown off by the system clock changing.
+        It keeps an average of the achieved refresh rate so it can be compared against the target rate.
+    */
 
-        /* Get the time and do calculations to work out difference from last time */
-//        gettimeofday(&m_timeVal, NULL); // [LA]
-        double thisTime = m_timeVal.tv_sec+(m_timeVal.tv_usec/1000000.0);
-        m_instRefreshRate = 1/(thisTime - m_lastTime);
-        m_lastTime = thisTime;
+    if (m_lastRefresh >= 0 && time > m_lastRefresh)
+    {
+        double instRefreshRate = 1000.0 / (time - m_lastRefresh);
 
         if (!m_avgRefreshRate)
-            m_avgRefreshRate = m_instRefreshRate;
+            m_avgRefreshRate = instRefreshRate;
         else
-            m_avgRefreshRate = (m_instRefreshRate + m_avgRefreshRate)/2;
+            m_avgRefreshRate = (instRefreshRate + m_avgRefreshRate)/2;
 
 #ifdef DEBUGAUTOMON
-        qDebug("Avg Refresh Rate: %.6lf Hz", m_instRefreshRate);
+        qDebug("%s refresh rate: %.2lf Hz (target %.2lf Hz)", qPrintable(m_command), m_avgRefreshRate, m_targetRate);
 #endif
-
-        return true;
-    }
-    else
-    {
-        /* It is not our turn so increment the current frequency so we get closer to having a turn */
-        m_currentFrequency++;
     }
 
-    return false;
+    m_lastRefresh = time;
 }
 
 QString Sensor::getName()
@@ -110,77 +103,71 @@ float Sensor::getAvgRefreshRate()
     return m_avgRefreshRate;
 }
 
-void Sensor::validateSensorData(QString buffer)
+ResponseClassifier::Status Sensor::validateSensorData(QString buffer)
 {
     /*
-        This method is responsible for validating the buffer response from the ELM327
+        This method is responsible for validating the buffer response from the ELM327. Only data is any use
+        to the conversion formulas, NO DATA, BUS ERROR and the rest are reported back instead
     */
 
-    /* Take copy of the buffer */
-    QString data = buffer;
+    return ResponseClassifier::classify(buffer);
+}
 
-    /* Remove spaces and the line break character */
-    QRegExp removeSpaces( " " );
-    data.replace(QRegExp("[ \x0D]"), "");
+void Sensor::setBuffer(QString bufferResponse)
+{
+    /* This method is called by the serial I/O thread to set the returned bytes from ELM */
 
-    if (data.compare(QString("NODATA>")) == 0 || data.compare(QString("?>")) == 0)
-    {
-        /* The no data found message signifies that this sensor was not supported. We shouldn't get to this stage */
-#ifdef DEBUGAUTOMON
-        qDebug() << "Sending: " << getCommand() << " resulted in no data not found!";
-#endif
-        throw nodata_exception();
-    }
+    /* Only if response has changed from last response or if this is our first update (m_changeTimes = 0) */
+    if (bufferResponse.compare(m_bufferResponse) !=0 || m_changeTimes == 0)
+        applyResponse(bufferResponse, validateSensorData(bufferResponse));
+}
 
-    if (data.compare(QString("BUSERROR>")) == 0)
-    {
-        /* This occurs when communication breaks down between ELM and ECU */
-#ifdef DEBUGAUTOMON
-        qDebug() << "An error occured when communicating with the bus!";
-#endif
-        throw buserror_exception();
-    }
+void Sensor::setBuffer(QString bufferResponse, ResponseClassifier::Status status)
+{
+    /* Same as above, for a response the serial thread already classified. It isn't scanned a second time */
+
+    if (bufferResponse.compare(m_bufferResponse) !=0 || m_changeTimes == 0)
+        applyResponse(bufferResponse, status);
+}
+
+void Sensor::applyResponse(QString bufferResponse, ResponseClassifier::Status status)
+{
+    /* Take on a new response from the ELM327 */
 
-    if (data.contains(QRegExp("[^a-fA-F0-9 >\x0D]")))
+    m_lastStatus = status;
+
+    /* Data received was invalid, we choose to ignore it. this can happen easily */
+    if (m_lastStatus != ResponseClassifier::Ok)
     {
-        /*
-            If the data contains characters other than a-f, A-f or 0-9, ie: NOT HEX, (excl > and line break)
-            then response invalid */
 #ifdef DEBUGAUTOMON
-        qDebug() << data;
-        qDebug() << "The response from the ELM327 was not hexidecimal when it should have being";
+        qDebug() << "Sending: " << getCommand() << " resulted in " << ResponseClassifier::statusName(status);
 #endif
-        throw nothexdata_exception();
+        return;
     }
+
+    /* Now update the buffer to the response received from ELM */
+    m_bufferResponse = bufferResponse;
+
+    /* The set Result method is used to convert the result and look after signaling */
+    setResult();
 }
 
-void Sensor::setBuffer(QString bufferResponse)
+ResponseClassifier::Status Sensor::getLastStatus() const
 {
-    /* This method is called by the serial I/O thread to set the returned bytes from ELM */
+    /* What the last response that wasn't the same as the one before was, eg: NO DATA */
+    return m_lastStatus;
+}
 
-    if (bufferResponse.compare(m_bufferResponse) !=0 || m_changeTimes == 0)
-    {
-        /* Only if response has changed from last response or if this is our first update (m_changeTimes = 0) */
-
-       try
-       {
-           /* First validate the data, this will throw exception if data invalid */
-            validateSensorData(bufferResponse);
-
-            /* Now update the buffer to the response received from ELM */
-            m_bufferResponse = bufferResponse;
-
-            /* The set Result method is used to convert the result and look after signaling */
-            setResult();
-        }
-       catch (exception & e)
-       {
-           /* Data received was invalid, we choose to ignore it. this can happen easily */
-            qWarning() << "An exception occured when reading data from device so result won't be recorded";
-            qWarning() << "The exception was: " << e.what();
-       }
+Sensor * Sensor::getSource()
+{
+    /* The sensor to request from the ECU to get this one's value. Only channels are read through another */
+    return this;
+}
 
-    }
+QList<Sensor*> Sensor::getChannels() const
+{
+    /* Other values decoded from the same answer as this sensor, see SensorChannel */
+    return QList<Sensor*>();
 }
 
 int Sensor::getChangeTimes()
@@ -230,6 +217,10 @@ void Sensor::resetSensor()
 {
     /* Reset the change times. Important in some things like rules */
     m_changeTimes = 0;
+
+    /* Start the refresh rate average again for the next monitoring session */
+    m_avgRefreshRate = 0;
+    m_lastRefresh = -1;
 }
 
 Sensor::Sensor()
@@ -239,9 +230,12 @@ Sensor::Sensor()
     setExpectedBytes(0);
     setSupported(false);
     m_wasOutOfRange = false;
-    m_maxFrequency = 1;
-    m_currentFrequency = 1;
+    m_targetRate = 0;
+    m_priority = 0;
+    m_avgRefreshRate = 0;
+    m_lastRefresh = -1;
     m_changeTimes = 0;
+    m_lastStatus = ResponseClassifier::Ok;
 }
 
 
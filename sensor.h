@@ -35,6 +35,7 @@
 
 #include <QString>
 #include "command.h"
+#include "responseclassifier.h"
 
 class QVariant;
 
@@ -46,7 +47,7 @@ namespace AutomonKernel
 
     public:
         Sensor();
-        enum UNITS { MPH, RPM, DEGREES, PERCENTAGE, KPA, VOLTS, SECONDS, MINUTES, GS, NA };
+        enum UNITS { MPH, RPM, DEGREES, PERCENTAGE, KPA, VOLTS, SECONDS, MINUTES, GS, NA, KMH, KM, PA, RATIO, LPH, NM, COUNT, MA };
         virtual ~Sensor() {}
         virtual double convertResult();
         void setMax(double max);
@@ -55,10 +56,17 @@ namespace AutomonKernel
         double getMax();
         double getResult() const;
         void setUnits(UNITS resultUnits);
-        void setFrequency(int frequency);
-        bool isTurn();
+        void setTargetRate(double rate);
+        double getTargetRate() const;
+        void setPriority(int priority);
+        int getPriority() const;
+        void recordRefresh(qint64 time);
         float getAvgRefreshRate();
         virtual void setBuffer(QString bufferResponse);
+        void setBuffer(QString bufferResponse, ResponseClassifier::Status status);
+        ResponseClassifier::Status getLastStatus() const;
+        virtual Sensor * getSource();
+        virtual QList<Sensor*> getChannels() const;
         virtual void setResult();
         void setSupported(bool isSupported);
         bool isSupported();
@@ -81,15 +89,15 @@ namespace AutomonKernel
         QList<int> m_returnedBytes;
 
     private:
-        void validateSensorData(QString buffer);
+        ResponseClassifier::Status validateSensorData(QString buffer);
+        void applyResponse(QString bufferResponse, ResponseClassifier::Status status);
+        ResponseClassifier::Status m_lastStatus;
         bool m_isSupported;
-        int m_maxFrequency;
-        int m_currentFrequency;
+        double m_targetRate;
+        int m_priority;
         double m_avgRefreshRate;
-        double m_instRefreshRate;
-        double m_lastTime;
+        qint64 m_lastRefresh;
         int m_changeTimes;
-        timeval m_timeVal;
 
     };
 }
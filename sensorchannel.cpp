@@ -30,37 +30,40 @@
     
 */
 
+
+
 #include "automon.h"
 
 using namespace AutomonKernel;
 
-CommandedEgr::CommandedEgr(QString command, QString englishMeaning)
+SensorChannel::SensorChannel(Sensor * source, int channel, QString englishMeaning)
+    : m_source(source), m_channel(channel), m_value(0)
 {
-    /* Set the member variables */
-    m_command = command;
+    m_command = source->getCommand() + "_" + QString::number(channel);
     m_englishMeaning = englishMeaning;
 }
 
-CommandedEgr::CommandedEgr()
+Sensor * SensorChannel::getSource()
 {
-    /* Set properties of this sensor */
-    m_command = "012C";
-    m_englishMeaning = "Commanded EGR";
-    setUnits(MPH);
-    setExpectedBytes(1);
-    setMin(0);
-    setMax(100);
+    /* The sensor that is actually requested from the ECU */
+    return m_source;
 }
 
-
-double CommandedEgr::convertResult()
+int SensorChannel::getChannel() const
 {
-    /* This is the conversion formula. It basically returns the value from the bytes retrieved from the ECU */
-
-    QList<int> bytes = Automon::getBytes(*this);
+    return m_channel;
+}
 
-    double value = (bytes[2]*100/255);
+void SensorChannel::setValue(double value)
+{
+    /* Called by the source sensor with the value it decoded for this channel. Range checks and signals as usual */
 
-    return value;
+    m_value = value;
+    setResult();
+}
 
+double SensorChannel::convertResult()
+{
+    /* The source already did the conversion */
+    return m_value;
 }
@@ -30,22 +30,38 @@
     
 */
 
-#ifndef ENGINERUNTIMESENSOR_H
-#define ENGINERUNTIMESENSOR_H
 
-#include "sensor.h"
 
-class QVariant;
+#ifndef SENSORCHANNEL_H
+#define SENSORCHANNEL_H
+
+#include "sensor.h"
 
 namespace AutomonKernel
 {
-    class EngineRunTime : public Sensor
+    /*
+        A SensorChannel is a second value in the answer of another sensor, eg: the fuel trim that comes with
+        an O2 sensor voltage in PID 14. It is a sensor of its own, so it can be shown on a dial, used in rules
+        and logged the same as any other, but it is never requested itself. Its source sensor is polled and
+        hands it the value from the same answer. The command of a channel is the source's with the channel
+        number, eg: "0114_1", channel 0 being the source sensor itself.
+    */
+
+    class SensorChannel : public Sensor
     {
     public:
-        EngineRunTime(QString command, QString englishMeaning);
-        EngineRunTime();
+        SensorChannel(Sensor * source, int channel, QString englishMeaning);
+        ~SensorChannel() { }
+        Sensor * getSource();
+        int getChannel() const;
+        void setValue(double value);
         double convertResult();
-        ~EngineRunTime() { }
+
+    private:
+        Sensor * m_source;
+        int m_channel;
+        double m_value;
     };
 }
-#endif // ENGINERUNTIMESENSOR_H
+
+#endif // SENSORCHANNEL_H
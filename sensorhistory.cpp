@@ -0,0 +1,306 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "sensorhistory.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <limits>
+
+/*
+    Like the HexDecoder this only includes its own header, so the backtest tool can build it without the rest
+    of Automon
+*/
+
+using namespace AutomonKernel;
+
+static const double noValue = std::numeric_limits<double>::quiet_NaN();
+
+SensorHistory::SensorHistory()
+{
+}
+
+void SensorHistory::clear()
+{
+    m_names.clear();
+    m_times.clear();
+    m_columns.clear();
+}
+
+int SensorHistory::addColumn(const QString & command)
+{
+    /* Add a column for the sensor, or find the one it has. The rows so far have no value for it */
+
+    int column = m_names.indexOf(command);
+
+    if (column != -1)
+        return column;
+
+    m_names.append(command);
+    m_columns.append(QVector<double>(m_times.size(), noValue));
+
+    return m_columns.size() - 1;
+}
+
+int SensorHistory::indexOfColumn(const QString & command) const
+{
+    return m_names.indexOf(command);
+}
+
+int SensorHistory::getColumnCount() const
+{
+    return m_columns.size();
+}
+
+QString SensorHistory::getColumnName(int column) const
+{
+    /* The command of the sensor in the column, eg: 010C */
+    return m_names.value(column);
+}
+
+void SensorHistory::append(qint64 time, int column, double value)
+{
+    /*
+        The sensor in the column changed to value at time. A new row starts with the values of the last one.
+        Changes at the same time go in the same row. Times have to be in order.
+    */
+
+    if (m_times.isEmpty() || time > m_times.last())
+    {
+        m_times.append(time);
+
+        for (int i = 0; i < m_columns.size(); i++)
+            m_columns[i].append(m_columns[i].isEmpty() ? noValue : m_columns[i].last());
+    }
+
+    m_columns[column].last() = value;
+}
+
+int SensorHistory::size() const
+{
+    return m_times.size();
+}
+
+bool SensorHistory::isEmpty() const
+{
+    return m_times.isEmpty();
+}
+
+qint64 SensorHistory::timeAt(int row) const
+{
+    return m_times[row];
+}
+
+double SensorHistory::valueAt(int row, int column) const
+{
+    return m_columns[column][row];
+}
+
+const qint64 * SensorHistory::times() const
+{
+    return m_times.constData();
+}
+
+const double * SensorHistory::column(int column) const
+{
+    /* The values of the column, one for each row */
+    return m_columns[column].constData();
+}
+
+qint64 SensorHistory::getDuration() const
+{
+    return m_times.isEmpty() ? 0 : m_times.last() - m_times.first();
+}
+
+bool SensorHistory::save(const QString & fileName) const
+{
+    /* Write the history out as CSV */
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+
+    writeHeader(out);
+    writeRows(out, 0, m_times.size());
+
+    out.flush();
+    file.close();
+
+    return out.status() == QTextStream::Ok;
+}
+
+void SensorHistory::writeHeader(QTextStream & out) const
+{
+    /* The CSV header, "time" and the command of each column */
+
+    out << "time";
+
+    for (int i = 0; i < m_names.size(); i++)
+        out << "," << m_names[i];
+
+    out << "\n";
+}
+
+void SensorHistory::writeRows(QTextStream & out, int from, int to) const
+{
+    /* The rows from up to but not including to, as CSV lines */
+
+    for (int row = from; row < to; row++)
+    {
+        out << m_times[row];
+
+        for (int i = 0; i < m_columns.size(); i++)
+        {
+            out << ",";
+
+            /* NaN is the only value not equal to itself, it's written as nothing */
+            if (m_columns[i][row] == m_columns[i][row])
+                out << QString::number(m_columns[i][row], 'g', 12);
+        }
+
+        out << "\n";
+    }
+}
+
+void SensorHistory::removeRows(int count)
+{
+    /* Drop the first rows, eg: once they are written out. The columns stay */
+
+    count = qMin(count, m_times.size());
+
+    if (count <= 0)
+        return;
+
+    m_times.remove(0, count);
+
+    for (int i = 0; i < m_columns.size(); i++)
+        m_columns[i].remove(0, count);
+}
+
+bool SensorHistory::rewriteHeader(const QString & fileName) const
+{
+    /*
+        Give a file written with writeHeader() and writeRows() the columns this history has now, eg: after a
+        sensor got its first value. The rows in the file get an empty field for each new column. The file is
+        rewritten through a temporary one, so it is left as it was on an error
+    */
+
+    QFile in(fileName);
+    QFile out(fileName + ".tmp");
+
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Text) || !out.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream reader(&in);
+    QTextStream writer(&out);
+
+    /* One field per column after the time */
+    int added = m_names.size() - reader.readLine().count(QChar(','));
+
+    if (added < 0)
+        return false;
+
+    QString padding(added, QChar(','));
+
+    writeHeader(writer);
+
+    while (!reader.atEnd())
+    {
+        QString line = reader.readLine();
+
+        if (!line.isEmpty())
+            writer << line << padding << "\n";
+    }
+
+    writer.flush();
+    in.close();
+    out.close();
+
+    if (writer.status() != QTextStream::Ok)
+        return false;
+
+    return QFile::remove(fileName) && QFile::rename(fileName + ".tmp", fileName);
+}
+
+bool SensorHistory::load(const QString & fileName)
+{
+    /* Read a history saved with save(). On an error the history is left empty */
+
+    clear();
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QTextStream in(&file);
+    QStringList header = in.readLine().split(",");
+
+    if (header.isEmpty() || header[0] != "time")
+        return false;
+
+    for (int i = 1; i < header.size(); i++)
+        addColumn(header[i].trimmed());
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+
+        if (line.isEmpty())
+            continue;
+
+        QStringList fields = line.split(",");
+        bool ok = false;
+        qint64 time = fields[0].toLongLong(&ok);
+
+        if (!ok || fields.size() != m_columns.size() + 1 || (!m_times.isEmpty() && time <= m_times.last()))
+        {
+            clear();
+            return false;
+        }
+
+        m_times.append(time);
+
+        for (int i = 0; i < m_columns.size(); i++)
+        {
+            double value = fields[i + 1].toDouble(&ok);
+            m_columns[i].append(ok ? value : noValue);
+        }
+    }
+
+    return true;
+}
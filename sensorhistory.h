@@ -0,0 +1,93 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef SENSORHISTORY_H
+#define SENSORHISTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QTextStream>
+
+namespace AutomonKernel
+{
+    /*
+        A SensorHistory is the values of some sensors over a session, kept in columns so a rule can be run over
+        whole blocks of it at a time (see RuleBacktest). Each row is a time, in milliseconds from the start of
+        the session, with the value of every sensor at that time: a value holds until the sensor changes again.
+        Before a sensor's first value its column is NaN.
+
+        It is saved as CSV, a header of "time" and the sensor commands, then a line per row. An empty field is
+        a sensor without a value yet, eg:
+
+            time,010C,0105
+            0,812,
+            120,815,36
+
+        A history that is recorded for a long time can be written out a few rows at a time with writeRows(),
+        dropping the rows written with removeRows(). The last row is kept, the next row starts from its values.
+    */
+
+    class SensorHistory
+    {
+    public:
+        SensorHistory();
+        void clear();
+        int addColumn(const QString & command);
+        int indexOfColumn(const QString & command) const;
+        int getColumnCount() const;
+        QString getColumnName(int column) const;
+        void append(qint64 time, int column, double value);
+        int size() const;
+        bool isEmpty() const;
+        qint64 timeAt(int row) const;
+        double valueAt(int row, int column) const;
+        const qint64 * times() const;
+        const double * column(int column) const;
+        qint64 getDuration() const;
+        bool save(const QString & fileName) const;
+        bool load(const QString & fileName);
+        void writeHeader(QTextStream & out) const;
+        void writeRows(QTextStream & out, int from, int to) const;
+        void removeRows(int count);
+        bool rewriteHeader(const QString & fileName) const;
+
+    private:
+        QStringList m_names;
+        QVector<qint64> m_times;
+        QVector<QVector<double> > m_columns;
+    };
+}
+
+#endif // SENSORHISTORY_H
@@ -30,84 +30,423 @@
     
 */
 
-#include <QMutex>
 #include "automon.h"
-#ifndef Q_OS_ANDROID // [LA] Cross-compile to get this up and running
-#include <QSerialPortInfo>
-#endif
 
 using namespace AutomonKernel;
 
 SerialHelper::SerialHelper(QString port)
 {
-    /* Create a QSerialPort object passing in the parameters that the ELM327 communicates with */
-    m_connection = new QSerialPort(port);
-
-    // Override the default port, if it finds something connected to a different port [LA]
-    qDebug() << "**********Populating Serial Port(s)*************";
+    /*
+        Create the transport for the port. This is a serial port name as before, or a URI such as
+        tcp://192.168.0.10:35000 for a WiFi adapter. See transport.h for the schemes
+    */
+    m_transport = Transport::create(port);
 
-    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
-    {
-        qDebug() << "Name        : " << info.portName();
-        qDebug() << "Description : " << info.description();
-        qDebug() << "Product ID : "  << info.productIdentifier();
-        qDebug() << "Manufacturer: " << info.manufacturer();
+    setUp();
+}
 
-        if( info.manufacturer() == "FTDI")
-            m_connection->setPort(info);
-    }
+SerialHelper::SerialHelper(Transport * transport)
+{
+    /* Use a transport made by the caller. The SerialHelper takes ownership of it */
+    m_transport = transport;
 
+    setUp();
+}
 
-    int result = m_connection->open(QIODevice::ReadWrite);
-    if(result)
-    {
-        m_connection->setBaudRate(QSerialPort::Baud57600);
-        m_connection->setBaudRate(QSerialPort::Baud38400);
-        m_connection->setFlowControl(QSerialPort::NoFlowControl);
-        m_connection->setParity(QSerialPort::NoParity);
-        m_connection->setDataBits(QSerialPort::Data8);
-        m_connection->setStopBits(QSerialPort::OneStop);
-    //    m_connection->clear();
-    //        connect(m_connection, SIGNAL(readyRead()), this, SLOT(onDataReceived()));
-    //    m_connection->setTimeout(0,10);
-    }
-    /* m_stop is used to stop the monitoring thread running */
-    m_stop = true;
-    m_isMonitoring = false;
+void SerialHelper::setUp()
+{
+    /* Open the transport and start the serial thread. Shared by both constructors */
+
+    /* m_stop is used to stop the serial thread running. m_isMonitoring turns the sensor polling on and off */
+    m_stop.store(true);
+    m_isMonitoring.store(false);
+    m_ioMode = PollingIO;
+    m_clock.start();
+    m_responseCount.store(0);
+    m_monitoringStart.store(0);
+
+#ifdef REPEATLAST
+    m_repeatEnabled.store(true);
+#else
+    m_repeatEnabled.store(false);
+#endif
 
     /* Open a connection to the ELM327 */
-//    int result = m_connection->open(QSerialPort::ReadWrite);
+    bool result = m_transport->open();
 
     /* If could not connect, major problem! Throw exception */
     if (!result)
+    {
+        delete m_transport;
         throw serialio_exception();
+    }
+
+    /* The rate the ELM327 comes up at, and goes back to on ATZ */
+    m_defaultBaudRate = m_transport->getBaudRate();
 
 #ifdef DEBUGAUTOMON
+    qDebug() << "Successfully connected to" << m_transport->getUri();
+#endif
+
+#ifdef REACTORIO
+    /* Switch to the event driven I/O engine. If it is not available we just stay on the polling loop */
+    setIOMode(ReactorIO);
+#endif
+
+    /* From here on the serial thread owns the port. Commands and sensor reads all go through it */
+    startOwnerThread();
+}
+
+bool SerialHelper::setIOMode(IOMode mode)
+{
+    /*
+        This method switches between the polling loop and the event driven reactor. Both work on the same
+        adapter so the two can be compared. The reactor needs a transport with a file descriptor, otherwise
+        we stay on the polling loop. The mode can't change while sensors are being monitored.
+        The serial thread is stopped for the switch, anything queued meanwhile is sent once it is back.
+    */
 
-    if (result)
-        qDebug("Successfully Connected to Serial Port");
+    if (m_isMonitoring.load())
+        return false;
+
+    if (mode == m_ioMode)
+        return true;
+
+    bool wasRunning = isRunning();
+    bool switched = true;
+
+    stopOwnerThread();
+
+    if (mode == ReactorIO)
+    {
+        if (!SerialReactor::isAvailable() || !m_reactor.attach(m_transport))
+        {
+#ifdef DEBUGAUTOMON
+            qWarning() << "Can't use the serial reactor on" << m_transport->getUri() << ". Staying in polling mode";
+#endif
+            switched = false;
+        }
+    }
     else
-        qWarning("Serial Could not be opened");
+    {
+        /* The transport stays open, the serial thread just stops waiting on its descriptor */
+        m_reactor.detach();
+    }
+
+    if (switched)
+        m_ioMode = mode;
+
+    if (wasRunning)
+        startOwnerThread();
+
+    return switched;
+}
+
+int SerialHelper::negotiateBaudRate()
+{
+    /*
+        This method moves the link to the fastest baud rate the adapter and port both manage, using the ELM327's
+        ATBRD handshake. The rates are tried fastest first, so we end up on the highest one that works. Adapters
+        that don't know ATBRD, and transports without a baud rate, stay where they are. Like setIOMode(), this
+        stops the serial thread for the handshake. Returns the baud rate in use afterwards, 0 if there is none.
+    */
+
+    static const int rates[] = { 500000, 230400, 115200, 57600 };
+
+    if (m_isMonitoring.load() || m_transport->getBaudRate() <= 0)
+        return m_transport->getBaudRate();
+
+    bool wasRunning = isRunning();
+
+    stopOwnerThread();
 
+    for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        if (rates[i] <= m_transport->getBaudRate())
+            break;
+
+        BaudResult result = tryBaudRate(rates[i]);
+
+        if (result != BaudFailed)
+            break;
+    }
+
+    /* If the adapter was found by discovery, look for it at this rate next time in case it stays there */
+    AdapterDiscovery::remember(m_transport->getUri());
+
+    if (wasRunning)
+        startOwnerThread();
+
+    return m_transport->getBaudRate();
+}
+
+SerialHelper::BaudResult SerialHelper::tryBaudRate(int baudRate)
+{
+    /*
+        The ATBRD handshake. The ELM327 answers OK at the old rate, switches and sends its ID at the new rate.
+        If it gets a carriage return back within 75ms it keeps the new rate and prints the prompt, otherwise it
+        goes back to the old rate. ATBRD takes 4MHz divided by the baud rate.
+    */
+
+    int oldRate = m_transport->getBaudRate();
+    int divisor = qRound(4000000.0 / baudRate);
+    QByteArray reply;
+
+    clearReadBuffer();
+
+    QByteArray request = QString("ATBRD%1\x0D").arg(divisor, 2, 16, QChar('0')).toUpper().toLatin1();
+    m_transport->write(request.constData(), request.size());
+
+    /* Anything other than OK means the adapter doesn't do it, eg: clones that only understand ELM327 v1.0 */
+    if (!readUntil(reply, "OK", 1000))
+    {
+        readUntil(reply, ">", 500);
+        return reply.contains('?') ? BaudUnsupported : BaudFailed;
+    }
+
+    /* The ELM327 no longer remembers a request to repeat */
+    m_lastRequest.clear();
+
+    if (m_transport->setBaudRate(baudRate))
+    {
+        /* Wait for the ID at the new rate. If it comes through readable, confirm with a carriage return */
+        reply.clear();
+
+        if (readUntil(reply, "\x0D", 200) && reply.trimmed().size() > 0 && !reply.contains('\0'))
+        {
+            m_transport->write("\x0D", 1);
+
+            reply.clear();
+
+            if (readUntil(reply, ">", 500))
+            {
+#ifdef DEBUGAUTOMON
+                qDebug() << "Baud rate raised to" << baudRate;
 #endif
+                return BaudChanged;
+            }
+        }
+
+        m_transport->setBaudRate(oldRate);
+    }
+
+    /* The ELM327 goes back to the old rate by itself. Give it time to, then make sure it's with us */
+    msleep(200);
+    clearReadBuffer();
+
+    reply.clear();
+    m_transport->write("ATI\x0D", 4);
+
+    if (!readUntil(reply, ">", 500) && m_transport->setBaudRate(baudRate))
+    {
+        /* It took the new rate after all */
+        clearReadBuffer();
+        m_transport->write("ATI\x0D", 4);
+
+        reply.clear();
+
+        if (readUntil(reply, ">", 500))
+            return BaudChanged;
 
+        m_transport->setBaudRate(oldRate);
+    }
 
+    return BaudFailed;
+}
+
+void SerialHelper::restoreBaudRate()
+{
+    /*
+        The ELM327 keeps a rate from ATBRD until it is reset or power cycled. Reset it on the way out so it is back
+        on the rate it came up at, where the next start looks for it. Only called with the serial thread stopped
+    */
+
+    if (m_transport->getBaudRate() <= 0 || m_transport->getBaudRate() == m_defaultBaudRate || !m_transport->isOpen())
+        return;
+
+    clearReadBuffer();
+    m_transport->write("ATZ\x0D", 4);
+
+    /* Let the request go out before the port changes speed. The ELM327 answers at the old rate */
+    msleep(10);
+    m_transport->setBaudRate(m_defaultBaudRate);
+
+    QByteArray reply;
+    bool restored = readUntil(reply, ">", 1500);
+
+    if (restored)
+        AdapterDiscovery::remember(m_transport->getUri());
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Baud rate" << (restored ? "back to" : "could not be confirmed at") << m_defaultBaudRate;
+#else
+    Q_UNUSED(restored);
+#endif
+}
+
+bool SerialHelper::readUntil(QByteArray & data, const char * marker, int timeout)
+{
+    /* Read straight from the transport until the marker arrives. Only used while the serial thread is stopped */
+
+    QElapsedTimer timer;
+    char buffer[256];
+
+    timer.start();
+
+    while (!data.contains(marker))
+    {
+        qint64 bytes = m_transport->read(buffer, sizeof(buffer));
+
+        if (bytes < 0)
+            return false;
+
+        if (bytes > 0)
+            data.append(buffer, bytes);
+        else if (timer.elapsed() > timeout)
+            return false;
+        else
+            msleep(1);
+    }
+
+    return true;
+}
+
+int SerialHelper::getBaudRate() const
+{
+    /* The baud rate of the link to the ELM327, 0 if the transport has none */
+    return m_transport->getBaudRate();
+}
+
+SerialHelper::IOMode SerialHelper::getIOMode() const
+{
+    /* Return which I/O engine is in use */
+    return m_ioMode;
+}
+
+double SerialHelper::getReadsPerSecond() const
+{
+    /* The number of responses received per second since monitoring was last started. Called from the GUI thread */
+    qint64 elapsed = m_clock.elapsed() - m_monitoringStart.load();
+
+    if (elapsed <= 0)
+        return 0.0;
+
+    return m_responseCount.load() / (elapsed / 1000.0);
+}
+
+double SerialHelper::getAllocatedRate(Sensor * sensor) const
+{
+    /* The rate the scheduler gives the sensor, lower than its target rate when the bus can't keep up */
+    return m_scheduler.getAllocatedRate(sensor);
+}
+
+const ResponseClassifier & SerialHelper::getResponseStatistics() const
+{
+    /* How many of the polled responses were data, NO DATA, BUS ERROR and so on */
+    return m_responses;
+}
+
+void SerialHelper::setBatchingEnabled(bool enabled)
+{
+    /* Turn multi PID requests on or off. Only takes effect from the next polling cycle */
+    m_batcher.setEnabled(enabled);
+}
+
+bool SerialHelper::isBatchingEnabled() const
+{
+    /* Multi PID requests turn themselves off if the ECU rejects them */
+    return m_batcher.isEnabled();
+}
+
+void SerialHelper::setRepeatEnabled(bool enabled)
+{
+    /* Turn the repeat last request shortcut on or off. Only takes effect from the next request */
+    m_repeatEnabled.store(enabled);
+}
+
+bool SerialHelper::isRepeatEnabled() const
+{
+    /* The shortcut turns itself off if the adapter doesn't understand a bare carriage return */
+    return m_repeatEnabled.load();
+}
+
+QString SerialHelper::getTransportUri() const
+{
+    /* The URI of the transport the ELM327 is talked to over */
+    return m_transport->getUri();
+}
+
+bool SerialHelper::setRecordFile(QString fileName)
+{
+    /*
+        Record every request and response to fileName so the session can be played back later with a
+        replay:// transport. An empty name stops recording. Set this while the ELM327 is idle, eg: before init()
+    */
+
+    if (m_recordFile.isOpen())
+        m_recordFile.close();
+
+    if (fileName.isEmpty())
+        return true;
+
+    m_recordFile.setFileName(fileName);
+
+    return m_recordFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
 }
 
 void SerialHelper::setMonitoring(bool monitoring)
 {
-    /* Set the monitoring variable so we know the Serial thread running */
-    m_isMonitoring = monitoring;
+    /*
+        Turn the sensor polling in the serial thread on or off. Queued commands keep being sent either way.
+        Stopping lets the current polling round finish, the thread is never killed in the middle of a read.
+    */
+    m_isMonitoring.store(monitoring);
+
+    /* Wake the serial thread so it notices straight away */
+    m_wakeup.release();
+}
+
+void SerialHelper::startOwnerThread()
+{
+    /* Start the serial thread if it isn't running. Called from the thread that created the SerialHelper */
+
+    if (isRunning())
+        return;
+
+    m_stop.store(false);
+    start(QThread::TimeCriticalPriority);
+}
+
+void SerialHelper::stopOwnerThread()
+{
+    /* Ask the serial thread to finish and wait for it. Anything still queued stays queued */
+
+    if (!isRunning())
+        return;
+
+    m_stop.store(true);
+    m_wakeup.release();
+    wait();
 }
 
 SerialHelper::~SerialHelper()
 {
-    /* SerialHelper destructor. We have to clean up the serial connection object */
-    if(m_connection->isOpen())
-        m_connection->close();
+    /* SerialHelper destructor. Stop the serial thread first, then clean up the transport */
+    m_isMonitoring.store(false);
+    stopOwnerThread();
+
+    restoreBaudRate();
+
+    m_reactor.detach();
+
+    if (m_transport->isOpen())
+        m_transport->close();
+
+    if (m_recordFile.isOpen())
+        m_recordFile.close();
 
     /* Delete memory from heap */
-    delete m_connection;
+    delete m_transport;
 
 #ifdef DEBUGAUTOMON
     qDebug("Closed SerialHelper");
@@ -118,129 +457,425 @@ SerialHelper::~SerialHelper()
 void SerialHelper::clearReadBuffer()
 {
     /* Read any trash that's currently in the serial input buffer */
-    QString rubbish = m_connection->readAll();  /* Read Trash */
+    if (m_ioMode == ReactorIO)
+        m_reactor.discardInput();
+    else
+        m_transport->discardInput();  /* Read Trash */
 }
 
-void SerialHelper::run()
+bool SerialHelper::transact(QString request, char * buffer, int capacity, int & size, int timeout)
 {
-    /* This is the code that runs when the Serial thread started */
+    /*
+        Send a request to the ELM327 and gather the response into buffer until the prompt character arrives.
+        Returns false if the response did not complete within the timeout.
 
-    QTime t; /* Used for timeout purposes */
-    int i = 0;
-    QString command;
-    int bytes = 0;
-    int size = 0;
+        The ELM327 repeats the previous request when it gets a bare carriage return. When the same OBD request
+        goes out twice in a row, eg: one sensor polled on its own, only the carriage return is sent. This saves
+        transmitting and parsing the request on every poll, which counts at 38400 baud.
+    */
 
-    /* Temporary buffers */
-    char buffer[1024];
-    char tmpBuf[1024];
+    bool repeat = m_repeatEnabled.load() && request == m_lastRequest && !request.startsWith("AT", Qt::CaseInsensitive);
+    QString sent = repeat ? QString("\x0D") : request;
+
+    /*
+        ATZ would drop the ELM327 back to its default baud rate while we stay on the negotiated one. A warm start
+        resets the same things but keeps the baud rate
+    */
+    if (request.trimmed().toUpper() == "ATZ" && m_transport->getBaudRate() != m_defaultBaudRate)
+        sent = "ATWS\x0D";
 
-    m_stop = false;
-    m_isMonitoring = true;
+    bool complete = exchange(sent, buffer, capacity, size, timeout);
 
+    if (repeat && complete && Automon::cleanResponse(QString(buffer)).trimmed() == "?")
+    {
+        /* This adapter doesn't know the shortcut. Stop using it and send the full request */
 #ifdef DEBUGAUTOMON
-    qDebug("Started serial thread");
+        qWarning("Adapter does not repeat requests on a bare carriage return. Turning the shortcut off");
 #endif
+        m_repeatEnabled.store(false);
+        complete = exchange(request, buffer, capacity, size, timeout);
+    }
+
+    /* Only rely on the ELM327 remembering the request if it answered it in full */
+    m_lastRequest = complete ? request : QString();
+
+    /* A reset puts the ELM327 timeout back to its default */
+    QString trimmed = request.trimmed().toUpper();
+    if (trimmed == "ATZ" || trimmed == "ATD" || trimmed == "ATWS")
+        m_timeouts.elmReset();
+
+    if (m_recordFile.isOpen())
+    {
+        /* Record the exchange in the format the replay transport reads back, one line of response per entry */
+        QStringList lines = QString::fromLatin1(buffer, size).split("\x0D");
+
+        m_recordFile.write("> " + request.trimmed().toLatin1() + "\n");
+
+        for (int i = 0; i < lines.size() - 1; i++)
+            m_recordFile.write("< " + lines[i].toLatin1() + "\n");
+
+        m_recordFile.flush();
+    }
+
+    if (complete)
+        m_responseCount.ref();
+    else
+        clearReadBuffer(); /* Clear out all rubbish left in the input buffer */
+
+    return complete;
+}
+
+bool SerialHelper::exchange(QString request, char * buffer, int capacity, int & size, int timeout)
+{
+    /* Write the request to the transport as is and wait for the prompt character, using the current I/O engine */
 
-    while (!m_stop && m_activeSensors.size() > 0)
+    bool complete;
+
+    if (m_ioMode == ReactorIO)
     {
-        /* Iterate through each sensors, while there are sensors to monitor and we are not stopped */
+        if (!m_reactor.writeAll(request.toLatin1().constData(), request.length()))
+        {
+            size = 0;
+            buffer[0] = '\0';
+            return false;
+        }
 
-        t.start(); /* Start the clock */
+        complete = m_reactor.readUntilPrompt(buffer, capacity, size, timeout);
+    }
+    else
+    {
+        m_transport->write(request.toLatin1().constData(), request.length());
+        complete = pollUntilPrompt(buffer, capacity, size, timeout);
+    }
+
+    return complete;
+}
+
+bool SerialHelper::pollUntilPrompt(char * buffer, int capacity, int & size, int timeout)
+{
+    /* This is the original polling loop. It checks the transport every millisecond until the prompt arrives */
+
+    QTime t; /* Used for timeout purposes */
+    int bytes = 0;
+
+    size = 0;
+    buffer[0] = '\0';
 
-        if(m_activeSensors[i]->isTurn())
+    t.start(); /* Start the clock */
+
+    while(strchr(buffer, '>') == NULL)
+    {
+        /* Keep gathering bytes until we hit the prompt character at which point we know we're at end of response */
+        bytes = m_transport->bytesAvailable();
+
+        if (bytes > capacity - 1 - size)
+            bytes = capacity - 1 - size;
+
+        if (bytes > 0)
         {
-            /* Only process sensor if it is it's turn. (Frequency) */
+            /* Bytes available in input buffer, append them to previous response to build up full final response */
+            bytes = m_transport->read(buffer + size, bytes);
 
+            if (bytes > 0)
+                size += bytes;
+
+            buffer[size] = '\0';
+        }
+
+        if (size >= capacity - 1)
+            return true; /* Response filled the buffer, nothing more we can take */
+
+        if (t.elapsed() > timeout)
+        {
             /*
-                Each sensor can have an expected bytes interger assigned that gives the ELM327 a hint of how many bytes
-                to receive. This speeds up the waiting time from the ELM327
+                If we still receiving responses after the timeout or waiting on the prompt character, then
+                something wrong. Exit out of the loop to prevent hang
             */
-            int expectedBytes = m_activeSensors[i]->getExpectedBytes();
+#ifdef DEBUGAUTOMON
+            qDebug("Timeout!");
+#endif
+            return false;
+        }
 
-            /* Create the command to send to the ELM327 */
-            command = m_activeSensors[i]->getCommand() + " " + (!expectedBytes ? "" : QString::number(expectedBytes)) + "\x0D";
+        msleep(1); /* Insert a little sleep to prevent CPU utilization going up, (even tho Linux is pre emptive */
+    }
 
-            /* Send command to ELM327 */
-            m_connection->write(command.toLatin1(), command.length());
+    return true;
+}
 
-            /* Get the amount of bytes in the serial input buffer */
-            bytes = m_connection->bytesAvailable();
+void SerialHelper::run()
+{
+    /*
+        This is the code that runs when the Serial thread started. The serial thread is the only thread that
+        talks to the ELM327. Each time round the loop it first sends the one off commands waiting in the priority
+        lane, then reads the sensors that are due if monitoring. Background commands only get the bus when no
+        sensor is due. When there is nothing to do it sleeps until the next sensor deadline or until a command
+        is queued.
+    */
 
-            size = 0;
-            buffer[0] = '\0';
-            tmpBuf[0] = '\0';
+    bool polling = false;
+
+#ifdef DEBUGAUTOMON
+    qDebug("Started serial thread");
+#endif
+
+    while (!m_stop.load())
+    {
+        /* One off commands go ahead of the next polling round */
+        while (!m_stop.load() && runQueued(m_priorityLane))
+            ;
 
-            while(strchr(buffer, '>') == NULL)
+        int wait = -1; /* Wait for as long as it takes unless a sensor is coming due */
+
+        /* Take this round's copy of the active sensors. The GUI can add and remove sensors meanwhile */
+        QList<Sensor*> activeSensors = m_isMonitoring.load() ? m_activeSensors.snapshot() : QList<Sensor*>();
+
+        if (!activeSensors.isEmpty())
+        {
+            if (!polling)
             {
-                /* Keep gathering bytes until we hit the prompt character at which point we know we're at end of response */
-                bytes = m_connection->bytesAvailable();
+                /* Monitoring just started. Restart the read rate statistics, every sensor is due */
+                polling = true;
+                m_responseCount.store(0);
+                m_monitoringStart.store(m_clock.elapsed());
+                m_scheduler.start();
+            }
 
-                if (bytes > 0)
-                {
-                    /* Bytes available in input buffer */
-                    m_connection->read(tmpBuf, bytes);
+            /* Ask the scheduler for the sensors whose deadline has passed, earliest first */
+            m_scheduler.synchronise(activeSensors);
 
-                    buffer[size] = '\0';
-                    tmpBuf[bytes] = '\0';
+            QList<Sensor*> dueSensors = m_scheduler.takeDue(PidBatcher::MAXPIDS);
 
-                    /* Concatenate response to previous response to build up full final response */
-                    strcat(buffer,tmpBuf);
-                            size += bytes;
+            if (!dueSensors.isEmpty())
+            {
+                pollRound(dueSensors);
+                continue;
+            }
 
-                }
+            /* Nothing is due yet. Sleep until the next deadline, but wake up now and again in case sensors were added */
+            qint64 next = m_scheduler.timeUntilNextDeadline();
+            wait = next < 1 ? 1 : (next > 20 ? 20 : (int)next);
+        }
+        else if (polling)
+        {
+            polling = false;
 
-                if (t.elapsed() > 2500)
-                {
-                    /*
-                        If we still receiving responses after 2.5 secondsor waiting on the prompt character, then
-                        something wrong. Exit out of the loop to prevent hang
-                    */
 #ifdef DEBUGAUTOMON
-                    qDebug("Timeout!");
+            qDebug("Monitoring stopped. %.2f reads per second", getReadsPerSecond());
+            qDebug("Latency p50 %dms, p99 %dms, ELM327 timeout %dms", m_timeouts.getOverall().percentile(0.5),
+                   m_timeouts.getOverall().percentile(0.99), m_timeouts.getElmTimeout());
+
+            for (int i = 0; i < ResponseClassifier::STATUSES; i++)
+                qDebug("%s: %d", ResponseClassifier::statusName((ResponseClassifier::Status)i),
+                       m_responses.getCount((ResponseClassifier::Status)i));
 #endif
-                    /* Clear out all rubbish in the input buffer */
-                    QString rubbish = m_connection->readAll();  /* Read Trash */
+        }
 
-                    /* Skip out of this loop */
-                    goto timeout;
-                }
-                msleep(1); /* Insert a little sleep to prevent CPU utilization going up, (even tho Linux is pre emptive */
-            }
+        /* Background work gets the bus while no sensor is due */
+        if (runQueued(m_backgroundLane))
+            continue;
 
-        timeout:
+        /* Sleep until woken by a new command, a change in monitoring or the next deadline */
+        m_wakeup.tryAcquire(1, wait);
+    }
 
-            buffer[size] = '\0';
+#ifdef DEBUGAUTOMON
+    qDebug("Serial thread finished");
+#endif
+}
 
-            /* Set the returned response from ELM into the sensor's buffer. The sensor will look after rest such as
-               sending signal updates etc.
-            */
+void SerialHelper::pollRound(QList<Sensor*> & dueSensors)
+{
+    /* This method reads one round of due sensors and tells the scheduler how long the bus took */
 
-            m_activeSensors[i]->setBuffer(QString(buffer));
+    qint64 roundStart = m_scheduler.elapsed();
+    QList<Sensor*> polledSensors = dueSensors;
+
+    /* Bring the ELM327 timeout in line with how fast the ECU has been answering */
+    tuneElmTimeout();
+
+    /* Send as many of them as we can in multi PID requests. This takes the answered sensors out of the list */
+    if (m_batcher.isEnabled())
+        pollBatched(dueSensors);
+
+    /* Whatever is left gets requested on its own */
+    for (int i = 0; i < dueSensors.size() && !m_stop.load() && m_isMonitoring.load(); i++)
+        pollSensor(dueSensors[i]);
+
+    /* Give each sensor its next deadline and let the scheduler learn how long the bus took */
+    m_scheduler.completed(polledSensors, m_scheduler.elapsed() - roundStart);
 
 #ifdef DEBUGAUTOMON
-           qDebug() << "Received " << QString::number(m_activeSensors[i]->getBuffer().size()) << " Bytes";
+    qDebug("Time Elapsed :%d", (int)(m_scheduler.elapsed() - roundStart));
 #endif
+}
 
-            msleep(1);
+void SerialHelper::tuneElmTimeout()
+{
+    /*
+        Send ATST if the latency histograms call for a different ELM327 timeout. With a tight timeout a PID the
+        ECU is slow or silent on costs little more than a fast one, instead of 200ms every time it is polled
+    */
+
+    int units;
+
+    if (!m_timeouts.takeElmTimeoutChange(units))
+        return;
+
+    QStringList responses;
+    execute(QStringList(QString("ATST%1").arg(units, 2, 16, QChar('0')).toUpper()), responses, 1000);
 
 #ifdef DEBUGAUTOMON
-            qDebug("Time Elapsed :%d", t.elapsed());
+    qDebug("ELM327 timeout set to %dms", units * 4096 / 1000);
 #endif
+}
 
-        }
+bool SerialHelper::runQueued(CommandQueue & queue)
+{
+    /* Take the next request off the queue and send it. Returns false if the queue was empty */
+
+    QSharedPointer<CommandRequest> request = queue.dequeue();
+
+    if (request.isNull())
+        return false;
+
+    QStringList responses;
+    bool complete = execute(request->m_commands, responses, request->m_timeout);
 
-        /* Move on to next sensor */
-        if (i == m_activeSensors.size() - 1)
-            i = 0;
+    request->finish(responses, complete);
+    return true;
+}
+
+bool SerialHelper::execute(const QStringList & commands, QStringList & responses, int timeout)
+{
+    /*
+        Send each command to the ELM327 back to back and collect the raw responses.
+        Only ever called in the serial thread. Returns false if any of them timed out.
+    */
+
+    bool complete = true;
+    char buffer[1024];
+    int size = 0;
+
+    for (int i = 0; i < commands.size(); i++)
+    {
+        /* Throw away anything left over in the input buffer */
+        clearReadBuffer();
+
+        /* Send command and wait for the prompt character. Either we finish successfully or we time out */
+        if (!transact(commands[i] + "\x0D", buffer, sizeof(buffer), size, timeout))
+            complete = false;
+
+        responses.append(QString(buffer));
+    }
+
+    return complete;
+}
+
+void SerialHelper::pollSensor(Sensor * sensor)
+{
+    /* This method requests a single sensor's PID from the ELM327 and hands the response to the sensor */
+
+    int size = 0;
+    char buffer[1024];
+
+    /*
+        Each sensor can have the number of ECUs that answer it assigned. The ELM327 takes this as the number of
+        responses to wait for, so it answers as soon as the last one arrived instead of waiting for its timeout
+    */
+    int responseCount = sensor->getResponseCount();
+
+    /* Create the command to send to the ELM327 */
+    QString command = sensor->getCommand() + (!responseCount ? "" : " " + QString::number(responseCount, 16).toUpper()) + "\x0D";
+
+    /* Send command to ELM327 and wait for the prompt character. On timeout we get what arrived so far */
+    QElapsedTimer latency;
+    latency.start();
+
+    bool complete = transact(command, buffer, sizeof(buffer), size, m_timeouts.getReadTimeout(sensor->getCommand()));
+
+    ResponseClassifier::Status status = ResponseClassifier::classify(buffer, size);
+    m_responses.record(status);
+
+    m_timeouts.record(sensor->getCommand(), latency.elapsed(), TimeoutTuner::classify(complete, status));
+
+    /* Set the returned response from ELM into the sensor's buffer. The sensor will look after rest such as
+       sending signal updates etc.
+    */
+
+    sensor->setBuffer(QString(buffer), status);
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Received " << QString::number(sensor->getBuffer().size()) << " Bytes";
+#endif
+
+    /* The polling loop gives the CPU a break between sensors. The reactor already sleeps while waiting */
+    if (m_ioMode == PollingIO)
+        msleep(1);
+}
+
+void SerialHelper::pollBatched(QList<Sensor*> & sensors)
+{
+    /*
+        This method sends the batchable sensors in groups of up to six PIDs per request. Sensors that get
+        their answer are removed from the list. Sensors the ECU didn't answer stay in it.
+    */
+
+    QList<Sensor*> remaining;
+    QList<Sensor*> group;
+    int size = 0;
+    char buffer[1024];
+
+    for (int i = 0; i < sensors.size(); i++)
+    {
+        if (PidBatcher::canBatch(sensors[i]))
+            group.append(sensors[i]);
         else
-            i++;
+            remaining.append(sensors[i]);
+
+        if (group.size() == PidBatcher::MAXPIDS || (i == sensors.size() - 1 && group.size() > 1))
+        {
+            /* A full group, or the last group with more than one sensor. Send it */
+            QString request = PidBatcher::buildRequest(group);
+            QElapsedTimer latency;
+            latency.start();
+
+            /* Every mix of PIDs is another request, so batches share one latency histogram */
+            int timeout = m_timeouts.getReadTimeout(TimeoutTuner::BATCHREQUEST);
+            bool complete = transact(request, buffer, sizeof(buffer), size, timeout);
+
+            ResponseClassifier::Status status = ResponseClassifier::classify(buffer, size);
+            m_responses.record(status);
+
+            m_timeouts.record(TimeoutTuner::BATCHREQUEST, latency.elapsed(), TimeoutTuner::classify(complete, status));
+
+            /* Split the response back into each sensor. Anything unanswered goes back for a single request */
+            m_batcher.dispatchResponse(group, buffer, size);
+            remaining += group;
+            group.clear();
+
+            if (m_ioMode == PollingIO)
+                msleep(1);
+
+            if (!m_batcher.isEnabled() || m_stop.load() || !m_isMonitoring.load())
+            {
+                /* The ECU rejected batching, so leave the rest to single requests */
+                for (int j = i + 1; j < sensors.size(); j++)
+                    remaining.append(sensors[j]);
+                break;
+            }
+        }
     }
+
+    /* A single leftover sensor isn't worth a batch */
+    remaining += group;
+
+    sensors = remaining;
 }
 
 void SerialHelper::removeAllActiveSensors()
 {
-    /* Clear all sensors from list */
+    /* Clear all sensors from list. The serial thread picks this up from its next round, no need to stop it */
     m_activeSensors.clear();
 }
 
@@ -248,121 +883,88 @@ bool SerialHelper::addActiveSensor(Sensor * sensor)
 {
     /*
         This method is reponsible for accepting a sensor pointer and adding it to the list of sensors
-        to monitor
+        to monitor. Can be called while monitoring, the sensor is polled from the next round
     */
 
 #ifdef DEBUGAUTOMON
     qDebug("Adding Realtime Sensor to Active Sensors");
 #endif
 
-    m_activeSensors << sensor;
+    m_activeSensors.add(sensor);
     return true;
 }
 
 bool SerialHelper::removeActiveSensorByCommand(QString command)
 {
-    /* This method allows one to remove a sensor from the monitoring list by specifying it's command/pid */
+    /*
+        This method allows one to remove a sensor from the monitoring list by specifying it's command/pid.
+        A round already in progress may still read it one last time
+    */
 
-    for (int i = 0; i < m_activeSensors.size(); i++)
-    {
-        if (command.compare(m_activeSensors.at(i)->getCommand()) == 0)
-        {
-            /* Found the sensor we looking for so remove it from list and exit */
-            m_activeSensors.removeAt(i);
-            return true;
-        }
-    }
-    
-    return false;
+    return m_activeSensors.removeByCommand(command);
 }
 
 bool SerialHelper::isMonitoring()
 {
     /* Return a bool to suggest if we monitoring or not */
-    return m_isMonitoring;
+    return m_isMonitoring.load();
 }
 
 bool SerialHelper::sendCommand(Command & command, int timeout)
 {
     /*
         This method allows one to send commands to the ELM327. It looks after updating the command object's buffer
-        to the response as well. I've included mutex's so incase multiple threads use this, they get blocked as only
-        one thread can send a command at a time
+        to the response as well. The command goes on the priority lane of the serial thread and this method blocks
+        until it was answered. Because the serial thread slips it in between two polling rounds, this can be used
+        while monitoring. Use queueCommands() to not block at all.
     */
 
-    /* Create a lock for current thread */
-    m_mutexLock.lock();
+    QStringList commands(command.getCommand());
+    QStringList responses;
+    bool complete;
 
-    if (m_isMonitoring)
+    if (QThread::currentThread() == this)
     {
-        /* Cannot send a command if monitoring is active! */
-        monitoring_exception e;
-        throw e;
+        /* Already in the serial thread. Queueing would wait on ourself, so just send it */
+        complete = execute(commands, responses, timeout);
     }
-
-    QTime t;
-    QByteArray rubbish = m_connection->readAll();
-
-    /* Create command to send to ELM327 */
-    QString message = command.getCommand()+"\x0D";
-
-    /* Send command */
-    m_connection->write(message.toLatin1(),message.length());
-
-    /* Sleeep for a few ms to give chance for buffer to fill */
-    msleep(10);
-
-    char buffer[1024];
-    char tmpBuf[1024];
-    int size = 0;
-    int bytes = 0;
-
-    buffer[0] = '\0';
-    tmpBuf[0] = '\0';
-
-    t.start(); /* Start a clock so we can check if time out */
-
-    while(strchr(buffer, '>') == NULL)
+    else
     {
-        /* Keep looping until we hit the > character in which case we are at end of response */
-
-        bytes = m_connection->bytesAvailable();
+        CommandFuture future = queueCommands(commands, timeout);
+        future.waitForFinished();
 
-        if (bytes > 0)
-        {
-            /* Bytes available in input buffer of serial device so read them */
-            m_connection->read(tmpBuf, bytes);
+        complete = future.isComplete();
+        responses = future.getResponses();
+    }
 
-            buffer[size] = '\0';
-            tmpBuf[bytes] = '\0';
+    /* Set the command's buffer so the calling method can now read the response from ELM327 */
+    command.setBuffer(responses.isEmpty() ? QString("") : responses[0]);
 
-            /* Add this current buffer to previous to construct over all response */
-            strcat(buffer,tmpBuf);
-                    size += bytes;
-        }
-        else
-            msleep(1);
+    return complete;
+}
 
-        if (t.elapsed() > timeout)
-        {
-            /* If our clock has gone above the time out , then something wrong! Exit out of loop by doing jump */
-#ifdef DEBUGAUTOMON
-            qDebug() << "Timeout";
-#endif
-            goto timeout;
-        }
+CommandFuture SerialHelper::queueCommands(const QStringList & commands, int timeout, CommandRequest::Lane lane,
+                                          QObject * receiver, const char * member)
+{
+    /*
+        This method queues one or more commands for the serial thread and returns straight away. The commands are
+        sent back to back as a group, no sensor read happens in between. The returned future gives the responses.
+        If a receiver and slot name are given, the slot is also called with the responses, eg: "receiveResponses"
+        for a slot receiveResponses(QStringList). Safe to call from any thread.
+    */
 
-    }
+    QSharedPointer<CommandRequest> request(new CommandRequest(commands, timeout, lane));
 
-timeout:
-    /* Either we finished successfully or we timed out */
-    buffer[size] = '\0';
+    if (receiver)
+        request->setCallback(receiver, member);
 
-    /* Set the command's buffer so the calling method can now read the response from ELM327 */
-    command.setBuffer(QString(buffer));
+    if (lane == CommandRequest::PriorityLane)
+        m_priorityLane.enqueue(request);
+    else
+        m_backgroundLane.enqueue(request);
 
-    /* Unlock the mutex again so another thread can use this method */
-    m_mutexLock.unlock();
+    /* Wake the serial thread in case it is sleeping */
+    m_wakeup.release();
 
-    return true;
+    return CommandFuture(request);
 }
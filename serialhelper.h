@@ -34,43 +34,103 @@
 #define SERIALHELPER_H
 
 #include <QThread>
-#include <QMutex>
-#include <QtSerialPort/QSerialPort> // [LA]
-//#ifdef win32
-//    #include <QtSerialPort/QtSerialPort>
-//    #include <QtSerialPort/QSerialPortInfo>
-//#else
-//    #include
-//    #include "QtSerialPort/qserialportinfo.h"
-//#endif
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QFile>
 
 #include "sensor.h"
 #include "command.h"
+#include "transport.h"
+#include "serialreactor.h"
+#include "pidbatcher.h"
+#include "pidscheduler.h"
+#include "timeouttuner.h"
+#include "responseclassifier.h"
+#include "commandqueue.h"
+#include "activesensorset.h"
 
 namespace AutomonKernel
 {
     class SerialHelper : public QThread
     {
     public:
+        /*
+            PollingIO is the original loop that checks bytesAvailable() every millisecond.
+            ReactorIO waits on the port descriptor and wakes up as soon as the ELM327 answers
+        */
+        enum IOMode { PollingIO, ReactorIO };
+
         SerialHelper(QString port="/dev/ttyUSB0");
+        SerialHelper(Transport * transport);
         ~SerialHelper();
         void run();
         bool addActiveSensor(Sensor * sensor);
         bool removeActiveSensorByCommand(QString command);
         bool isMonitoring();
         bool sendCommand(Command & command, int timeout = 5000);
+        CommandFuture queueCommands(const QStringList & commands, int timeout = 5000,
+                                    CommandRequest::Lane lane = CommandRequest::PriorityLane,
+                                    QObject * receiver = 0, const char * member = 0);
         void clearReadBuffer();
         void setMonitoring(bool);
         void removeAllActiveSensors();
+        bool setIOMode(IOMode mode);
+        int negotiateBaudRate();
+        int getBaudRate() const;
+        IOMode getIOMode() const;
+        double getReadsPerSecond() const;
+        double getAllocatedRate(Sensor * sensor) const;
+        const ResponseClassifier & getResponseStatistics() const;
+        void setBatchingEnabled(bool enabled);
+        bool isBatchingEnabled() const;
+        void setRepeatEnabled(bool enabled);
+        bool isRepeatEnabled() const;
+        QString getTransportUri() const;
+        bool setRecordFile(QString fileName);
 
     private:
-        QSerialPort * m_connection;
-        QList<Sensor*> m_activeSensors;
-        bool m_isMonitoring;
+        enum BaudResult { BaudChanged, BaudFailed, BaudUnsupported };
+
+        void setUp();
+        BaudResult tryBaudRate(int baudRate);
+        void restoreBaudRate();
+        bool readUntil(QByteArray & data, const char * marker, int timeout);
+        void startOwnerThread();
+        void stopOwnerThread();
+        bool runQueued(CommandQueue & queue);
+        bool execute(const QStringList & commands, QStringList & responses, int timeout);
+        void pollRound(QList<Sensor*> & dueSensors);
+        void tuneElmTimeout();
+        bool transact(QString request, char * buffer, int capacity, int & size, int timeout);
+        bool exchange(QString request, char * buffer, int capacity, int & size, int timeout);
+        bool pollUntilPrompt(char * buffer, int capacity, int & size, int timeout);
+        void pollSensor(Sensor * sensor);
+        void pollBatched(QList<Sensor*> & sensors);
+
+        Transport * m_transport;
+        QFile m_recordFile;
+        SerialReactor m_reactor;
+        PidBatcher m_batcher;
+        PidScheduler m_scheduler;
+        TimeoutTuner m_timeouts;
+        ResponseClassifier m_responses;
+        CommandQueue m_priorityLane;
+        CommandQueue m_backgroundLane;
+        QSemaphore m_wakeup;
+        IOMode m_ioMode;
+        QString m_lastRequest;
+        int m_defaultBaudRate;
+        QElapsedTimer m_clock;                      /* Started once, only read afterwards */
+        QAtomicInt m_responseCount;                 /* Written in the serial thread, read from the GUI thread */
+        QAtomicInteger<qint64> m_monitoringStart;   /* ms on m_clock when monitoring last started */
+        ActiveSensorSet m_activeSensors;
+        QAtomicInt m_isMonitoring;  /* Flags set from the GUI thread and read in the serial thread */
+        QAtomicInt m_repeatEnabled;
         bool m_isPaused;
         bool m_pausedStarted;
-        bool m_stop;
-        QMutex m_mutexLock;
+        QAtomicInt m_stop;
 
 
 
@@ -0,0 +1,304 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
+using namespace AutomonKernel;
+
+SerialReactor::SerialReactor()
+{
+    /* Nothing is attached until attach() is called */
+    m_transport = NULL;
+    m_epoll = -1;
+    m_timer = -1;
+}
+
+SerialReactor::~SerialReactor()
+{
+    /* Release the epoll/timer descriptors. The transport belongs to the serial helper */
+    detach();
+}
+
+bool SerialReactor::isAvailable()
+{
+    /* The reactor depends on epoll and timerfd, so it is only available on Linux */
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+
+bool SerialReactor::attach(Transport * transport)
+{
+    /*
+        Start waiting on the transport's descriptor. The transport has to be open and non blocking.
+        Returns false if the transport has no descriptor, in which case the serial thread has to poll it
+    */
+
+    detach();
+
+    if (transport == NULL || transport->descriptor() < 0)
+        return false;
+
+    /* Create the epoll set and the timer used for response timeouts, and register both */
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (m_epoll < 0 || m_timer < 0)
+    {
+        detach();
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+
+    event.events = EPOLLIN;
+    event.data.fd = transport->descriptor();
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, transport->descriptor(), &event);
+
+    event.data.fd = m_timer;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_timer, &event);
+
+    m_transport = transport;
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Serial reactor attached to" << transport->getUri();
+#endif
+
+    return true;
+}
+
+void SerialReactor::detach()
+{
+    /* Close the epoll and timer descriptors. The transport stays open */
+    if (m_timer >= 0)
+        ::close(m_timer);
+
+    if (m_epoll >= 0)
+        ::close(m_epoll);
+
+    m_transport = NULL;
+    m_epoll = -1;
+    m_timer = -1;
+}
+
+bool SerialReactor::armTimer(int timeout)
+{
+    /* Arm the one shot timer. A timeout of 0 disarms it */
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    spec.it_value.tv_sec = timeout / 1000;
+    spec.it_value.tv_nsec = (timeout % 1000) * 1000000L;
+
+    return timerfd_settime(m_timer, 0, &spec, NULL) == 0;
+}
+
+bool SerialReactor::writeAll(const char * data, int length)
+{
+    /* Write the whole request. The transport is non blocking so wait for room if the kernel buffer is full */
+    int written = 0;
+
+    while (written < length)
+    {
+        qint64 result = m_transport->write(data + written, length - written);
+
+        if (result > 0)
+            written += result;
+        else if (result < 0)
+            return false;
+        else
+        {
+            struct pollfd writable;
+            writable.fd = m_transport->descriptor();
+            writable.events = POLLOUT;
+            poll(&writable, 1, 100);
+        }
+    }
+
+    return true;
+}
+
+bool SerialReactor::readUntilPrompt(char * buffer, int capacity, int & size, int timeout)
+{
+    /*
+        Block on the port until the ELM327 prompt character arrives or the timeout timer fires.
+        Returns false on timeout, or straight away if the port hung up or the connection closed, as
+        epoll would keep waking up for it. The buffer is always NULL terminated.
+    */
+
+    size = 0;
+    buffer[0] = '\0';
+
+    armTimer(timeout);
+
+    struct epoll_event events[2];
+
+    while (true)
+    {
+        int ready = epoll_wait(m_epoll, events, 2, -1);
+
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        bool timedOut = false;
+
+        for (int i = 0; i < ready; i++)
+        {
+            if (events[i].data.fd == m_timer)
+            {
+                /* Response timeout hit. Consume the expiration, the prompt may have come in the same wakeup */
+                quint64 expirations;
+                ssize_t consumed = ::read(m_timer, &expirations, sizeof(expirations));
+                Q_UNUSED(consumed);
+
+                timedOut = true;
+                continue;
+            }
+
+            /* Data available. Read everything there is without blocking */
+            qint64 bytes = 0;
+
+            while (size < capacity - 1 && (bytes = m_transport->read(buffer + size, capacity - 1 - size)) > 0)
+            {
+                bool prompt = (memchr(buffer + size, '>', bytes) != NULL);
+
+                size += bytes;
+                buffer[size] = '\0';
+
+                if (prompt)
+                {
+                    /* We have the full response. Disarm the timer so it doesn't fire during the next request */
+                    armTimer(0);
+                    return true;
+                }
+            }
+
+            if (size >= capacity - 1)
+            {
+                /* Response bigger than the buffer. Treat as complete so we don't spin */
+                armTimer(0);
+                return true;
+            }
+
+            /* The port hung up or the adapter closed the connection. No prompt will come */
+            if (bytes < 0 || (events[i].events & (EPOLLHUP | EPOLLERR)))
+            {
+#ifdef DEBUGAUTOMON
+                qDebug("Connection to the ELM327 lost!");
+#endif
+                armTimer(0);
+                return false;
+            }
+        }
+
+        if (timedOut)
+        {
+#ifdef DEBUGAUTOMON
+            qDebug("Timeout!");
+#endif
+            return false;
+        }
+    }
+
+    armTimer(0);
+    return false;
+}
+
+void SerialReactor::discardInput()
+{
+    /* Throw away anything waiting in the input queue, such as the tail of a timed out response */
+    m_transport->discardInput();
+}
+
+#else
+
+bool SerialReactor::attach(Transport * transport)
+{
+    Q_UNUSED(transport);
+    return false;
+}
+
+void SerialReactor::detach()
+{
+}
+
+bool SerialReactor::armTimer(int timeout)
+{
+    Q_UNUSED(timeout);
+    return false;
+}
+
+bool SerialReactor::writeAll(const char * data, int length)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(length);
+    return false;
+}
+
+bool SerialReactor::readUntilPrompt(char * buffer, int capacity, int & size, int timeout)
+{
+    Q_UNUSED(capacity);
+    Q_UNUSED(timeout);
+    size = 0;
+    buffer[0] = '\0';
+    return false;
+}
+
+void SerialReactor::discardInput()
+{
+}
+
+#endif
+
+bool SerialReactor::isAttached() const
+{
+    return m_transport != NULL;
+}
@@ -0,0 +1,285 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+using namespace AutomonKernel;
+
+SerialTransport::SerialTransport(QString port, bool setSpeed, int baudRate)
+    : m_port(port), m_setSpeed(setSpeed)
+{
+    m_descriptor = -1;
+    m_connection = NULL;
+    m_baudRate = baudRate;
+
+    /* The tty is opened by path, so make sure we have the full one */
+    if (!m_port.startsWith("/"))
+        m_port.prepend("/dev/");
+}
+
+SerialTransport::~SerialTransport()
+{
+    close();
+}
+
+QString SerialTransport::getUri() const
+{
+    /* The baud rate is only part of the URI if it isn't the usual one */
+    if (m_setSpeed && m_baudRate != 38400)
+        return QString("serial://%1?baud=%2").arg(m_port).arg(m_baudRate);
+
+    return "serial://" + m_port;
+}
+
+int SerialTransport::getBaudRate() const
+{
+    /* The rate the port is set to. A pseudo terminal has none */
+    return m_setSpeed ? m_baudRate : 0;
+}
+
+#ifdef Q_OS_LINUX
+
+bool SerialTransport::open()
+{
+    /*
+        Open the device directly so this thread is the only reader of it. The port is put into raw mode,
+        8N1 with no flow control, which is what the ELM327 communicates with
+    */
+
+    close();
+
+    m_descriptor = ::open(m_port.toLatin1().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (m_descriptor < 0)
+        return false;
+
+    struct termios settings;
+
+    if (tcgetattr(m_descriptor, &settings) != 0)
+    {
+        close();
+        return false;
+    }
+
+    cfmakeraw(&settings);
+    settings.c_cflag |= CLOCAL | CREAD;
+    settings.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+
+    if (tcsetattr(m_descriptor, TCSANOW, &settings) != 0 || (m_setSpeed && !setBaudRate(m_baudRate)))
+    {
+        close();
+        return false;
+    }
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Opened" << getUri();
+#endif
+
+    return true;
+}
+
+void SerialTransport::close()
+{
+    if (m_descriptor >= 0)
+        ::close(m_descriptor);
+
+    m_descriptor = -1;
+}
+
+bool SerialTransport::isOpen() const
+{
+    return m_descriptor >= 0;
+}
+
+int SerialTransport::descriptor() const
+{
+    return m_descriptor;
+}
+
+qint64 SerialTransport::bytesAvailable()
+{
+    int bytes = 0;
+
+    if (m_descriptor < 0 || ioctl(m_descriptor, FIONREAD, &bytes) != 0)
+        return 0;
+
+    return bytes;
+}
+
+qint64 SerialTransport::read(char * data, qint64 maxSize)
+{
+    /* Non blocking read. 0 if nothing is waiting */
+    ssize_t bytes = ::read(m_descriptor, data, maxSize);
+
+    if (bytes < 0)
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+    return bytes;
+}
+
+qint64 SerialTransport::write(const char * data, qint64 size)
+{
+    /* Non blocking write. 0 if the kernel buffer is full */
+    ssize_t bytes = ::write(m_descriptor, data, size);
+
+    if (bytes < 0)
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+    return bytes;
+}
+
+void SerialTransport::discardInput()
+{
+    /* Throw away anything waiting in the input queue, such as the tail of a timed out response */
+    tcflush(m_descriptor, TCIFLUSH);
+}
+
+bool SerialTransport::setBaudRate(int baudRate)
+{
+    /* Change the port speed straight away. Used after the ELM327 agreed to a new rate with ATBRD */
+
+    speed_t speed;
+
+    switch (baudRate)
+    {
+        case 9600: speed = B9600; break;
+        case 38400: speed = B38400; break;
+        case 57600: speed = B57600; break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        case 500000: speed = B500000; break;
+        default: return false;
+    }
+
+    struct termios settings;
+
+    if (!m_setSpeed || m_descriptor < 0 || tcgetattr(m_descriptor, &settings) != 0)
+        return false;
+
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+
+    if (tcsetattr(m_descriptor, TCSANOW, &settings) != 0)
+        return false;
+
+    m_baudRate = baudRate;
+    return true;
+}
+
+#else
+
+bool SerialTransport::open()
+{
+    /* Open the QSerialPort connection with the settings the ELM327 communicates with */
+
+    close();
+
+    m_connection = new QSerialPort(m_port);
+
+    if (!m_connection->open(QIODevice::ReadWrite))
+    {
+        close();
+        return false;
+    }
+
+    if (m_setSpeed)
+        m_connection->setBaudRate(m_baudRate);
+
+    m_connection->setFlowControl(QSerialPort::NoFlowControl);
+    m_connection->setParity(QSerialPort::NoParity);
+    m_connection->setDataBits(QSerialPort::Data8);
+    m_connection->setStopBits(QSerialPort::OneStop);
+
+    return true;
+}
+
+void SerialTransport::close()
+{
+    if (m_connection)
+    {
+        m_connection->close();
+        delete m_connection;
+    }
+
+    m_connection = NULL;
+}
+
+bool SerialTransport::isOpen() const
+{
+    return m_connection != NULL && m_connection->isOpen();
+}
+
+int SerialTransport::descriptor() const
+{
+    /* QSerialPort reads the port from its own notifier, so don't let the reactor wait on it */
+    return -1;
+}
+
+qint64 SerialTransport::bytesAvailable()
+{
+    return m_connection->bytesAvailable();
+}
+
+qint64 SerialTransport::read(char * data, qint64 maxSize)
+{
+    return m_connection->read(data, maxSize);
+}
+
+qint64 SerialTransport::write(const char * data, qint64 size)
+{
+    return m_connection->write(data, size);
+}
+
+void SerialTransport::discardInput()
+{
+    QByteArray rubbish = m_connection->readAll();  /* Read Trash */
+}
+
+bool SerialTransport::setBaudRate(int baudRate)
+{
+    if (!m_setSpeed || m_connection == NULL || !m_connection->setBaudRate(baudRate))
+        return false;
+
+    m_baudRate = baudRate;
+    return true;
+}
+
+#endif
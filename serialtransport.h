@@ -0,0 +1,80 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include <QString>
+
+#include "transport.h"
+
+class QSerialPort;
+
+namespace AutomonKernel
+{
+    /*
+        The SerialTransport talks to an ELM327 on a serial port, 8N1, no flow control. Most adapters come up at
+        38400 baud. Which port the adapter is on is worked out beforehand, see AdapterDiscovery.
+        On Linux the tty is opened directly in raw non blocking mode so the serial thread is its only reader
+        and the reactor can wait on it. Elsewhere QSerialPort is used and the serial thread polls it.
+    */
+
+    class SerialTransport : public Transport
+    {
+    public:
+        SerialTransport(QString port, bool setSpeed = true, int baudRate = 38400);
+        ~SerialTransport();
+        bool open();
+        void close();
+        bool isOpen() const;
+        int descriptor() const;
+        qint64 bytesAvailable();
+        qint64 read(char * data, qint64 maxSize);
+        qint64 write(const char * data, qint64 size);
+        void discardInput();
+        bool setBaudRate(int baudRate);
+        int getBaudRate() const;
+        QString getUri() const;
+
+    protected:
+        QString m_port;
+
+    private:
+        bool m_setSpeed;
+        int m_baudRate;
+        int m_descriptor;
+        QSerialPort * m_connection;
+    };
+}
+
+#endif // SERIALTRANSPORT_H
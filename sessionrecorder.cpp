@@ -0,0 +1,171 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+SessionRecorder::SessionRecorder(QObject * parent)
+    : QObject(parent), m_headerColumns(-1), m_rowsWritten(0), m_failed(false)
+{
+    m_flushTimer.setInterval(FLUSHINTERVAL);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+bool SessionRecorder::start(const QList<Sensor*> & sensors, const QString & fileName)
+{
+    /*
+        Start a new session in the file and record the sensors into it. The times are from now, on a monotonic
+        clock. Returns false if the file can't be written, nothing is recorded then
+    */
+
+    stop();
+
+    m_history.clear();
+    m_columns.clear();
+    m_headerColumns = -1;
+    m_rowsWritten = 0;
+    m_failed = false;
+
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    m_sensors = sensors;
+    m_clock.start();
+    m_flushTimer.start();
+
+    for (int i = 0; i < m_sensors.size(); i++)
+        connect(m_sensors[i], SIGNAL(changeOccurred(double)), this, SLOT(record(double)));
+
+    return true;
+}
+
+bool SessionRecorder::stop()
+{
+    /* Stop recording and write out the rest of the session. Returns false if any of it couldn't be written */
+
+    if (!isRecording())
+        return !m_failed;
+
+    for (int i = 0; i < m_sensors.size(); i++)
+        disconnect(m_sensors[i], SIGNAL(changeOccurred(double)), this, SLOT(record(double)));
+
+    m_sensors.clear();
+    m_flushTimer.stop();
+
+    writeRows(m_history.size());
+    m_file.close();
+
+    return !m_failed;
+}
+
+bool SessionRecorder::isRecording() const
+{
+    return !m_sensors.isEmpty();
+}
+
+int SessionRecorder::getRowCount() const
+{
+    /* The rows written to the file so far */
+    return m_rowsWritten;
+}
+
+void SessionRecorder::flush()
+{
+    /* Write out all but the last row, a sensor changing at the same time still goes into that one */
+    writeRows(m_history.size() - 1);
+}
+
+void SessionRecorder::writeRows(int count)
+{
+    /* Append the first rows of the history to the file and drop them. The header comes first, or is widened */
+
+    if (m_headerColumns != m_history.getColumnCount())
+    {
+        if (m_headerColumns == -1)
+        {
+            QTextStream out(&m_file);
+            m_history.writeHeader(out);
+        }
+        else
+        {
+            /* A sensor joined since the header was written */
+            m_file.close();
+
+            if (!m_history.rewriteHeader(m_file.fileName()))
+                m_failed = true;
+
+            m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+        }
+
+        m_headerColumns = m_history.getColumnCount();
+    }
+
+    if (count > 0)
+    {
+        QTextStream out(&m_file);
+        m_history.writeRows(out, 0, count);
+        out.flush();
+
+        if (out.status() != QTextStream::Ok)
+            m_failed = true;
+
+        m_history.removeRows(count);
+        m_rowsWritten += count;
+    }
+
+    m_file.flush();
+}
+
+void SessionRecorder::record(double value)
+{
+    /* A sensor changed. It gets a column with its first value */
+
+    Sensor * sensor = static_cast<Sensor*>(QObject::sender());
+    int column = m_columns.value(sensor, -1);
+
+    if (column < 0)
+    {
+        column = m_history.addColumn(sensor->getCommand());
+        m_columns.insert(sensor, column);
+    }
+
+    m_history.append(m_clock.elapsed(), column, value);
+
+    /* Don't wait for the timer if the sensors are changing very fast */
+    if (m_history.size() > MAXROWS)
+        flush();
+}
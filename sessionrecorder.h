@@ -0,0 +1,91 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFile>
+
+#include "sensor.h"
+#include "sensorhistory.h"
+
+namespace AutomonKernel
+{
+    /*
+        The SessionRecorder writes every value the given sensors send while it records to a CSV file, in the
+        format of SensorHistory, so rules can be backtested on real driving later. Only sensors that are polled
+        send values, the others don't get a column.
+
+        The values are kept in a SensorHistory and appended to the file every FLUSHINTERVAL, or sooner if
+        MAXROWS rows built up, so a long drive doesn't fill the memory and a crash only loses the last few
+        seconds. A sensor that gets its first value after rows were written has its column added to the file.
+    */
+
+    class SessionRecorder : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        SessionRecorder(QObject * parent = 0);
+        bool start(const QList<Sensor*> & sensors, const QString & fileName);
+        bool stop();
+        bool isRecording() const;
+        int getRowCount() const;
+
+        enum { FLUSHINTERVAL = 5000, MAXROWS = 1000 };
+
+    private slots:
+        void record(double value);
+        void flush();
+
+    private:
+        void writeRows(int count);
+
+        QElapsedTimer m_clock;
+        QTimer m_flushTimer;
+        QFile m_file;
+        SensorHistory m_history;
+        QList<Sensor*> m_sensors;
+        QHash<Sensor*, int> m_columns;
+        int m_headerColumns;    /* Columns in the header of the file, -1 until it is written */
+        int m_rowsWritten;
+        bool m_failed;          /* Something couldn't be written */
+    };
+}
+
+#endif // SESSIONRECORDER_H
@@ -0,0 +1,231 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "slidingwindow.h"
+
+/*
+    Like the HexDecoder this only includes its own header, so the benchmarks can build it without the rest of
+    Automon
+*/
+
+using namespace AutomonKernel;
+
+SlidingWindow::SlidingWindow(qint64 length)
+    : m_length(length), m_area(0), m_hasExpired(false)
+{
+}
+
+void SlidingWindow::setLength(qint64 length)
+{
+    /* The length in milliseconds. It takes effect when the next sample is added */
+    m_length = length;
+}
+
+qint64 SlidingWindow::getLength() const
+{
+    return m_length;
+}
+
+void SlidingWindow::add(qint64 time, double value)
+{
+    /* Add the sample, then drop the ones that are now longer ago than the window */
+
+    Sample sample;
+    sample.time = time;
+    sample.value = value;
+
+    /* The value before held until now */
+    if (!m_samples.isEmpty())
+        m_area += m_samples.back().value * (time - m_samples.back().time);
+
+    m_samples.pushBack(sample);
+
+    /* A sample bigger or equal to this one, and older, can never be the minimum again. The same for the maximum */
+    while (!m_minimums.isEmpty() && m_minimums.back().value >= value)
+        m_minimums.popBack();
+
+    m_minimums.pushBack(sample);
+
+    while (!m_maximums.isEmpty() && m_maximums.back().value <= value)
+        m_maximums.popBack();
+
+    m_maximums.pushBack(sample);
+
+    qint64 expired = time - m_length;
+
+    while (m_samples.size() > 1 && m_samples.front().time <= expired)
+    {
+        m_expired = m_samples.front();
+        m_hasExpired = true;
+        m_samples.popFront();
+
+        m_area -= m_expired.value * (m_samples.front().time - m_expired.time);
+    }
+
+    while (m_minimums.size() > 1 && m_minimums.front().time <= expired)
+        m_minimums.popFront();
+
+    while (m_maximums.size() > 1 && m_maximums.front().time <= expired)
+        m_maximums.popFront();
+
+    /* The running area drifts with rounding. Start it again when there is only the one sample */
+    if (m_samples.size() == 1)
+        m_area = 0;
+}
+
+void SlidingWindow::clear()
+{
+    m_samples.clear();
+    m_minimums.clear();
+    m_maximums.clear();
+    m_area = 0;
+    m_hasExpired = false;
+}
+
+bool SlidingWindow::isEmpty() const
+{
+    return m_samples.isEmpty();
+}
+
+int SlidingWindow::size() const
+{
+    return m_samples.size();
+}
+
+double SlidingWindow::average() const
+{
+    /*
+        The area under the values divided by the time they cover, up to the newest sample. The expired sample
+        covers the window from its start, or from its own time if the window was made longer since
+    */
+
+    if (m_samples.isEmpty())
+        return 0;
+
+    qint64 start = m_samples.front().time;
+    double area = m_area;
+
+    if (m_hasExpired)
+    {
+        start = qMax(m_expired.time, qMin(start, m_samples.back().time - m_length));
+        area += m_expired.value * (m_samples.front().time - start);
+    }
+
+    if (m_samples.back().time <= start)
+        return m_samples.back().value;
+
+    return area / (m_samples.back().time - start);
+}
+
+double SlidingWindow::minimum() const
+{
+    return m_minimums.isEmpty() ? 0 : m_minimums.front().value;
+}
+
+double SlidingWindow::maximum() const
+{
+    return m_maximums.isEmpty() ? 0 : m_maximums.front().value;
+}
+
+double SlidingWindow::rate() const
+{
+    /* The change per second from the oldest sample in the window to the newest. 0 until the samples are apart in time */
+
+    if (m_samples.size() < 2 || m_samples.back().time == m_samples.front().time)
+        return 0;
+
+    return (m_samples.back().value - m_samples.front().value) * 1000.0 / (m_samples.back().time - m_samples.front().time);
+}
+
+SlidingWindow::Queue::Queue()
+    : m_head(0), m_size(0)
+{
+}
+
+void SlidingWindow::Queue::pushBack(const Sample & sample)
+{
+    if (m_size == m_buffer.size())
+    {
+        /* Full. Unwrap it into a buffer twice the size */
+
+        QVector<Sample> buffer(qMax(16, m_buffer.size() * 2));
+
+        for (int i = 0; i < m_size; i++)
+            buffer[i] = m_buffer[(m_head + i) % m_buffer.size()];
+
+        m_buffer = buffer;
+        m_head = 0;
+    }
+
+    m_buffer[(m_head + m_size) % m_buffer.size()] = sample;
+    m_size++;
+}
+
+void SlidingWindow::Queue::popFront()
+{
+    m_head = (m_head + 1) % m_buffer.size();
+    m_size--;
+}
+
+void SlidingWindow::Queue::popBack()
+{
+    m_size--;
+}
+
+void SlidingWindow::Queue::clear()
+{
+    /* Keep the buffer, it is the right size for the window */
+    m_head = 0;
+    m_size = 0;
+}
+
+bool SlidingWindow::Queue::isEmpty() const
+{
+    return m_size == 0;
+}
+
+int SlidingWindow::Queue::size() const
+{
+    return m_size;
+}
+
+const SlidingWindow::Sample & SlidingWindow::Queue::front() const
+{
+    return m_buffer[m_head];
+}
+
+const SlidingWindow::Sample & SlidingWindow::Queue::back() const
+{
+    return m_buffer[(m_head + m_size - 1) % m_buffer.size()];
+}
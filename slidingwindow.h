@@ -0,0 +1,107 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef SLIDINGWINDOW_H
+#define SLIDINGWINDOW_H
+
+#include <QtGlobal>
+#include <QVector>
+
+namespace AutomonKernel
+{
+    /*
+        A SlidingWindow keeps the samples of the last so many milliseconds and gives their average, minimum,
+        maximum and rate of change. Adding a sample costs the same however long the window is: the area under
+        the values is kept running, and the minimum and maximum come from monotonic queues, which only hold the
+        samples that can still become the minimum or maximum once older ones expire. Samples have to be added in
+        time order. The newest sample is always kept, so a window is never empty once something was added.
+
+        The average is over time, not over samples. Each value holds until the next sample, so a value that
+        lasted 4 seconds counts for more than one that lasted 100ms, however often either was added. The last
+        sample that expired still covers the start of the window, up to the first sample in it.
+    */
+
+    class SlidingWindow
+    {
+    public:
+        SlidingWindow(qint64 length = 0);
+        void setLength(qint64 length);
+        qint64 getLength() const;
+        void add(qint64 time, double value);
+        void clear();
+        bool isEmpty() const;
+        int size() const;
+        double average() const;
+        double minimum() const;
+        double maximum() const;
+        double rate() const;
+
+    private:
+        struct Sample
+        {
+            qint64 time;
+            double value;
+        };
+
+        /* A ring buffer of samples that grows when full, so once it is big enough for the window nothing is allocated */
+        class Queue
+        {
+        public:
+            Queue();
+            void pushBack(const Sample & sample);
+            void popFront();
+            void popBack();
+            void clear();
+            bool isEmpty() const;
+            int size() const;
+            const Sample & front() const;
+            const Sample & back() const;
+
+        private:
+            QVector<Sample> m_buffer;
+            int m_head;
+            int m_size;
+        };
+
+        qint64 m_length;
+        double m_area;      /* Sum of value times duration between the samples in the window */
+        Sample m_expired;   /* The last sample that left the window, its value holds until the first in it */
+        bool m_hasExpired;
+        Queue m_samples;
+        Queue m_minimums;
+        Queue m_maximums;
+    };
+}
+
+#endif // SLIDINGWINDOW_H
@@ -0,0 +1,234 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+SubscriptionManager::SubscriptionManager(SerialHelper * serialHelper, QObject * parent)
+    : QObject(parent), m_serialHelper(serialHelper)
+{
+}
+
+int SubscriptionManager::indexOf(Sensor * sensor, QObject * subscriber) const
+{
+    /* Find where the subscriber is in the sensor's subscription list. -1 if not subscribed */
+
+    if (!m_subscriptions.contains(sensor))
+        return -1;
+
+    const QList<Subscription> & subscriptions = m_subscriptions[sensor];
+
+    for (int i = 0; i < subscriptions.size(); i++)
+        if (subscriptions[i].subscriber == subscriber)
+            return i;
+
+    return -1;
+}
+
+bool SubscriptionManager::subscribe(QObject * subscriber, Sensor * sensor, double rate, int priority)
+{
+    /*
+        Subscribe the receiver to the sensor. Subscribing again only changes the requested rate and priority.
+        The receiver has to have a display(double) slot, the same as with Automon::connectSensorToSlot
+    */
+
+    if (subscriber == NULL || sensor == NULL || !sensor->isSupported())
+        return false;
+
+    bool wasEmpty = !hasSubscriptions();
+    int index = indexOf(sensor, subscriber);
+
+    if (index == -1)
+    {
+        if (!connect(sensor, SIGNAL(changeOccurred(double)), subscriber, SLOT(display(double)), Qt::UniqueConnection))
+        {
+#ifdef DEBUGAUTOMON
+            qDebug() << "Could not connect the \"" << sensor->getCommand() << "\" sensor to the subscriber's display slot";
+#endif
+            return false;
+        }
+
+        /* Forget the subscriber's subscriptions if it is deleted without unsubscribing */
+        connect(subscriber, SIGNAL(destroyed(QObject*)), this, SLOT(subscriberDestroyed(QObject*)), Qt::UniqueConnection);
+
+        Subscription subscription;
+        subscription.subscriber = subscriber;
+        subscription.rate = rate;
+        subscription.priority = priority;
+        m_subscriptions[sensor].append(subscription);
+    }
+    else
+    {
+        m_subscriptions[sensor][index].rate = rate;
+        m_subscriptions[sensor][index].priority = priority;
+    }
+
+    updatePollSet(sensor);
+
+    if (wasEmpty)
+        emit pollSetChanged();
+
+    return true;
+}
+
+bool SubscriptionManager::unsubscribe(QObject * subscriber, Sensor * sensor)
+{
+    /* Take the receiver off the sensor. The sensor keeps being polled as long as anyone else is subscribed */
+
+    int index = indexOf(sensor, subscriber);
+
+    if (index == -1)
+        return false;
+
+    disconnect(sensor, SIGNAL(changeOccurred(double)), subscriber, SLOT(display(double)));
+    m_subscriptions[sensor].removeAt(index);
+
+    updatePollSet(sensor);
+
+    if (!hasSubscriptions())
+        emit pollSetChanged();
+
+    return true;
+}
+
+void SubscriptionManager::unsubscribeAll(QObject * subscriber)
+{
+    /* Take the receiver off every sensor it subscribed to */
+
+    QList<Sensor*> sensors = m_subscriptions.keys();
+
+    for (int i = 0; i < sensors.size(); i++)
+        unsubscribe(subscriber, sensors[i]);
+}
+
+void SubscriptionManager::subscriberDestroyed(QObject * subscriber)
+{
+    /*
+        A subscriber was deleted. Qt already dropped its signal connections, we only have to forget it.
+        It is being destroyed, so it can't be used for anything but comparing pointers.
+    */
+
+    QList<Sensor*> sensors = m_subscriptions.keys();
+    bool hadSubscriptions = hasSubscriptions();
+
+    for (int i = 0; i < sensors.size(); i++)
+    {
+        int index = indexOf(sensors[i], subscriber);
+
+        if (index != -1)
+        {
+            m_subscriptions[sensors[i]].removeAt(index);
+            updatePollSet(sensors[i]);
+        }
+    }
+
+    if (hadSubscriptions && !hasSubscriptions())
+        emit pollSetChanged();
+}
+
+bool SubscriptionManager::isSubscribed(QObject * subscriber, Sensor * sensor) const
+{
+    return indexOf(sensor, subscriber) != -1;
+}
+
+bool SubscriptionManager::isPolled(Sensor * sensor) const
+{
+    /* True if anyone is subscribed to the sensor or another channel of its source, so it is in the serial thread because of us */
+
+    QList<Sensor*> sensors = m_subscriptions.keys();
+
+    for (int i = 0; i < sensors.size(); i++)
+        if (sensors[i]->getSource() == sensor->getSource())
+            return true;
+
+    return false;
+}
+
+bool SubscriptionManager::hasSubscriptions() const
+{
+    return !m_subscriptions.isEmpty();
+}
+
+void SubscriptionManager::updatePollSet(Sensor * sensor)
+{
+    /*
+        Merge the subscriptions of the sensor into the one request the serial thread sees. The rate is the
+        highest requested, where 0 (as fast as possible) beats everything. The priority is also the highest.
+        What is polled is the sensor's source, so the subscriptions to all channels of the source are merged.
+        A source with no subscribers left is released. The owner of the serial thread decides if it stops being
+        polled, since it may have been added there directly as well.
+    */
+
+    if (m_subscriptions.value(sensor).isEmpty())
+        m_subscriptions.remove(sensor);
+
+    Sensor * source = sensor->getSource();
+    QList<Sensor*> sensors = m_subscriptions.keys();
+    QList<Subscription> subscriptions;
+
+    for (int i = 0; i < sensors.size(); i++)
+        if (sensors[i]->getSource() == source)
+            subscriptions += m_subscriptions[sensors[i]];
+
+    if (subscriptions.isEmpty())
+    {
+#ifdef DEBUGAUTOMON
+        qDebug() << "No subscribers left for" << source->getCommand() << ". Releasing it";
+#endif
+        emit sourceReleased(source);
+        return;
+    }
+
+    double rate = subscriptions[0].rate;
+    int priority = subscriptions[0].priority;
+
+    for (int i = 1; i < subscriptions.size(); i++)
+    {
+        if (rate > 0 && (subscriptions[i].rate <= 0 || subscriptions[i].rate > rate))
+            rate = subscriptions[i].rate;
+
+        if (subscriptions[i].priority > priority)
+            priority = subscriptions[i].priority;
+    }
+
+    source->setTargetRate(rate);
+    source->setPriority(priority);
+
+    /* Adding a sensor that is already in the serial thread does nothing */
+    m_serialHelper->addActiveSensor(source);
+
+#ifdef DEBUGAUTOMON
+    qDebug() << source->getCommand() << "polled for" << subscriptions.size() << "subscriber(s) at" << rate << "Hz";
+#endif
+}
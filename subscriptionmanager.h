@@ -0,0 +1,92 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+
+#include <QObject>
+#include <QMap>
+#include <QList>
+
+#include "sensor.h"
+#include "serialhelper.h"
+
+namespace AutomonKernel
+{
+    /*
+        The SubscriptionManager lets several consumers poll the same session. Each consumer subscribes to a
+        sensor with the rate it wants. The sensor is added to the serial thread once, at the highest rate any
+        subscriber asked for (0, as fast as possible, beats any rate), and each new value is fanned out to every
+        subscriber's display(double) slot through the sensor's changeOccurred signal. When the last subscriber
+        leaves, the sensor is released, and Automon takes it out of the serial thread unless it was also added
+        with Automon::addActiveSensor(). So the dashboard, a logger and the rules can all watch RPM and the ECU
+        is still only asked once.
+    */
+
+    class SubscriptionManager : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        SubscriptionManager(SerialHelper * serialHelper, QObject * parent = 0);
+        bool subscribe(QObject * subscriber, Sensor * sensor, double rate, int priority);
+        bool unsubscribe(QObject * subscriber, Sensor * sensor);
+        void unsubscribeAll(QObject * subscriber);
+        bool isSubscribed(QObject * subscriber, Sensor * sensor) const;
+        bool isPolled(Sensor * sensor) const;
+        bool hasSubscriptions() const;
+
+    signals:
+        void pollSetChanged(); /* Emitted when the first sensor was subscribed to or the last one released */
+        void sourceReleased(Sensor * source); /* Emitted when the last subscriber to a source's channels left */
+
+    private slots:
+        void subscriberDestroyed(QObject * subscriber);
+
+    private:
+        struct Subscription
+        {
+            QObject * subscriber;
+            double rate;
+            int priority;
+        };
+
+        void updatePollSet(Sensor * sensor);
+        int indexOf(Sensor * sensor, QObject * subscriber) const;
+
+        QMap<Sensor*, QList<Subscription> > m_subscriptions;
+        SerialHelper * m_serialHelper;
+    };
+}
+
+#endif // SUBSCRIPTIONMANAGER_H
@@ -0,0 +1,316 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+SupportedPids::SupportedPids()
+{
+    clear();
+}
+
+void SupportedPids::clear()
+{
+    /* Nothing is supported until the ECU says so */
+
+    for (int i = 0; i < RANGES; i++)
+        m_bitmaps[i] = 0;
+
+    m_known = 0;
+}
+
+bool SupportedPids::isKnown() const
+{
+    /* Every OBD II vehicle answers 0100, so until it has been asked nothing is known */
+    return hasRange(0x01, 0x00);
+}
+
+bool SupportedPids::isSupported(int mode, int pid) const
+{
+    /*
+        Check a single PID. The range PIDs themselves are in the bitmap of the range before, except 00 which
+        is supported by every vehicle that answered it
+    */
+
+    if (pid == 0)
+        return hasRange(mode, 0x00);
+
+    int index = rangeIndex(mode, (pid - 1) & ~0x1F);
+
+    if (index < 0)
+        return false;
+
+    return (m_bitmaps[index] >> (31 - ((pid - 1) & 0x1F))) & 1;
+}
+
+bool SupportedPids::isSupported(QString command) const
+{
+    /* Check the PID of a command, eg: "010D". Commands that aren't a mode and PID are never supported */
+
+    if (command.size() < 4)
+        return false;
+
+    bool modeOk;
+    bool pidOk;
+    int mode = command.mid(0, 2).toInt(&modeOk, 16);
+    int pid = command.mid(2, 2).toInt(&pidOk, 16);
+
+    return modeOk && pidOk && isSupported(mode, pid);
+}
+
+bool SupportedPids::hasRange(int mode, int base) const
+{
+    /* Was the range PID answered, or found not to be? */
+
+    int index = rangeIndex(mode, base);
+
+    return index >= 0 && (m_known & (1u << index));
+}
+
+quint32 SupportedPids::getRange(int mode, int base) const
+{
+    /* The bitmap the ECU answered the range PID with. The most significant bit is the first PID of the range */
+
+    int index = rangeIndex(mode, base);
+
+    return index < 0 ? 0 : m_bitmaps[index];
+}
+
+void SupportedPids::setRange(int mode, int base, quint32 bitmap)
+{
+    /* Several ECUs may answer the same range, so their bitmaps are combined */
+
+    int index = rangeIndex(mode, base);
+
+    if (index < 0)
+        return;
+
+    m_bitmaps[index] |= bitmap;
+    m_known |= 1u << index;
+}
+
+int SupportedPids::applyResponse(QString response)
+{
+    /*
+        Take the range bitmaps out of the answer to a range request. The answer can be a single range, eg:
+        "41 00 BE 1F A8 13", or several from a multi PID request. On CAN those come as a multi frame message:
+
+            01E
+            0: 41 00 BE 1F A8 13 20
+            1: 80 01 80 01 40 C0 00
+            ...
+
+        The first line is the length in bytes, each frame starts with its number. Every ECU that answers has
+        a message of its own. Returns the number of ranges found
+    */
+
+    QStringList lines = response.split("\x0D");
+    QStringList messages;
+    QList<int> lengths;
+    QRegExp hexLine("[0-9A-F]+");
+    QRegExp frameLine("[0-9A-F]:[0-9A-F]+");
+    int length = -1;
+
+    for (int i = 0; i < lines.size(); i++)
+    {
+        QString line = lines[i];
+        line.remove(' ');
+        line.remove('>');
+
+        if (frameLine.exactMatch(line))
+        {
+            /* Frame 0 starts a message, the frames after it carry on with it */
+            if (line.startsWith("0:") || messages.isEmpty())
+            {
+                messages.append(QString());
+                lengths.append(length);
+                length = -1;
+            }
+
+            messages.last() += line.mid(2);
+        }
+        else if (line.size() == 3 && hexLine.exactMatch(line))
+        {
+            /* Length of the multi frame message that follows, so the padding of its last frame can be dropped */
+            length = line.toInt(0, 16);
+        }
+        else if (hexLine.exactMatch(line))
+        {
+            messages.append(line);
+            lengths.append(-1);
+        }
+    }
+
+    int found = 0;
+
+    for (int m = 0; m < messages.size(); m++)
+    {
+        QByteArray bytes = QByteArray::fromHex(messages[m].toLatin1());
+
+        if (lengths[m] > 0 && bytes.size() > lengths[m])
+            bytes.truncate(lengths[m]);
+
+        if (bytes.size() < 6)
+            continue;
+
+        int mode = (unsigned char)bytes[0] - 0x40;
+
+        /* Every range answered is the PID followed by four bytes of bitmap */
+        for (int i = 1; i + 5 <= bytes.size(); i += 5)
+        {
+            int base = (unsigned char)bytes[i];
+
+            if (rangeIndex(mode, base) < 0)
+                break;
+
+            quint32 bitmap = ((quint32)(unsigned char)bytes[i + 1] << 24) | ((quint32)(unsigned char)bytes[i + 2] << 16) |
+                             ((quint32)(unsigned char)bytes[i + 3] << 8) | (quint32)(unsigned char)bytes[i + 4];
+
+            setRange(mode, base, bitmap);
+            found++;
+        }
+    }
+
+    return found;
+}
+
+void SupportedPids::markUnanswered(QString command)
+{
+    /* No ECU answered a single range request, eg: NO DATA. None of the range is supported */
+
+    bool modeOk;
+    bool baseOk;
+    int mode = command.mid(0, 2).toInt(&modeOk, 16);
+    int base = command.mid(2, 2).toInt(&baseOk, 16);
+
+    if (modeOk && baseOk)
+        setRange(mode, base, 0);
+}
+
+QString SupportedPids::nextRangeCommand() const
+{
+    /*
+        The next range request to send. Each mode 01 range is only asked for if the range before says it is
+        supported, so the chain stops at the first range the vehicle doesn't have. Mode 09 comes last. Empty
+        once everything is known
+    */
+
+    for (int base = 0x00; base < MODE01RANGES * 0x20; base += 0x20)
+    {
+        if (base > 0 && !isSupported(0x01, base))
+            break;
+
+        if (!hasRange(0x01, base))
+            return QString("01%1").arg(base, 2, 16, QChar('0')).toUpper();
+    }
+
+    if (!hasRange(0x09, 0x00))
+        return "0900";
+
+    return QString();
+}
+
+QString SupportedPids::toString() const
+{
+    /* The bitmaps as hex, one per range, with "-" for ranges that are not known. Used to store them */
+
+    QStringList ranges;
+
+    for (int i = 0; i < RANGES; i++)
+    {
+        if (m_known & (1u << i))
+            ranges << QString("%1").arg(m_bitmaps[i], 8, 16, QChar('0')).toUpper();
+        else
+            ranges << "-";
+    }
+
+    return ranges.join(",");
+}
+
+bool SupportedPids::fromString(QString text)
+{
+    /* Read back what toString() made. On anything unexpected nothing is known */
+
+    clear();
+
+    QStringList ranges = text.split(",");
+
+    if (ranges.size() != RANGES)
+        return false;
+
+    for (int i = 0; i < RANGES; i++)
+    {
+        if (ranges[i] == "-")
+            continue;
+
+        bool ok;
+        m_bitmaps[i] = ranges[i].toUInt(&ok, 16);
+
+        if (!ok)
+        {
+            clear();
+            return false;
+        }
+
+        m_known |= 1u << i;
+    }
+
+    return true;
+}
+
+QStringList SupportedPids::batchedRangeCommands()
+{
+    /* All the mode 01 ranges in as few multi PID requests as the ECU takes, see PidBatcher::MAXPIDS */
+    QStringList commands;
+    commands << "010020406080A0" << "01C0E0";
+
+    return commands;
+}
+
+int SupportedPids::rangeIndex(int mode, int base)
+{
+    /* Where a range is kept, -1 if it isn't a range PID this class knows about */
+
+    if (base < 0 || (base & 0x1F) != 0)
+        return -1;
+
+    if (mode == 0x01 && base < MODE01RANGES * 0x20)
+        return base / 0x20;
+
+    if (mode == 0x09 && base < MODE09RANGES * 0x20)
+        return MODE01RANGES + base / 0x20;
+
+    return -1;
+}
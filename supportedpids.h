@@ -0,0 +1,78 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef SUPPORTEDPIDS_H
+#define SUPPORTEDPIDS_H
+
+#include <QString>
+#include <QStringList>
+
+namespace AutomonKernel
+{
+    /*
+        SupportedPids holds which PIDs the vehicle supports, as the bitmaps the ECU answers the range PIDs with.
+        0100 covers PIDs 01 to 20, 0120 covers 21 to 40 and so on up to 01E0. The last PID of each range says
+        if the next range is supported. Mode 09 has its own range, 0900. Looking up a PID is a shift and a
+        mask, so the sensors and the user interface can ask as often as they like.
+    */
+
+    class SupportedPids
+    {
+    public:
+        enum { MODE01RANGES = 8, MODE09RANGES = 1, RANGES = MODE01RANGES + MODE09RANGES };
+
+        SupportedPids();
+        void clear();
+        bool isKnown() const;
+        bool isSupported(int mode, int pid) const;
+        bool isSupported(QString command) const;
+        bool hasRange(int mode, int base) const;
+        quint32 getRange(int mode, int base) const;
+        void setRange(int mode, int base, quint32 bitmap);
+        int applyResponse(QString response);
+        void markUnanswered(QString command);
+        QString nextRangeCommand() const;
+        QString toString() const;
+        bool fromString(QString text);
+        static QStringList batchedRangeCommands();
+
+    private:
+        static int rangeIndex(int mode, int base);
+
+        quint32 m_bitmaps[RANGES];
+        quint32 m_known; /* Bit n is set once range n was answered, or found not to be */
+    };
+}
+
+#endif // SUPPORTEDPIDS_H
@@ -0,0 +1,106 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+TableSensor::TableSensor(const PidDescriptor & descriptor)
+    : m_descriptor(&descriptor)
+{
+    /* Set properties of this sensor from the table */
+    m_command = QString("01%1").arg(descriptor.pid, 2, 16, QChar('0')).toUpper();
+    m_englishMeaning = descriptor.name;
+    setUnits(descriptor.units);
+    setExpectedBytes(descriptor.bytes);
+    setMin(descriptor.min);
+    setMax(descriptor.max);
+
+    m_channel = NULL;
+    m_channelValue = 0;
+    m_channelDecoded = false;
+
+    if (descriptor.second.decode)
+    {
+        m_channel = new SensorChannel(this, 1, descriptor.second.name);
+        m_channel->setUnits(descriptor.second.units);
+        m_channel->setExpectedBytes(descriptor.bytes);
+        m_channel->setMin(descriptor.second.min);
+        m_channel->setMax(descriptor.second.max);
+    }
+}
+
+double TableSensor::convertResult()
+{
+    /* Run the PID's decode kernel on the data bytes, which start after the mode and PID */
+
+    HexDecoder bytes(getBuffer());
+
+    /* A short answer would decode as zeros. Keep the last value instead */
+    m_channelDecoded = bytes.size() >= 2 + m_descriptor->bytes;
+
+    if (!m_channelDecoded)
+        return m_result;
+
+    /* The second channel comes out of the same bytes, it's handed over in setResult() */
+    if (m_channel)
+        m_channelValue = m_descriptor->second.decode(bytes.data() + 2);
+
+    return m_descriptor->decode(bytes.data() + 2);
+}
+
+void TableSensor::setResult()
+{
+    /* Convert and signal our own value as usual, then the channel's */
+
+    Sensor::setResult();
+
+    if (m_channel && m_channelDecoded)
+        m_channel->setValue(m_channelValue);
+}
+
+QList<Sensor*> TableSensor::getChannels() const
+{
+    QList<Sensor*> channels;
+
+    if (m_channel)
+        channels.append(m_channel);
+
+    return channels;
+}
+
+const PidDescriptor & TableSensor::getDescriptor() const
+{
+    return *m_descriptor;
+}
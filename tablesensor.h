@@ -30,20 +30,40 @@
     
 */
 
-#ifndef FUELLEVELINPUTSENSOR_H
-#define FUELLEVELINPUTSENSOR_H
+
+
+#ifndef TABLESENSOR_H
+#define TABLESENSOR_H
 
 #include "sensor.h"
+#include "pidtable.h"
+#include "sensorchannel.h"
 
 namespace AutomonKernel
 {
-    class FuelLevelInput : public Sensor
+    /*
+        A TableSensor is a mode 01 sensor described by an entry of the PidTable. Its conversion formula is the
+        entry's decode kernel, so every PID in the table is a sensor without a class of its own. If the entry
+        has a second channel, both values are decoded from the one answer and the second is handed to a
+        SensorChannel. The channel goes in the sensor list with the other sensors, which owns it from then.
+    */
+
+    class TableSensor : public Sensor
     {
     public:
-        FuelLevelInput(QString command, QString englishMeaning);
-        FuelLevelInput();
+        TableSensor(const PidDescriptor & descriptor);
+        ~TableSensor() { }
         double convertResult();
-        ~FuelLevelInput() { }
+        void setResult();
+        QList<Sensor*> getChannels() const;
+        const PidDescriptor & getDescriptor() const;
+
+    private:
+        const PidDescriptor * m_descriptor;
+        SensorChannel * m_channel;
+        double m_channelValue;
+        bool m_channelDecoded;
     };
 }
-#endif // FUELLEVELINPUTSENSOR_H
+
+#endif // TABLESENSOR_H
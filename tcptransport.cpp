@@ -0,0 +1,214 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+using namespace AutomonKernel;
+
+TcpTransport::TcpTransport(QString host, int port, int connectTimeout)
+    : m_host(host), m_port(port), m_connectTimeout(connectTimeout)
+{
+    m_socket = -1;
+}
+
+TcpTransport::~TcpTransport()
+{
+    close();
+}
+
+QString TcpTransport::getUri() const
+{
+    return QString("tcp://%1:%2").arg(m_host).arg(m_port);
+}
+
+int TcpTransport::descriptor() const
+{
+    return m_socket;
+}
+
+bool TcpTransport::isOpen() const
+{
+    return m_socket >= 0;
+}
+
+#ifdef Q_OS_UNIX
+
+bool TcpTransport::open()
+{
+    /*
+        Resolve the host and connect, giving up after the connect timeout. The socket is left non blocking
+        so reads return straight away when nothing has arrived
+    */
+
+    close();
+
+    struct addrinfo hints;
+    struct addrinfo * addresses = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(m_host.toLatin1().constData(), QString::number(m_port).toLatin1().constData(), &hints, &addresses) != 0)
+        return false;
+
+    for (struct addrinfo * address = addresses; address != NULL && m_socket < 0; address = address->ai_next)
+    {
+        m_socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+        if (m_socket < 0)
+            continue;
+
+        fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK);
+
+        if (::connect(m_socket, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            /* The connect is in progress. Wait for it to finish, then check it worked */
+            struct pollfd connecting;
+            connecting.fd = m_socket;
+            connecting.events = POLLOUT;
+
+            int error = 0;
+            socklen_t length = sizeof(error);
+
+            if (errno != EINPROGRESS || poll(&connecting, 1, m_connectTimeout) != 1 ||
+                getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0)
+            {
+                ::close(m_socket);
+                m_socket = -1;
+            }
+        }
+    }
+
+    freeaddrinfo(addresses);
+
+    if (m_socket < 0)
+        return false;
+
+    int noDelay = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+#ifdef DEBUGAUTOMON
+    qDebug() << "Connected to" << getUri();
+#endif
+
+    return true;
+}
+
+void TcpTransport::close()
+{
+    if (m_socket >= 0)
+        ::close(m_socket);
+
+    m_socket = -1;
+}
+
+qint64 TcpTransport::bytesAvailable()
+{
+    int bytes = 0;
+
+    if (m_socket < 0 || ioctl(m_socket, FIONREAD, &bytes) != 0)
+        return 0;
+
+    return bytes;
+}
+
+qint64 TcpTransport::read(char * data, qint64 maxSize)
+{
+    /* Non blocking read. 0 if nothing is waiting, -1 if the adapter closed the connection */
+    ssize_t bytes = ::recv(m_socket, data, maxSize, 0);
+
+    if (bytes == 0)
+        return -1;
+
+    if (bytes < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+    return bytes;
+}
+
+qint64 TcpTransport::write(const char * data, qint64 size)
+{
+    /* MSG_NOSIGNAL so a dropped connection is an error return, not a SIGPIPE */
+    ssize_t bytes = ::send(m_socket, data, size, MSG_NOSIGNAL);
+
+    if (bytes < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+    return bytes;
+}
+
+#else
+
+bool TcpTransport::open()
+{
+    /* Only implemented with BSD sockets for now */
+    return false;
+}
+
+void TcpTransport::close()
+{
+}
+
+qint64 TcpTransport::bytesAvailable()
+{
+    return 0;
+}
+
+qint64 TcpTransport::read(char * data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 TcpTransport::write(const char * data, qint64 size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef TCPTRANSPORT_H
+#define TCPTRANSPORT_H
+
+#include <QString>
+
+#include "transport.h"
+
+namespace AutomonKernel
+{
+    /*
+        The TcpTransport talks to the WiFi ELM327 clones, which accept one TCP connection on port 35000 and then
+        behave exactly like the serial adapter. Nagle is turned off since every request is a handful of bytes
+        and we wait on the answer before sending the next one.
+    */
+
+    class TcpTransport : public Transport
+    {
+    public:
+        TcpTransport(QString host, int port = 35000, int connectTimeout = 5000);
+        ~TcpTransport();
+        bool open();
+        void close();
+        bool isOpen() const;
+        int descriptor() const;
+        qint64 bytesAvailable();
+        qint64 read(char * data, qint64 maxSize);
+        qint64 write(const char * data, qint64 size);
+        QString getUri() const;
+
+    private:
+        QString m_host;
+        int m_port;
+        int m_connectTimeout;
+        int m_socket;
+    };
+}
+
+#endif // TCPTRANSPORT_H
@@ -0,0 +1,160 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+const char * const TimeoutTuner::BATCHREQUEST = "01 batch";
+
+TimeoutTuner::TimeoutTuner()
+{
+    /* Start off with the ELM327 defaults until we have measured something */
+    elmReset();
+}
+
+void TimeoutTuner::elmReset()
+{
+    /* The ELM327 was reset (ATZ, ATD, ATWS), which puts its timeout back to the default */
+    m_sentUnits = DEFAULTELMUNITS;
+    m_elmTimeout = DEFAULTELMUNITS * 4096 / 1000;
+}
+
+void TimeoutTuner::record(const QString & request, int milliseconds, Outcome outcome)
+{
+    /*
+        Record how long a request took and how it ended. NO DATA only counts against the ELM327 timeout if the
+        request was answered before, otherwise it is just a PID the ECU doesn't have. Failed requests say
+        nothing about how fast the ECU is and aren't recorded
+    */
+
+    if (outcome == Failed)
+        return;
+
+    LatencyHistogram & histogram = m_histograms[request];
+    bool answeredBefore = histogram.getCount() > histogram.getMisses();
+
+    if (outcome == Answered)
+    {
+        histogram.record(milliseconds);
+        m_overall.record(milliseconds);
+    }
+    else
+    {
+        histogram.recordMiss();
+
+        if (outcome == NoData && answeredBefore)
+            m_overall.recordMiss();
+    }
+
+    if (m_overall.getCount() < MINSAMPLES)
+        return;
+
+    /* Give the ECU half as long again as the 99th percentile. Too many misses and we go to the maximum */
+    int p99 = m_overall.percentile(0.99);
+
+    m_elmTimeout = (p99 < 0) ? (int)MAXELMTIMEOUT : qBound((int)MINELMTIMEOUT, p99 * 3 / 2, (int)MAXELMTIMEOUT);
+}
+
+int TimeoutTuner::getReadTimeout(const QString & request) const
+{
+    /*
+        How long to wait for the answer to a request. Never shorter than the ELM327 timeout plus a margin,
+        otherwise we would give up before the adapter says NO DATA
+    */
+
+    int floor = m_sentUnits * 4096 / 1000 + READMARGIN;
+
+    LatencyHistogram histogram = m_histograms.value(request);
+
+    if (histogram.getCount() < MINSAMPLES)
+        return DEFAULTTIMEOUT;
+
+    int p99 = histogram.percentile(0.99);
+
+    if (p99 < 0)
+        return DEFAULTTIMEOUT;
+
+    return qBound(floor, p99 * 2 + READMARGIN, (int)DEFAULTTIMEOUT);
+}
+
+int TimeoutTuner::getElmTimeout() const
+{
+    /* The ELM327 timeout in ms we would like to have */
+    return m_elmTimeout;
+}
+
+bool TimeoutTuner::takeElmTimeoutChange(int & units)
+{
+    /*
+        Returns true if the ELM327 timeout should be changed, with the ATST value to send in units. The value
+        only changes by at least an eighth, so we don't send ATST every round for the odd slow answer
+    */
+
+    if (m_overall.getCount() < MINSAMPLES)
+        return false;
+
+    int wanted = qBound(1, (m_elmTimeout * 1000 + 4095) / 4096, 0xFF);
+
+    if (qAbs(wanted - m_sentUnits) < qMax(2, m_sentUnits / 8))
+        return false;
+
+    units = m_sentUnits = wanted;
+    return true;
+}
+
+TimeoutTuner::Outcome TimeoutTuner::classify(bool complete, ResponseClassifier::Status status)
+{
+    /*
+        Work out how a request ended from whether the prompt arrived and what the ELM327 said. Only data is an
+        answer. Bus and CAN errors, a search for the protocol and the like took as long as they took for other
+        reasons than the ECU, so their latency would only skew the percentiles
+    */
+
+    if (!complete)
+        return TimedOut;
+
+    if (status == ResponseClassifier::Ok)
+        return Answered;
+
+    if (status == ResponseClassifier::NoData)
+        return NoData;
+
+    return Failed;
+}
+
+const LatencyHistogram & TimeoutTuner::getOverall() const
+{
+    /* The latency of all answered requests together */
+    return m_overall;
+}
@@ -0,0 +1,90 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef TIMEOUTTUNER_H
+#define TIMEOUTTUNER_H
+
+#include <QHash>
+#include <QString>
+
+#include "latencyhistogram.h"
+#include "responseclassifier.h"
+
+namespace AutomonKernel
+{
+    /*
+        The TimeoutTuner keeps a latency histogram for every request the serial thread polls and works out two
+        timeouts from them. The ELM327 timeout (ATST) is how long the adapter waits for the ECU before it gives up
+        with NO DATA. It is set from a high percentile of all answered requests. The read timeout is how long the
+        serial thread waits for the prompt character, worked out per request. Misses push the percentiles up, so
+        both timeouts widen again when they were too tight. A PID that never answers doesn't widen the ELM327
+        timeout, so it can't stall every other read.
+
+        Multi PID requests all share one histogram, BATCHREQUEST, since each mix of PIDs is a different request.
+    */
+
+    class TimeoutTuner
+    {
+    public:
+        enum Outcome { Answered, NoData, TimedOut, Failed };
+
+        TimeoutTuner();
+        void record(const QString & request, int milliseconds, Outcome outcome);
+        int getReadTimeout(const QString & request) const;
+        int getElmTimeout() const;
+        bool takeElmTimeoutChange(int & units);
+        void elmReset();
+        const LatencyHistogram & getOverall() const;
+        static Outcome classify(bool complete, ResponseClassifier::Status status);
+
+        static const char * const BATCHREQUEST;
+
+        enum
+        {
+            DEFAULTTIMEOUT = 2500,  /* Read timeout in ms until a request has enough samples */
+            MINSAMPLES = 20,        /* Samples needed before the percentiles are trusted */
+            MINELMTIMEOUT = 40,     /* Shortest ELM327 timeout in ms we set */
+            MAXELMTIMEOUT = 1000,   /* Longest ELM327 timeout in ms we set, the adapter allows up to ~1s */
+            DEFAULTELMUNITS = 0x32, /* ATST value after a reset, 200ms */
+            READMARGIN = 150        /* Time in ms for the response to reach us after the ELM327 timeout */
+        };
+
+    private:
+        QHash<QString, LatencyHistogram> m_histograms;
+        LatencyHistogram m_overall;
+        int m_elmTimeout;
+        int m_sentUnits;
+    };
+}
+
+#endif // TIMEOUTTUNER_H
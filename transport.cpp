@@ -0,0 +1,100 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#include "automon.h"
+
+using namespace AutomonKernel;
+
+void Transport::discardInput()
+{
+    /* Read and throw away whatever is waiting. Transports with a quicker way override this */
+    char rubbish[256];
+
+    while (read(rubbish, sizeof(rubbish)) > 0)
+        ;
+}
+
+bool Transport::setBaudRate(int baudRate)
+{
+    /* Only serial ports have a baud rate. Everything else is as fast as it is */
+    Q_UNUSED(baudRate);
+    return false;
+}
+
+int Transport::getBaudRate() const
+{
+    /* 0 means the transport has no baud rate to change */
+    return 0;
+}
+
+Transport * Transport::create(QString uri)
+{
+    /*
+        Create the transport the URI asks for. Anything without a scheme is taken to be a serial port,
+        which is what Automon was always given. The caller owns the returned transport.
+    */
+
+    if (uri.startsWith("tcp://"))
+    {
+        /* tcp://host:port. The WiFi ELM327 clones listen on port 35000 */
+        QString address = uri.mid(6);
+        int colon = address.lastIndexOf(':');
+
+        if (colon == -1)
+            return new TcpTransport(address, 35000);
+
+        return new TcpTransport(address.left(colon), address.mid(colon + 1).toInt());
+    }
+
+    if (uri.startsWith("pty://"))
+        return new PtyTransport(uri.mid(6));
+
+    if (uri.startsWith("replay://"))
+        return new ReplayTransport(uri.mid(9));
+
+    if (uri.startsWith("serial://"))
+    {
+        /* serial:///dev/ttyUSB0, optionally with ?baud=115200 for adapters not on the usual 38400 */
+        QString path = uri.mid(9).section('?', 0, 0);
+        QString options = uri.section('?', 1);
+        int baudRate = 38400;
+
+        if (options.startsWith("baud="))
+            baudRate = options.mid(5).toInt();
+
+        return new SerialTransport(path, true, baudRate);
+    }
+
+    /* A plain port name. Find the port the adapter is really on, it may well be another one */
+    return create(AdapterDiscovery::findAdapter(uri));
+}
@@ -0,0 +1,76 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QString>
+
+namespace AutomonKernel
+{
+    /*
+        A Transport is the byte pipe between Automon and the ELM327. The serial helper only talks to this
+        interface, so the polling, batching and parsing are the same whether the adapter is on a serial port,
+        a WiFi clone on TCP port 35000, an emulator on a pseudo terminal or a recorded session being replayed.
+
+        Reads never block. Transports that have a file descriptor hand it out with descriptor() so the serial
+        reactor can sleep on it. Transports are created from a URI:
+
+            /dev/ttyUSB0                            Any port, the adapter is searched for, see AdapterDiscovery
+            serial:///dev/ttyUSB0?baud=115200       That serial port, at 38400 baud unless given
+            tcp://192.168.0.10:35000                ELM327 WiFi clone
+            pty:///dev/pts/4                        Pseudo terminal, eg: the ELM327 emulator
+            replay:///home/user/session.log         Recorded session played back
+    */
+
+    class Transport
+    {
+    public:
+        virtual ~Transport() {}
+        virtual bool open() = 0;
+        virtual void close() = 0;
+        virtual bool isOpen() const = 0;
+        virtual int descriptor() const = 0;
+        virtual qint64 bytesAvailable() = 0;
+        virtual qint64 read(char * data, qint64 maxSize) = 0;
+        virtual qint64 write(const char * data, qint64 size) = 0;
+        virtual void discardInput();
+        virtual bool setBaudRate(int baudRate);
+        virtual int getBaudRate() const;
+        virtual QString getUri() const = 0;
+
+        static Transport * create(QString uri);
+    };
+}
+
+#endif // TRANSPORT_H
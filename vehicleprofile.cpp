@@ -0,0 +1,229 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#include "automon.h"
+
+#include <QSettings>
+
+using namespace AutomonKernel;
+
+VehicleProfile::VehicleProfile()
+{
+    /* Nothing is known until a profile is loaded or learned */
+}
+
+bool VehicleProfile::load(QString adapter)
+{
+    /*
+        Load the profile of the last vehicle seen through this adapter. Returns false if there is none, or if
+        it is missing the protocol, in which case it is no use for skipping the discovery queries
+    */
+
+    clear();
+    m_adapter = adapter;
+
+    QSettings settings("Automon", "Automon");
+    settings.beginGroup(adapterGroup());
+
+    m_vin = settings.value("LastVin").toString();
+
+    if (m_vin.isEmpty())
+        return false;
+
+    settings.beginGroup(m_vin);
+
+    m_protocolNumber = settings.value("ProtocolNumber").toString();
+    m_protocol = settings.value("Protocol").toString();
+    m_standardType = settings.value("StandardType").toString();
+    m_elmVersion = settings.value("ElmVersion").toString();
+    m_supportedPids.fromString(settings.value("SupportedPids").toString());
+
+    settings.endGroup();
+    settings.endGroup();
+
+    return isValid();
+}
+
+void VehicleProfile::save() const
+{
+    /* Store the profile under the adapter and VIN, and make it the adapter's last vehicle */
+
+    if (!isValid())
+        return;
+
+    QSettings settings("Automon", "Automon");
+    settings.beginGroup(adapterGroup());
+    settings.setValue("LastVin", m_vin);
+
+    settings.beginGroup(m_vin);
+    settings.remove("");
+    settings.setValue("ProtocolNumber", m_protocolNumber);
+    settings.setValue("Protocol", m_protocol);
+    settings.setValue("StandardType", m_standardType);
+    settings.setValue("ElmVersion", m_elmVersion);
+    settings.setValue("SupportedPids", m_supportedPids.toString());
+
+    settings.endGroup();
+    settings.endGroup();
+}
+
+void VehicleProfile::forget()
+{
+    /* Remove the stored profile, eg: when it turned out to be for another vehicle, and clear this one */
+
+    if (!m_adapter.isEmpty() && !m_vin.isEmpty())
+    {
+        QSettings settings("Automon", "Automon");
+        settings.beginGroup(adapterGroup());
+        settings.remove("LastVin");
+        settings.remove(m_vin);
+        settings.endGroup();
+    }
+
+    clear();
+}
+
+void VehicleProfile::clear()
+{
+    /* Forget everything but the adapter */
+
+    m_vin.clear();
+    m_protocolNumber.clear();
+    m_protocol.clear();
+    m_standardType.clear();
+    m_elmVersion.clear();
+    m_supportedPids.clear();
+}
+
+bool VehicleProfile::isValid() const
+{
+    /* A profile is only worth anything with a VIN to check it against and a protocol to force */
+    return !m_adapter.isEmpty() && !m_vin.isEmpty() && !m_protocolNumber.isEmpty();
+}
+
+void VehicleProfile::setAdapter(QString adapter)
+{
+    m_adapter = adapter;
+}
+
+QString VehicleProfile::getVin() const
+{
+    return m_vin;
+}
+
+void VehicleProfile::setVin(QString vin)
+{
+    m_vin = vin;
+}
+
+QString VehicleProfile::getProtocolNumber() const
+{
+    return m_protocolNumber;
+}
+
+void VehicleProfile::setProtocolNumber(QString protocolNumber)
+{
+    m_protocolNumber = protocolNumber;
+}
+
+QString VehicleProfile::getProtocol() const
+{
+    return m_protocol;
+}
+
+void VehicleProfile::setProtocol(QString protocol)
+{
+    m_protocol = protocol;
+}
+
+QString VehicleProfile::getStandardType() const
+{
+    return m_standardType;
+}
+
+void VehicleProfile::setStandardType(QString standardType)
+{
+    m_standardType = standardType;
+}
+
+QString VehicleProfile::getElmVersion() const
+{
+    return m_elmVersion;
+}
+
+void VehicleProfile::setElmVersion(QString elmVersion)
+{
+    m_elmVersion = elmVersion;
+}
+
+SupportedPids VehicleProfile::getSupportedPids() const
+{
+    /* Nothing is known in it if the vehicle's support wasn't learned yet */
+    return m_supportedPids;
+}
+
+void VehicleProfile::setSupportedPids(const SupportedPids & supportedPids)
+{
+    m_supportedPids = supportedPids;
+}
+
+QString VehicleProfile::parseProtocolNumber(QString response)
+{
+    /*
+        Get the protocol number from the answer to ATDPN, eg: "A6" or "6". The A only says the ELM327 found
+        the protocol by searching, ATSP wants the number on its own. Empty if the answer makes no sense
+    */
+
+    response = response.trimmed();
+    response.remove('>');
+    response = response.trimmed();
+
+    if (response.startsWith("A"))
+        response = response.mid(1);
+
+    if (response.size() != 1 || !QRegExp("[1-9A-C]").exactMatch(response))
+        return QString();
+
+    return response;
+}
+
+QString VehicleProfile::adapterGroup() const
+{
+    /* The adapter is a transport URI. QSettings keys can't have slashes, so keep letters and digits only */
+
+    QString key = m_adapter;
+    key.replace(QRegExp("[^A-Za-z0-9]"), "_");
+
+    return "Vehicles/" + key;
+}
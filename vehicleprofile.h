@@ -0,0 +1,90 @@
+/*
+
+    This file is part of the Automon Project (OBD Diagnostics) - http://www.automon.io/
+    Source Repository: https://github.com/donaloconnor/automon/
+    
+    Copyright (c) 2015, Donal O'Connor <donaloconnor@gmail.com>
+
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+    
+*/
+
+
+
+#ifndef VEHICLEPROFILE_H
+#define VEHICLEPROFILE_H
+
+#include <QString>
+
+#include "supportedpids.h"
+
+namespace AutomonKernel
+{
+    /*
+        A VehicleProfile holds what Automon learns about a vehicle that doesn't change between drives: the
+        protocol number, the protocol and standard names, the ELM327 version, the VIN and the supported PIDs. It is stored under the adapter and the VIN, and the adapter remembers the last vehicle it
+        was connected to, so the next start can force the protocol with ATSP and skip all the discovery
+        queries. Automon checks the profile in the background afterwards, in case it's a different vehicle.
+
+        The response counts are kept per VIN by ResponseCounts and are not repeated here.
+    */
+
+    class VehicleProfile
+    {
+    public:
+        VehicleProfile();
+        bool load(QString adapter);
+        void save() const;
+        void forget();
+        void clear();
+        bool isValid() const;
+        void setAdapter(QString adapter);
+        QString getVin() const;
+        void setVin(QString vin);
+        QString getProtocolNumber() const;
+        void setProtocolNumber(QString protocolNumber);
+        QString getProtocol() const;
+        void setProtocol(QString protocol);
+        QString getStandardType() const;
+        void setStandardType(QString standardType);
+        QString getElmVersion() const;
+        void setElmVersion(QString elmVersion);
+        SupportedPids getSupportedPids() const;
+        void setSupportedPids(const SupportedPids & supportedPids);
+        static QString parseProtocolNumber(QString response);
+
+    private:
+        QString adapterGroup() const;
+
+        QString m_adapter;
+        QString m_vin;
+        QString m_protocolNumber;
+        QString m_protocol;
+        QString m_standardType;
+        QString m_elmVersion;
+        SupportedPids m_supportedPids;
+    };
+}
+
+#endif // VEHICLEPROFILE_H